@@ -0,0 +1,232 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "print.h"
+
+// records which file ranges are read during startup, so the next startup can have them read ahead in the background.
+// a pack shows up as ranges of the pack file, a loose file as a range over the whole file.
+namespace io {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	struct access_record {
+		// milliseconds since the trace was started
+		double time = 0.0;
+
+		// the file on disk that was read, and the range of it
+		std::string path;
+		std::uint64_t offset = 0llu;
+		std::uint64_t length = 0llu;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		std::atomic<bool> recording_accesses = false;
+		std::chrono::steady_clock::time_point trace_start;
+
+		std::vector<access_record> accesses;
+		std::mutex accesses_mutex;
+	}
+	// ============================================================================================================================
+
+	// starts recording the file accesses of the file layer
+	void start_access_trace() {
+		std::lock_guard lock(data::accesses_mutex);
+
+		data::accesses.clear();
+		data::trace_start = std::chrono::steady_clock::now();
+		data::recording_accesses = true;
+	}
+
+	// records a read of 'length' bytes at 'offset' of the file at 'path', does nothing while no trace is recorded
+	void record_access(std::string_view path, std::uint64_t offset, std::uint64_t length) {
+
+		if (!data::recording_accesses) {
+			return;
+		}
+
+		std::lock_guard lock(data::accesses_mutex);
+
+		auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - data::trace_start);
+		data::accesses.push_back({ elapsed.count(), std::string(path), offset, length });
+	}
+
+	// stops recording and writes the trace to 'trace_path', one access per line: time, offset, length and path.
+	// a range that was read more than once is only written the first time.
+	bool save_access_trace(const char* trace_path) {
+
+		std::vector<access_record> accesses;
+		{
+			std::lock_guard lock(data::accesses_mutex);
+			data::recording_accesses = false;
+			accesses = std::move(data::accesses);
+			data::accesses.clear();
+		}
+
+		std::ofstream output(trace_path, std::ios::trunc);
+		if (!output) {
+			print_error("save_access_trace could not create: ", trace_path);
+			return false;
+		}
+
+		std::unordered_set<std::string> written;
+
+		for (const auto& access : accesses) {
+			std::string range = std::to_string(access.offset) + '\t' + std::to_string(access.length) + '\t' + access.path;
+
+			if (written.insert(range).second) {
+				output << access.time << '\t' << range << '\n';
+			}
+		}
+
+		print_info("Saved ", written.size(), " file accesses to ", trace_path);
+		return static_cast<bool>(output);
+	}
+
+	// reads a trace written by 'save_access_trace', returns false when there is none
+	bool load_access_trace(const char* trace_path, std::vector<access_record>& output) {
+
+		std::ifstream input(trace_path);
+		if (!input) {
+			return false;
+		}
+
+		output.clear();
+
+		std::string line;
+		while (std::getline(input, line)) {
+			std::istringstream fields(line);
+			access_record record;
+
+			if (!(fields >> record.time >> record.offset >> record.length)) {
+				continue;
+			}
+
+			// the path is the rest of the line after the tab, it may contain spaces
+			fields.get();
+			std::getline(fields, record.path);
+
+			if (!record.path.empty()) {
+				output.push_back(std::move(record));
+			}
+		}
+
+		return true;
+	}
+
+	// asks the OS to read a file range into the page cache without waiting for it
+	void read_ahead(const access_record& record) {
+#ifdef _WIN32
+		// there is no readahead hint for files, so the range is read once into a scratch buffer
+		HANDLE file = CreateFileA(record.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+
+		std::vector<char> scratch(1llu << 20);
+
+		std::uint64_t offset = record.offset;
+		std::uint64_t end = record.offset + record.length;
+
+		while (offset < end) {
+			OVERLAPPED position{};
+			position.Offset = static_cast<DWORD>(offset);
+			position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+			DWORD read = 0;
+			DWORD piece = static_cast<DWORD>(std::min<std::uint64_t>(end - offset, scratch.size()));
+
+			if (!ReadFile(file, scratch.data(), piece, &read, &position) || read == 0) {
+				break;
+			}
+
+			offset += read;
+		}
+
+		CloseHandle(file);
+#else
+		int descriptor = ::open(record.path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (descriptor < 0) {
+			return;
+		}
+
+		posix_fadvise(descriptor, static_cast<off_t>(record.offset), static_cast<off_t>(record.length), POSIX_FADV_WILLNEED);
+		::close(descriptor);
+#endif
+	}
+
+	// reads the ranges of a recorded trace ahead on a background thread, in the order they were accessed.
+	// it only warms the page cache, so nothing breaks when the files changed since the trace was recorded.
+	struct prefetcher {
+
+		prefetcher() = default;
+		prefetcher(const prefetcher&) = delete;
+		prefetcher& operator=(const prefetcher&) = delete;
+
+		~prefetcher() {
+			stop();
+		}
+
+		// starts reading ahead what 'trace_path' recorded, returns false when there is no trace yet
+		bool start(const char* trace_path) {
+
+			stop();
+
+			std::vector<access_record> accesses;
+			if (!load_access_trace(trace_path, accesses) || accesses.empty()) {
+				return false;
+			}
+
+			stopping_ = false;
+			thread_ = std::thread([this, accesses = std::move(accesses)]() {
+				for (const auto& access : accesses) {
+					if (stopping_) {
+						return;
+					}
+
+					read_ahead(access);
+				}
+			});
+
+			return true;
+		}
+
+		// stops after the range that is being read and waits for the thread to end
+		void stop() {
+			stopping_ = true;
+
+			if (thread_.joinable()) {
+				thread_.join();
+			}
+		}
+
+	private:
+		std::thread thread_;
+		std::atomic<bool> stopping_ = false;
+	};
+}
\ No newline at end of file
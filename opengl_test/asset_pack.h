@@ -0,0 +1,317 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "print.h"
+#include "mapped_file.h"
+#include "lz.h"
+
+// a single file that holds many assets.
+// layout: a header, the blobs of every file, a table of contents sorted by the hash of the file names and the names.
+// every blob starts at a multiple of 'pack_alignment' bytes so it can be handed out straight from the mapped file.
+namespace io {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	constexpr char pack_magic[4] = { 'A', 'P', 'A', 'K' };
+	constexpr std::uint32_t pack_version = 1u;
+	constexpr std::size_t pack_alignment = 64llu;
+
+	enum pack_compression : std::uint8_t {
+		compression_none = 0,
+		compression_lz = 1
+	};
+
+	struct pack_header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t entry_count;
+		std::uint32_t alignment;
+		std::uint64_t table_offset;
+		std::uint64_t names_offset;
+	};
+
+	struct pack_entry {
+		// hash of the name, the table is sorted by it
+		std::uint64_t hash;
+
+		// where the blob starts in the pack, and how many bytes it takes there
+		std::uint64_t offset;
+		std::uint64_t stored_size;
+
+		// the size of the file once decompressed
+		std::uint64_t size;
+
+		std::uint32_t name_offset;
+		std::uint16_t name_length;
+		std::uint8_t compression;
+		std::uint8_t padding;
+	};
+
+	static_assert(sizeof(pack_header) == 32llu && sizeof(pack_entry) == 40llu, "the pack layout must not depend on the compiler");
+
+	// returns the name a file is stored and looked up under, so "a/./b.obj" and "a\\b.obj" find the same file
+	std::string file_key(std::string_view path) {
+		return std::filesystem::path(path).lexically_normal().generic_string();
+	}
+
+	// FNV-1a, only used to order and find the table of contents
+	std::uint64_t hash_key(std::string_view key) {
+		std::uint64_t hash = 14695981039346656037ull;
+
+		for (char c : key) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	// ============================================================================================================================
+
+	// a pack opened for reading.
+	// the pack is mapped once, uncompressed files are views into the mapping.
+	struct asset_pack {
+
+		// maps the pack at 'path' and checks its table of contents
+		bool open(const char* path) {
+
+			auto file = std::make_shared<mapped_file>();
+			if (!file->open(path)) {
+				return false;
+			}
+
+			pack_header header;
+			if (file->size() < sizeof(header)) {
+				print_error("asset_pack too small to be a pack: ", path);
+				return false;
+			}
+
+			std::memcpy(&header, file->data(), sizeof(header));
+
+			if (std::memcmp(header.magic, pack_magic, sizeof(pack_magic)) != 0 || header.version != pack_version) {
+				print_error("asset_pack not a pack or of an unsupported version: ", path);
+				return false;
+			}
+
+			std::uint64_t table_size = std::uint64_t(header.entry_count) * sizeof(pack_entry);
+
+			if (header.table_offset > file->size() || table_size > file->size() - header.table_offset || header.names_offset > file->size()) {
+				print_error("asset_pack truncated table of contents: ", path);
+				return false;
+			}
+
+			entries_.resize(header.entry_count);
+			std::memcpy(entries_.data(), file->data() + header.table_offset, table_size);
+
+			names_ = std::string_view(file->data() + header.names_offset, file->size() - header.names_offset);
+
+			for (const auto& entry : entries_) {
+				bool in_bounds = entry.offset <= file->size()
+					&& entry.stored_size <= file->size() - entry.offset
+					&& std::uint64_t(entry.name_offset) + entry.name_length <= names_.size()
+					&& entry.compression <= compression_lz;
+
+				if (!in_bounds) {
+					print_error("asset_pack corrupt table of contents: ", path);
+					entries_.clear();
+					return false;
+				}
+			}
+
+			file_ = std::move(file);
+			path_ = path;
+			return true;
+		}
+
+		// returns the entry of the file stored under 'key', or nullptr when the pack has no such file
+		const pack_entry* find(std::string_view key) const {
+
+			std::uint64_t hash = hash_key(key);
+
+			auto it = std::lower_bound(entries_.begin(), entries_.end(), hash, [](const pack_entry& entry, std::uint64_t value) {
+				return entry.hash < value;
+			});
+
+			for (; it != entries_.end() && it->hash == hash; ++it) {
+				if (name(*it) == key) {
+					return &*it;
+				}
+			}
+
+			return nullptr;
+		}
+
+		std::string_view name(const pack_entry& entry) const {
+			return names_.substr(entry.name_offset, entry.name_length);
+		}
+
+		// returns the stored bytes of an entry, compressed or not
+		std::string_view stored(const pack_entry& entry) const {
+			return std::string_view(file_->data() + entry.offset, entry.stored_size);
+		}
+
+		// the mapping, shared with everything that still views into it
+		const std::shared_ptr<mapped_file>& mapping() const {
+			return file_;
+		}
+
+		const std::vector<pack_entry>& entries() const {
+			return entries_;
+		}
+
+		const std::string& path() const {
+			return path_;
+		}
+
+	private:
+		std::shared_ptr<mapped_file> file_;
+		std::vector<pack_entry> entries_;
+		std::string_view names_;
+		std::string path_;
+	};
+
+	// ============================================================================================================================
+
+	// writes the files at 'paths' into a new pack at 'pack_path', each stored under its key.
+	// with 'compress' set, files are stored compressed when that saves at least an eighth of their size.
+	bool write_pack(const char* pack_path, const std::vector<std::string>& paths, bool compress = true) {
+
+		std::ofstream output(pack_path, std::ios::binary | std::ios::trunc);
+		if (!output) {
+			print_error("write_pack could not create: ", pack_path);
+			return false;
+		}
+
+		std::vector<pack_entry> entries;
+		entries.reserve(paths.size());
+
+		std::string names;
+		std::vector<char> compressed;
+
+		std::uint64_t offset = sizeof(pack_header);
+
+		auto pad_to = [&](std::uint64_t alignment) {
+			static constexpr char zeros[pack_alignment]{};
+
+			std::uint64_t aligned = (offset + alignment - 1llu) / alignment * alignment;
+			output.write(zeros, static_cast<std::streamsize>(aligned - offset));
+			offset = aligned;
+		};
+
+		// the header is written last, once the table is placed
+		pack_header header{};
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (const auto& path : paths) {
+
+			mapped_file file;
+			if (!file.open(path.c_str())) {
+				return false;
+			}
+
+			std::string key = file_key(path);
+
+			if (key.size() > std::numeric_limits<std::uint16_t>::max()) {
+				print_error("write_pack file name too long: ", path);
+				return false;
+			}
+
+			pad_to(pack_alignment);
+
+			pack_entry& entry = entries.emplace_back();
+			entry.hash = hash_key(key);
+			entry.offset = offset;
+			entry.size = file.size();
+			entry.stored_size = file.size();
+			entry.name_offset = static_cast<std::uint32_t>(names.size());
+			entry.name_length = static_cast<std::uint16_t>(key.size());
+			entry.compression = compression_none;
+
+			names += key;
+
+			const char* blob = file.data();
+
+			if (compress && file.size() > 0llu) {
+				lz::compress(file.data(), file.size(), compressed);
+
+				if (compressed.size() <= file.size() - file.size() / 8llu) {
+					entry.compression = compression_lz;
+					entry.stored_size = compressed.size();
+					blob = compressed.data();
+				}
+			}
+
+			output.write(blob, static_cast<std::streamsize>(entry.stored_size));
+			offset += entry.stored_size;
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const pack_entry& a, const pack_entry& b) {
+			return a.hash < b.hash;
+		});
+
+		pad_to(alignof(pack_entry));
+
+		header.table_offset = offset;
+		output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(pack_entry)));
+		offset += entries.size() * sizeof(pack_entry);
+
+		header.names_offset = offset;
+		output.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+		std::memcpy(header.magic, pack_magic, sizeof(pack_magic));
+		header.version = pack_version;
+		header.entry_count = static_cast<std::uint32_t>(entries.size());
+		header.alignment = static_cast<std::uint32_t>(pack_alignment);
+
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		if (!output) {
+			print_error("write_pack could not write: ", pack_path);
+			return false;
+		}
+
+		print_info("Packed ", entries.size(), " files into ", pack_path);
+		return true;
+	}
+
+	// lists every file below 'directory' in a stable order, which keeps files of one folder close together in a pack
+	bool list_directory(const char* directory, std::vector<std::string>& paths) {
+
+		std::error_code error;
+		for (const auto& item : std::filesystem::recursive_directory_iterator(directory, error)) {
+			if (item.is_regular_file()) {
+				paths.push_back(item.path().generic_string());
+			}
+		}
+
+		if (error) {
+			print_error("list_directory could not list: ", directory);
+			return false;
+		}
+
+		std::sort(paths.begin(), paths.end());
+		return true;
+	}
+
+	// packs every file below 'directory'
+	bool write_pack_directory(const char* pack_path, const char* directory, bool compress = true) {
+
+		std::vector<std::string> paths;
+		if (!list_directory(directory, paths)) {
+			return false;
+		}
+
+		return write_pack(pack_path, paths, compress);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <cstdint>
+
+#include <assimp/Importer.hpp>
+#include <assimp/IOSystem.hpp>
+#include <assimp/MemoryIOWrapper.h>
+
+#include "print.h"
+#include "vfs.h"
+
+namespace io {
+
+	// a stream over an opened file, keeps its memory alive while Assimp reads from it
+	struct mapped_stream : Assimp::MemoryIOStream {
+		explicit mapped_stream(file_view file)
+			: Assimp::MemoryIOStream(reinterpret_cast<const std::uint8_t*>(file.data()), file.size(), false)
+			, file_(std::move(file)) {}
+
+	private:
+		file_view file_;
+	};
+
+	// serves Assimp the files of the virtual file layer: memory files, packs and mapped files from disk instead of stdio.
+	// every importer owns one, the mappings themselves are shared by the file layer.
+	struct mapped_io_system : Assimp::IOSystem {
+
+		bool Exists(const char* path) const override {
+			return file_exists(path);
+		}
+
+		char getOsSeparator() const override {
+			return static_cast<char>(std::filesystem::path::preferred_separator);
+		}
+
+		Assimp::IOStream* Open(const char* path, const char* mode) override {
+
+			// the files are only ever read
+			if (std::string_view(mode).find_first_of("wa+") != std::string_view::npos) {
+				print_error("mapped_io_system can not open files for writing: ", path);
+				return nullptr;
+			}
+
+			// Assimp probes for files that may not exist, that is not an error
+			file_view file;
+			if (!open_file(path, file)) {
+				return nullptr;
+			}
+
+			return new mapped_stream(std::move(file));
+		}
+
+		void Close(Assimp::IOStream* stream) override {
+			delete stream;
+		}
+	};
+
+	// ============================================================================================================================
+
+	struct importer_pool;
+
+	// an importer taken from a pool, it frees its scene and goes back to the pool when the lease ends
+	struct importer_lease {
+
+		importer_lease() = default;
+
+		importer_lease(importer_pool* pool, std::unique_ptr<Assimp::Importer> importer)
+			: pool_(pool), importer_(std::move(importer)) {}
+
+		importer_lease(const importer_lease&) = delete;
+		importer_lease& operator=(const importer_lease&) = delete;
+
+		importer_lease(importer_lease&& other) noexcept
+			: pool_(other.pool_), importer_(std::move(other.importer_)) {}
+
+		importer_lease& operator=(importer_lease&& other) noexcept {
+			release();
+			pool_ = other.pool_;
+			importer_ = std::move(other.importer_);
+			return *this;
+		}
+
+		~importer_lease() {
+			release();
+		}
+
+		Assimp::Importer* operator->() const {
+			return importer_.get();
+		}
+
+		Assimp::Importer& operator*() const {
+			return *importer_;
+		}
+
+		explicit operator bool() const {
+			return importer_ != nullptr;
+		}
+
+		void release();
+
+	private:
+		importer_pool* pool_ = nullptr;
+		std::unique_ptr<Assimp::Importer> importer_;
+	};
+
+	// keeps importers around between loads, creating an importer sets up every format it knows.
+	// any thread can take an importer, one importer is only ever used by one load at a time.
+	struct importer_pool {
+
+		importer_lease acquire() {
+			{
+				std::lock_guard lock(mutex_);
+
+				if (!free_.empty()) {
+					auto importer = std::move(free_.back());
+					free_.pop_back();
+					return importer_lease(this, std::move(importer));
+				}
+			}
+
+			auto importer = std::make_unique<Assimp::Importer>();
+
+			// the importer takes ownership of its IO system
+			importer->SetIOHandler(new mapped_io_system());
+
+			return importer_lease(this, std::move(importer));
+		}
+
+		void give_back(std::unique_ptr<Assimp::Importer> importer) {
+			importer->FreeScene();
+
+			std::lock_guard lock(mutex_);
+			free_.push_back(std::move(importer));
+		}
+
+		// destroys the importers that are not in use
+		void clear() {
+			std::lock_guard lock(mutex_);
+			free_.clear();
+		}
+
+	private:
+		std::mutex mutex_;
+		std::vector<std::unique_ptr<Assimp::Importer>> free_;
+	};
+
+	void importer_lease::release() {
+		if (importer_ != nullptr) {
+			pool_->give_back(std::move(importer_));
+		}
+	}
+
+	// ============================================================================================================================
+	namespace data {
+		importer_pool importers;
+	}
+	// ============================================================================================================================
+}
\ No newline at end of file
@@ -0,0 +1,572 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define ASYNC_IO_URING
+#endif
+
+#include "print.h"
+#include "vfs.h"
+
+// reads many files at once.
+// files that are mounted in memory or in a pack are handed out right away, files on disk are read concurrently:
+// through io_uring on Linux, by a pool of threads doing positioned reads everywhere else or when io_uring is not allowed.
+// every file is handed to a worker as soon as it has been read, so decoding overlaps the reads of the files after it.
+namespace io {
+
+	// called once per file with its index in the batch, 'file' is not open when the file could not be read.
+	// runs on a worker thread, calls for different files run at the same time.
+	using read_callback = std::function<void(std::size_t index, file_view& file)>;
+
+	namespace detail {
+
+		// threads that run the callbacks of finished reads
+		struct worker_pool {
+
+			explicit worker_pool(std::size_t count) {
+				for (std::size_t i = 0; i < count; i++) {
+					threads_.emplace_back([this]() { run(); });
+				}
+			}
+
+			~worker_pool() {
+				{
+					std::lock_guard lock(mutex_);
+					stopping_ = true;
+				}
+				ready_.notify_all();
+
+				for (auto& thread : threads_) {
+					thread.join();
+				}
+			}
+
+			void push(std::function<void()> task) {
+				{
+					std::lock_guard lock(mutex_);
+					tasks_.push_back(std::move(task));
+				}
+				ready_.notify_one();
+			}
+
+		private:
+			void run() {
+				while (true) {
+					std::function<void()> task;
+					{
+						std::unique_lock lock(mutex_);
+						ready_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+						// the remaining tasks are finished before the pool stops
+						if (tasks_.empty()) {
+							return;
+						}
+
+						task = std::move(tasks_.front());
+						tasks_.pop_front();
+					}
+
+					task();
+				}
+			}
+
+			std::vector<std::thread> threads_;
+			std::deque<std::function<void()>> tasks_;
+			std::mutex mutex_;
+			std::condition_variable ready_;
+			bool stopping_ = false;
+		};
+
+		std::size_t worker_count() {
+			return std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		// reads a whole file with positioned reads, returns false when it could not be opened or read
+		bool read_whole_file(const std::string& key, std::vector<char>& output) {
+#ifdef _WIN32
+			HANDLE file = CreateFileA(key.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file, &file_size)) {
+				CloseHandle(file);
+				return false;
+			}
+
+			output.resize(static_cast<std::size_t>(file_size.QuadPart));
+
+			std::size_t offset = 0llu;
+			while (offset < output.size()) {
+				OVERLAPPED position{};
+				position.Offset = static_cast<DWORD>(offset);
+				position.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(offset) >> 32);
+
+				DWORD read = 0;
+				DWORD piece = static_cast<DWORD>(std::min<std::size_t>(output.size() - offset, 1llu << 30));
+
+				if (!ReadFile(file, output.data() + offset, piece, &read, &position) || read == 0) {
+					CloseHandle(file);
+					return false;
+				}
+
+				offset += read;
+			}
+
+			CloseHandle(file);
+			return true;
+#else
+			int descriptor = ::open(key.c_str(), O_RDONLY | O_CLOEXEC);
+			if (descriptor < 0) {
+				return false;
+			}
+
+			struct stat file_stat;
+			if (fstat(descriptor, &file_stat) != 0) {
+				::close(descriptor);
+				return false;
+			}
+
+			output.resize(static_cast<std::size_t>(file_stat.st_size));
+
+			std::size_t offset = 0llu;
+			while (offset < output.size()) {
+				ssize_t read = pread(descriptor, output.data() + offset, std::min<std::size_t>(output.size() - offset, 1llu << 30), static_cast<off_t>(offset));
+
+				if (read < 0 && errno == EINTR) {
+					continue;
+				}
+
+				if (read <= 0) {
+					::close(descriptor);
+					return false;
+				}
+
+				offset += static_cast<std::size_t>(read);
+			}
+
+			::close(descriptor);
+			return true;
+#endif
+		}
+
+		// reads the files at 'indices' of 'keys' with a pool of threads, each thread reads a file and runs its callback
+		void read_with_threads(const std::vector<std::string>& keys, const std::vector<std::size_t>& indices, const read_callback& on_read) {
+
+			// more threads than cores, most of them wait on the disk
+			std::size_t thread_count = std::min(indices.size(), std::clamp<std::size_t>(worker_count() * 2llu, 4llu, 32llu));
+
+			std::atomic<std::size_t> next = 0llu;
+
+			auto read_next = [&]() {
+				for (std::size_t i = next++; i < indices.size(); i = next++) {
+
+					std::size_t index = indices[i];
+
+					auto buffer = std::make_shared<std::vector<char>>();
+					file_view file;
+
+					if (read_whole_file(keys[index], *buffer)) {
+						file = file_view::from_buffer(std::move(buffer));
+					}
+
+					on_read(index, file);
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (std::size_t i = 1; i < thread_count; i++) {
+				threads.emplace_back(read_next);
+			}
+
+			read_next();
+
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+
+#ifdef ASYNC_IO_URING
+		// the submission and completion rings of an io_uring, set up with the raw system calls so no library is needed
+		struct uring {
+
+			uring() = default;
+			uring(const uring&) = delete;
+			uring& operator=(const uring&) = delete;
+
+			~uring() {
+				if (sqes_ != nullptr) {
+					munmap(sqes_, sqes_size_);
+				}
+
+				if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+					munmap(cq_ptr_, cq_size_);
+				}
+
+				if (sq_ptr_ != nullptr) {
+					munmap(sq_ptr_, sq_size_);
+				}
+
+				if (descriptor_ >= 0) {
+					::close(descriptor_);
+				}
+			}
+
+			// returns false when the kernel does not have or does not allow io_uring
+			bool open(unsigned int entries) {
+
+				io_uring_params params{};
+				descriptor_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+				if (descriptor_ < 0) {
+					return false;
+				}
+
+				sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+				cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+				bool single_mapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+				if (single_mapping) {
+					sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+				}
+
+				sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor_, IORING_OFF_SQ_RING);
+				if (sq_ptr_ == MAP_FAILED) {
+					sq_ptr_ = nullptr;
+					return false;
+				}
+
+				cq_ptr_ = single_mapping ? sq_ptr_ : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor_, IORING_OFF_CQ_RING);
+				if (cq_ptr_ == MAP_FAILED) {
+					cq_ptr_ = nullptr;
+					return false;
+				}
+
+				sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+				void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor_, IORING_OFF_SQES);
+				if (sqes == MAP_FAILED) {
+					return false;
+				}
+				sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+				auto* sq = static_cast<char*>(sq_ptr_);
+				sq_head_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+				sq_tail_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+				sq_mask_ = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+				sq_array_ = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+				sq_entries_ = params.sq_entries;
+
+				auto* cq = static_cast<char*>(cq_ptr_);
+				cq_head_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+				cq_tail_ = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+				cq_mask_ = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+				cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+				local_tail_ = *sq_tail_;
+				return true;
+			}
+
+			unsigned int capacity() const {
+				return sq_entries_;
+			}
+
+			// queues a vectored read, returns false when the submission ring is full
+			bool queue_read(int descriptor, const iovec* vector, std::uint64_t offset, std::uint64_t user_data) {
+
+				unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+				if (local_tail_ - head >= sq_entries_) {
+					return false;
+				}
+
+				unsigned int index = local_tail_ & sq_mask_;
+
+				io_uring_sqe& entry = sqes_[index];
+				std::memset(&entry, 0, sizeof(entry));
+				entry.opcode = IORING_OP_READV;
+				entry.fd = descriptor;
+				entry.addr = reinterpret_cast<std::uint64_t>(vector);
+				entry.len = 1;
+				entry.off = offset;
+				entry.user_data = user_data;
+
+				sq_array_[index] = index;
+				local_tail_++;
+				queued_++;
+				return true;
+			}
+
+			// submits the queued reads and waits until at least 'wait_for' have completed
+			bool submit(unsigned int wait_for) {
+
+				__atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+
+				while (true) {
+					long result = syscall(__NR_io_uring_enter, descriptor_, queued_, wait_for, wait_for > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+
+					if (result >= 0) {
+						queued_ -= static_cast<unsigned int>(result);
+						return true;
+					}
+
+					if (errno != EINTR) {
+						return false;
+					}
+				}
+			}
+
+			// calls 'on_completion(user_data, result)' for every read that has completed
+			template<typename Function>
+			void reap(Function&& on_completion) {
+
+				unsigned int head = *cq_head_;
+				unsigned int tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+				for (; head != tail; head++) {
+					const io_uring_cqe& completion = cqes_[head & cq_mask_];
+					on_completion(completion.user_data, completion.res);
+				}
+
+				__atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+			}
+
+		private:
+			int descriptor_ = -1;
+
+			void* sq_ptr_ = nullptr;
+			void* cq_ptr_ = nullptr;
+			std::size_t sq_size_ = 0llu;
+			std::size_t cq_size_ = 0llu;
+
+			io_uring_sqe* sqes_ = nullptr;
+			std::size_t sqes_size_ = 0llu;
+
+			unsigned int* sq_head_ = nullptr;
+			unsigned int* sq_tail_ = nullptr;
+			unsigned int* sq_array_ = nullptr;
+			unsigned int sq_mask_ = 0u;
+			unsigned int sq_entries_ = 0u;
+			unsigned int local_tail_ = 0u;
+			unsigned int queued_ = 0u;
+
+			unsigned int* cq_head_ = nullptr;
+			unsigned int* cq_tail_ = nullptr;
+			unsigned int cq_mask_ = 0u;
+			io_uring_cqe* cqes_ = nullptr;
+		};
+
+		// a file that is being read through the ring, read a piece at a time
+		struct uring_read {
+			std::size_t index = 0llu;
+			int descriptor = -1;
+			std::uint64_t offset = 0llu;
+			std::shared_ptr<std::vector<char>> buffer;
+			iovec vector{};
+		};
+
+		// reads the files at 'indices' of 'keys' through io_uring, returns false when io_uring can not be used.
+		// the files are opened and sized up front, their reads are then kept in flight up to the depth of the ring.
+		bool read_with_uring(const std::vector<std::string>& keys, const std::vector<std::size_t>& indices, const read_callback& on_read) {
+
+			constexpr unsigned int ring_depth = 64u;
+
+			// declared before the ring, so no buffer is freed while the kernel may still write to it
+			std::vector<uring_read> reads;
+			reads.reserve(indices.size());
+
+			uring ring;
+			if (!ring.open(ring_depth)) {
+				return false;
+			}
+
+			worker_pool workers(worker_count());
+
+			auto finish = [&](std::size_t index, std::shared_ptr<std::vector<char>> buffer) {
+				workers.push([&on_read, index, buffer = std::move(buffer)]() mutable {
+					file_view file;
+					if (buffer != nullptr) {
+						file = file_view::from_buffer(std::move(buffer));
+					}
+					on_read(index, file);
+				});
+			};
+
+			for (std::size_t index : indices) {
+
+				int descriptor = ::open(keys[index].c_str(), O_RDONLY | O_CLOEXEC);
+
+				struct stat file_stat;
+				if (descriptor < 0 || fstat(descriptor, &file_stat) != 0) {
+					if (descriptor >= 0) {
+						::close(descriptor);
+					}
+					finish(index, nullptr);
+					continue;
+				}
+
+				auto buffer = std::make_shared<std::vector<char>>(static_cast<std::size_t>(file_stat.st_size));
+
+				if (buffer->empty()) {
+					::close(descriptor);
+					finish(index, std::move(buffer));
+					continue;
+				}
+
+				uring_read& read = reads.emplace_back();
+				read.index = index;
+				read.descriptor = descriptor;
+				read.buffer = std::move(buffer);
+			}
+
+			// queues the next piece of a read, pieces are capped so their length fits the submission entry
+			auto queue_piece = [&](std::size_t read_index) {
+				uring_read& read = reads[read_index];
+
+				read.vector.iov_base = read.buffer->data() + read.offset;
+				read.vector.iov_len = std::min<std::size_t>(read.buffer->size() - read.offset, 1llu << 30);
+
+				return ring.queue_read(read.descriptor, &read.vector, read.offset, read_index);
+			};
+
+			std::size_t next = 0llu;
+			std::size_t in_flight = 0llu;
+			std::vector<std::size_t> requeue;
+
+			while (next < reads.size() || in_flight > 0llu) {
+
+				for (std::size_t read_index : requeue) {
+					queue_piece(read_index);
+				}
+				requeue.clear();
+
+				while (next < reads.size() && in_flight < ring.capacity() && queue_piece(next)) {
+					next++;
+					in_flight++;
+				}
+
+				if (!ring.submit(1u)) {
+					print_error("read_files io_uring submission failed, errno ", errno);
+					break;
+				}
+
+				ring.reap([&](std::uint64_t read_index, int result) {
+					uring_read& read = reads[read_index];
+
+					// interrupted reads are tried again
+					if (result == -EINTR || result == -EAGAIN) {
+						requeue.push_back(read_index);
+						return;
+					}
+
+					// an error, or the file got shorter since it was sized
+					if (result <= 0) {
+						::close(read.descriptor);
+						read.descriptor = -1;
+						in_flight--;
+						finish(read.index, nullptr);
+						return;
+					}
+
+					read.offset += static_cast<std::uint64_t>(result);
+
+					if (read.offset < read.buffer->size()) {
+						requeue.push_back(read_index);
+						return;
+					}
+
+					::close(read.descriptor);
+					read.descriptor = -1;
+					in_flight--;
+					finish(read.index, std::move(read.buffer));
+				});
+			}
+
+			// only reached early when the ring broke, the reads that did not finish are reported as failed
+			for (auto& read : reads) {
+				if (read.descriptor >= 0) {
+					::close(read.descriptor);
+					finish(read.index, nullptr);
+				}
+			}
+
+			return true;
+		}
+#endif
+	}
+
+	// ============================================================================================================================
+
+	// reads every file of 'paths' and calls 'on_read' for each of them as soon as it has been read.
+	// returns once every callback has returned.
+	void read_files(const std::vector<std::string>& paths, const read_callback& on_read) {
+
+		std::vector<std::string> keys(paths.size());
+		std::vector<std::size_t> on_disk;
+
+		{
+			detail::worker_pool workers(detail::worker_count());
+
+			for (std::size_t i = 0; i < paths.size(); i++) {
+
+				// mounted files are already in memory, only the callback has to run
+				auto file = std::make_shared<file_view>();
+				if (open_mounted_file(paths[i], *file)) {
+					workers.push([&on_read, i, file]() { on_read(i, *file); });
+					continue;
+				}
+
+				keys[i] = file_key(paths[i]);
+				on_disk.push_back(i);
+
+				std::error_code error;
+				auto size = std::filesystem::file_size(keys[i], error);
+				if (!error) {
+					record_access(keys[i], 0llu, size);
+				}
+			}
+
+			if (on_disk.empty()) {
+				return;
+			}
+
+#ifdef ASYNC_IO_URING
+			if (detail::read_with_uring(keys, on_disk, on_read)) {
+				return;
+			}
+#endif
+		}
+
+		detail::read_with_threads(keys, on_disk, on_read);
+	}
+}
\ No newline at end of file
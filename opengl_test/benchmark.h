@@ -0,0 +1,472 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+
+#include "print.h"
+#include "json.h"
+#include "sdl.h"
+#include "opengl.h"
+#include "globals.h"
+#include "camera.h"
+#include "game.h"
+#include "streaming.h"
+#include "profiler.h"
+#include "gpu_profiler.h"
+#include "render_stats.h"
+
+// a frame benchmark that gives the same frames every run, so the reports of two builds can be compared.
+// the ship flies a recorded path through the asteroid field with a fixed time step and the follow camera behind it, the
+// frames are drawn without vsync. it runs once for every asteroid count and writes the frame times, the CPU and GPU time
+// of the frames, the passes and the render counters of every run as JSON.
+//
+// the asteroids are placed with a fixed seed, the snapshot is not used and everything is loaded before the first frame
+// is measured.
+namespace benchmark {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	// the frames before every run that are drawn but not measured
+	constexpr std::size_t warmup_frames = 60llu;
+
+	// how far the ship moves along the path every frame, however long the frame took
+	constexpr float time_step = 1.f / 60.f;
+
+	constexpr float seconds_per_keyframe = 5.f;
+	constexpr std::uint32_t asteroid_seed = 1234u;
+
+	// the path the ship flies, it passes every keyframe and heads where it goes. it starts again after the last.
+	const std::array<glm::vec3, 8> flight_path{ {
+		{ 1.f, 0.f, -5.f },
+		{ 60.f, 20.f, 250.f },
+		{ 250.f, 60.f, 500.f },
+		{ 500.f, 0.f, 600.f },
+		{ 700.f, -80.f, 400.f },
+		{ 650.f, -40.f, 100.f },
+		{ 400.f, 30.f, -150.f },
+		{ 100.f, 10.f, -200.f }
+	} };
+
+	struct pass_result {
+		std::string name;
+		double cpu_ms = 0.0;
+		double gpu_ms = 0.0;
+	};
+
+	// everything measured for one asteroid count, one value per frame
+	struct run {
+		std::size_t asteroids = 0llu;
+
+		std::vector<double> frame_ms;
+		std::vector<double> cpu_ms;
+		std::vector<double> gpu_ms;
+		std::vector<render_stats::counters> counters;
+
+		// the averages of the profiler at the end of the run
+		std::vector<pass_result> passes;
+	};
+
+	struct summary {
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// no benchmark runs while it is 0
+		std::size_t frames = 0llu;
+		std::string report_path;
+
+		std::vector<std::size_t> asteroid_counts;
+		std::vector<run> runs;
+
+		// the frame of the current run, the warmup frames come first
+		std::size_t frame = 0llu;
+
+		follow_camera view;
+
+		bool has_timestamps = false;
+
+		// a start and an end timestamp for every measured frame of the current run
+		std::vector<unsigned int> queries;
+
+		std::uint64_t frame_start = 0llu;
+		std::uint64_t submit_end = 0llu;
+		std::uint64_t last_frame_end = 0llu;
+	}
+	// ============================================================================================================================
+
+	namespace detail {
+
+		double milliseconds(std::uint64_t start, std::uint64_t end) {
+			return static_cast<double>(end - start) / 1000000.0;
+		}
+
+		summary summarize(std::vector<double> values) {
+
+			summary result;
+			if (values.empty()) {
+				return result;
+			}
+
+			std::sort(values.begin(), values.end());
+
+			auto at = [&values](double fraction) {
+				auto index = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1llu) + 0.5);
+				return values[std::min<std::size_t>(index, values.size() - 1llu)];
+			};
+
+			result.mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+			result.p50 = at(0.5);
+			result.p95 = at(0.95);
+			result.p99 = at(0.99);
+			result.max = values.back();
+			return result;
+		}
+
+		// a Catmull-Rom spline through the keyframes, the first and the last keyframe are repeated at the ends
+		glm::vec3 path_position(float seconds) {
+
+			float duration = seconds_per_keyframe * static_cast<float>(flight_path.size() - 1llu);
+			float along = std::fmod(seconds, duration) / seconds_per_keyframe;
+
+			auto segment = std::min<std::size_t>(static_cast<std::size_t>(along), flight_path.size() - 2llu);
+			float t = along - static_cast<float>(segment);
+
+			const auto& p0 = flight_path[segment > 0llu ? segment - 1llu : 0llu];
+			const auto& p1 = flight_path[segment];
+			const auto& p2 = flight_path[segment + 1llu];
+			const auto& p3 = flight_path[std::min<std::size_t>(segment + 2llu, flight_path.size() - 1llu)];
+
+			float t2 = t * t;
+			float t3 = t2 * t;
+
+			return 0.5f * ((2.f * p1) + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+		}
+
+		// places the ship on the path and turns it where the path goes, a model faces +z without rotation
+		void place_ship(float seconds) {
+
+			world::model& ship = world::model_get(game::data::ship);
+
+			glm::vec3 position = path_position(seconds);
+			glm::vec3 heading = path_position(seconds + time_step) - position;
+
+			ship.position() = position;
+
+			if (glm::length(heading) > 0.f) {
+				heading = glm::normalize(heading);
+
+				ship.rotation().angle_x = glm::degrees(-std::asin(std::clamp(heading.y, -1.f, 1.f)));
+				ship.rotation().angle_y = glm::degrees(std::atan2(heading.x, heading.z));
+				ship.rotation().angle_z = 0.f;
+			}
+		}
+
+		bool is_measuring() {
+			return data::frame >= warmup_frames;
+		}
+
+		std::size_t measured_frame() {
+			return data::frame - warmup_frames;
+		}
+
+		void start_run(std::size_t asteroids) {
+
+			auto& started = data::runs.emplace_back();
+			started.asteroids = asteroids;
+			started.frame_ms.reserve(data::frames);
+			started.cpu_ms.reserve(data::frames);
+			started.gpu_ms.reserve(data::frames);
+			started.counters.reserve(data::frames);
+
+			data::frame = 0llu;
+
+			if (data::has_timestamps) {
+				data::queries.resize(data::frames * 2llu);
+				glGenQueries(static_cast<GLsizei>(data::queries.size()), data::queries.data());
+			}
+
+			print_info("benchmark ", data::frames, " frames with ", asteroids, " asteroids");
+		}
+
+		// reads the GPU times of the run, it waits for the GPU to finish the last frame
+		void finish_run() {
+
+			auto& finished = data::runs.back();
+
+			if (data::has_timestamps) {
+				for (std::size_t i = 0; i < data::frames; i++) {
+					GLuint64 start = 0llu;
+					GLuint64 end = 0llu;
+					glGetQueryObjectui64v(data::queries[i * 2llu], GL_QUERY_RESULT, &start);
+					glGetQueryObjectui64v(data::queries[i * 2llu + 1llu], GL_QUERY_RESULT, &end);
+
+					finished.gpu_ms.push_back(milliseconds(start, end));
+				}
+
+				glDeleteQueries(static_cast<GLsizei>(data::queries.size()), data::queries.data());
+				data::queries.clear();
+			}
+
+			for (const auto& measured : gpu_profiler::data::passes) {
+				finished.passes.push_back({ measured.name, measured.cpu_ms, measured.gpu_ms });
+			}
+		}
+
+		void write_summary(std::ostream& output, const char* name, const std::vector<double>& values) {
+
+			summary result = summarize(values);
+
+			output << "\"" << name << "\":{\"mean\":" << result.mean << ",\"p50\":" << result.p50 << ",\"p95\":" << result.p95
+				<< ",\"p99\":" << result.p99 << ",\"max\":" << result.max << "}";
+		}
+
+		void print_summary(const char* name, const std::vector<double>& values) {
+
+			summary result = summarize(values);
+			print_info("  ", name, " ms: mean ", result.mean, " | p50 ", result.p50, " | p95 ", result.p95, " | p99 ", result.p99, " | max ", result.max);
+		}
+	}
+
+	// writes every run to 'path' as JSON
+	bool write_report(const char* path) {
+
+		std::ofstream output(path, std::ios::trunc);
+		if (!output) {
+			print_error("benchmark could not create: ", path);
+			return false;
+		}
+
+		output << std::fixed << std::setprecision(4);
+
+		auto renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+		output << "{\n\"renderer\":";
+		json::write_string(output, renderer != nullptr ? renderer : "");
+
+#ifdef DEBUG
+		output << ",\n\"build\":\"debug\"";
+#else
+		output << ",\n\"build\":\"release\"";
+#endif
+
+#ifdef HEADLESS
+		output << ",\n\"headless\":true";
+#else
+		output << ",\n\"headless\":false";
+#endif
+
+		output << ",\n\"width\":" << sdl::data::window_width << ",\"height\":" << sdl::data::window_height;
+		output << ",\n\"frames\":" << data::frames << ",\"warmup_frames\":" << warmup_frames;
+		output << ",\n\"time_step_ms\":" << static_cast<double>(time_step) * 1000.0 << ",\"seed\":" << asteroid_seed;
+		output << ",\n\"gpu_timestamps\":" << (data::has_timestamps ? "true" : "false");
+		output << ",\n\"runs\":[";
+
+		for (std::size_t r = 0; r < data::runs.size(); r++) {
+			const auto& measured = data::runs[r];
+
+			output << (r > 0llu ? ",\n" : "\n") << "{\"asteroids\":" << measured.asteroids << ",\n";
+			detail::write_summary(output, "frame_ms", measured.frame_ms);
+			output << ",\n";
+			detail::write_summary(output, "cpu_ms", measured.cpu_ms);
+			output << ",\n";
+			detail::write_summary(output, "gpu_ms", measured.gpu_ms);
+
+			output << ",\n\"passes\":[";
+			for (std::size_t p = 0; p < measured.passes.size(); p++) {
+				output << (p > 0llu ? "," : "") << "{\"name\":";
+				json::write_string(output, measured.passes[p].name);
+				output << ",\"cpu_ms\":" << measured.passes[p].cpu_ms << ",\"gpu_ms\":" << measured.passes[p].gpu_ms << "}";
+			}
+			output << "]";
+
+			// the counters hardly change between frames, the mean and the maximum are enough
+			output << ",\n\"counters\":{";
+			for (std::size_t c = 0; c < render_stats::counter_infos.size(); c++) {
+				const auto& info = render_stats::counter_infos[c];
+
+				double total = 0.0;
+				std::uint64_t most = 0llu;
+
+				for (const auto& frame : measured.counters) {
+					total += static_cast<double>(frame.*info.value);
+					most = std::max(most, frame.*info.value);
+				}
+
+				double mean = measured.counters.empty() ? 0.0 : total / static_cast<double>(measured.counters.size());
+
+				output << (c > 0llu ? "," : "");
+				json::write_string(output, info.name);
+				output << ":{\"mean\":" << mean << ",\"max\":" << most << "}";
+			}
+			output << "}}";
+		}
+
+		output << "\n]\n}\n";
+		output.close();
+
+		if (!output) {
+			print_error("benchmark could not write: ", path);
+			return false;
+		}
+
+		print_info("Saved the benchmark to ", path);
+		return true;
+	}
+
+	// sets the game up for a benchmark of 'frames' frames for every count in 'asteroid_counts', a comma separated list.
+	// call it before 'game::on_init', the report is written to 'report_path' once the last run is done.
+	void configure(std::size_t frames, const char* asteroid_counts, const char* report_path) {
+
+		data::asteroid_counts.clear();
+
+		for (const char* it = asteroid_counts; it != nullptr && *it != '\0';) {
+			char* end = nullptr;
+			std::size_t count = std::strtoull(it, &end, 10);
+
+			if (end == it || count == 0llu) {
+				print_error("benchmark invalid asteroid counts: ", asteroid_counts);
+				data::asteroid_counts.clear();
+				break;
+			}
+
+			data::asteroid_counts.push_back(count);
+			it = *end == ',' ? end + 1 : end;
+		}
+
+		if (frames == 0llu || data::asteroid_counts.empty()) {
+			return;
+		}
+
+		data::frames = frames;
+		data::report_path = report_path;
+
+		game::data::use_snapshot = false;
+		game::data::progressive_startup = false;
+		game::data::steer_ship = false;
+		game::data::asteroid_count = data::asteroid_counts.front();
+		game::data::asteroid_seed = asteroid_seed;
+	}
+
+	// starts the first run, call it after 'game::on_init'
+	void start() {
+
+		if (data::frames == 0llu) {
+			return;
+		}
+
+		sdl::set_vsync(false);
+
+		data::view = follow_camera(game::data::ship);
+		game::data::view_camera = &data::view;
+
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		data::has_timestamps = bits > 0;
+
+		if (!data::has_timestamps) {
+			print_info("benchmark no timestamp queries, the GPU time of the frames is not measured");
+		}
+
+		detail::start_run(data::asteroid_counts.front());
+		data::last_frame_end = profiler::now();
+	}
+
+	// places the ship for the frame, call it at the top of the main loop before 'game::on_update'
+	void begin_frame() {
+
+		if (data::frames == 0llu) {
+			return;
+		}
+
+		data::frame_start = profiler::now();
+
+		// the warmup frames wait at the start of the path
+		detail::place_ship(detail::is_measuring() ? static_cast<float>(detail::measured_frame()) * time_step : 0.f);
+
+		if (detail::is_measuring() && data::has_timestamps) {
+			glQueryCounter(data::queries[detail::measured_frame() * 2llu], GL_TIMESTAMP);
+		}
+	}
+
+	// call it after the last draw of the frame, before the buffers are swapped
+	void end_submit() {
+
+		if (data::frames == 0llu) {
+			return;
+		}
+
+		data::submit_end = profiler::now();
+
+		if (detail::is_measuring() && data::has_timestamps) {
+			glQueryCounter(data::queries[detail::measured_frame() * 2llu + 1llu], GL_TIMESTAMP);
+		}
+	}
+
+	// records the frame, call it after the buffers are swapped and 'render_stats::end_frame'.
+	// after the last frame of a run the next run starts, after the last run the report is written and the game quits.
+	void end_frame() {
+
+		if (data::frames == 0llu) {
+			return;
+		}
+
+		std::uint64_t frame_end = profiler::now();
+
+		// nothing may load while the frames are measured, the warmup lasts until it is done
+		if (!detail::is_measuring() && streaming::is_loading()) {
+			data::last_frame_end = frame_end;
+			return;
+		}
+
+		if (detail::is_measuring()) {
+			auto& current = data::runs.back();
+
+			current.frame_ms.push_back(detail::milliseconds(data::last_frame_end, frame_end));
+			current.cpu_ms.push_back(detail::milliseconds(data::frame_start, data::submit_end));
+			current.counters.push_back(render_stats::last_frame());
+		}
+
+		data::last_frame_end = frame_end;
+		data::frame++;
+
+		if (data::frame < warmup_frames + data::frames) {
+			return;
+		}
+
+		detail::finish_run();
+
+		const auto& finished = data::runs.back();
+		print_info("benchmark ", finished.asteroids, " asteroids:");
+		detail::print_summary("frame", finished.frame_ms);
+		detail::print_summary("cpu", finished.cpu_ms);
+		detail::print_summary("gpu", finished.gpu_ms);
+
+		if (data::runs.size() < data::asteroid_counts.size()) {
+			std::size_t next = data::asteroid_counts[data::runs.size()];
+
+			game::replace_cube_locations(next, asteroid_seed);
+			detail::start_run(next);
+
+			data::last_frame_end = profiler::now();
+			return;
+		}
+
+		write_report(data::report_path.c_str());
+		data::frames = 0llu;
+
+		global.should_quit(true);
+	}
+}
\ No newline at end of file
@@ -101,35 +101,36 @@ struct follow_camera : camera {
 
 	follow_camera() = default;
 
-	follow_camera(const world::model& follow_me)
-		: model_ptr(&follow_me)
+	follow_camera(world::model_handle follow_me)
+		: followed_(follow_me)
 	{
 
 	}
 
 	const glm::mat4& view() override {
 
-		if (model_ptr != nullptr) {
+		// the model is looked up every time, so the camera can't outlive it
+		if (const world::model* model_ptr = world::data::loaded_models.get(followed_)) {
 
 			const world::model& model = *model_ptr;
 
-			if (model.position != last_position
-				|| model.rotation != last_rotation) {
+			if (model.position() != last_position
+				|| model.rotation() != last_rotation) {
 
-				auto pos = model.position - model.forward() * 10.f;
+				auto pos = model.position() - model.forward() * 10.f;
 
-				last_view = glm::lookAt(pos, model.position, model.up());
+				last_view = glm::lookAt(pos, model.position(), model.up());
 				camera_view_updates_++;
 			}
 
 
-			last_position = model.position;
-			last_rotation = model.rotation;
+			last_position = model.position();
+			last_rotation = model.rotation();
 		}
 
 		return last_view;
 	}
 
 private:
-	const world::model* model_ptr = nullptr;
+	world::model_handle followed_{};
 };
\ No newline at end of file
@@ -1,35 +1,77 @@
-﻿#pragma once
+#pragma once
 #include "globals.h"
 #include "world.h"
+#include "instances.h"
+#include "obj_loader.h"
+#include "streaming.h"
+#include "snapshot.h"
+#include "vfs.h"
 #include "shader.h"
 #include "opengl.h"
 #include "camera.h"
 #include "random.h"
 #include "gui.h"
+#include "profiler.h"
+#include "gpu_profiler.h"
+#include "trace_capture.h"
+#include "render_stats.h"
+#include "gl_intercept.h"
 
 #include <sstream>
+#include <filesystem>
+#include <memory>
+#include <cstdint>
 
 namespace game 
 {
 	// ============================================================================================================================
 
 	namespace data {
-		std::size_t ship_index = 0llu;
-		std::size_t cube_index = 0llu;
+		world::model_handle ship{};
+		world::model_handle cube{};
 
-		unsigned int ship_shader_id = 0u;
-		unsigned int cube_shader_id = 0u;
+		shader::program_handle ship_shader{};
+		shader::program_handle cube_shader{};
+		shader::program_handle fleet_shader{};
+
+		// copies of the ship, they share its meshes and are drawn together
+		std::vector<world::instance_handle> fleet;
 
 		camera main_camera;
 
+		// the camera the world is drawn with instead of 'main_camera' when it is set
+		camera* view_camera = nullptr;
+
 		bool is_in_fullscreen = false;
 		bool capture_mouse = true;
 		bool show_ship_ui = true;
+		bool show_profiler = false;
+		bool show_render_stats = false;
+		bool show_gl_calls = false;
+
+		// how many frames F9 captures into a trace file
+		std::size_t capture_frames = 60llu;
 
 		std::vector<glm::mat4> locations;
 		unsigned int instance_buffer;
 
 		float ship_velocity = 0.f;
+
+		// when cleared the keyboard does not steer the ship, something else places it every frame
+		bool steer_ship = true;
+
+		// the asteroids are placed at random, 0 places them differently every run and any other seed the same way
+		std::size_t asteroid_count = 150000llu;
+		std::uint32_t asteroid_seed = 0u;
+
+		// when set, 'on_init' returns before the models are loaded and they are drawn as their bounds until they are.
+		// otherwise it waits for everything, like a loading screen would.
+		bool progressive_startup = true;
+
+		// when set, the world is restored from the snapshot instead of loaded when there is an up to date one.
+		// a snapshot is written once everything is loaded and again when the game quits.
+		bool use_snapshot = true;
+		bool snapshot_saved = false;
 	}
 
 	// ============================================================================================================================
@@ -37,6 +79,13 @@ namespace game
 	constexpr unsigned int default_load_flags = aiProcess_GenNormals | aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes;
 	constexpr unsigned int default_smooth_load_flags = aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes;
 
+	constexpr auto ship_path = R"(assets\models\spaceship3.obj)";
+	constexpr auto cube_path = R"(assets\models\ico_low.obj)";
+	constexpr auto snapshot_path = "world.snapshot";
+
+	// the asteroids are placed in a cube this far from the origin on every axis
+	constexpr float asteroid_field_extent = 1500.f;
+
 	// ============================================================================================================================
 
 	void control_camera(camera& control_me/*, world::model& follow_me*/) {
@@ -73,20 +122,22 @@ namespace game
 		}
 
 		if (sdl::is_key_down("A")) {
-			control_me.rotation.angle_y -= velocity;
+			control_me.rotation().angle_y -= velocity;
 		}
 		else if (sdl::is_key_down("D")) {
-			control_me.rotation.angle_y += velocity;
+			control_me.rotation().angle_y += velocity;
 		}
 
 		if (sdl::is_key_down("W")) {
-			control_me.rotation.angle_x += velocity;
+			control_me.rotation().angle_x += velocity;
 		}
 		else if (sdl::is_key_down("S")) {
-			control_me.rotation.angle_x -= velocity;
+			control_me.rotation().angle_x -= velocity;
 		}
 
-		control_me.position += control_me.forward() * delta_time * data::ship_velocity;
+		// the basis is only updated by 'world::update_transforms' later in the frame, steer along the rotation just set
+		control_me.update_orientation();
+		control_me.position() += control_me.forward() * delta_time * data::ship_velocity;
 
 		if (data::ship_velocity > 0.f) {
 			data::ship_velocity -= delta_time * 2.f;
@@ -104,17 +155,20 @@ namespace game
 
 	// ============================================================================================================================
 
-	void create_cube_locations(std::size_t amount, float minx, float maxx, float miny, float maxy, float minz, float maxz) {
+	// generates the matrices of the cubes, it does not touch OpenGL so it can run in the background
+	void create_cube_locations(std::vector<glm::mat4>& output, std::size_t amount, float minx, float maxx, float miny, float maxy, float minz, float maxz, std::uint32_t seed) {
 
 		assert(maxx > minx);
 		assert(maxy > miny);
 		assert(maxz > minz);
 
+		random::random_impl<std::mt19937> generator{ seed != 0u ? seed : std::random_device{}() };
+
 		for (std::size_t i = 0; i < amount; i++)
 		{
-			float x = random::next(minx, maxx);
-			float y = random::next(miny, maxy);
-			float z = random::next(minz, maxz);
+			float x = generator.next(minx, maxx);
+			float y = generator.next(miny, maxy);
+			float z = generator.next(minz, maxz);
 
 			float rx = 0.f;//random::next(0.f, 360.f);
 			float ry = 0.f;//random::next(0.f, 360.f);
@@ -125,8 +179,14 @@ namespace game
 			auto rotate_z = glm::rotate(rotate_y, glm::radians(rz), glm::vec3(0.f, 0.f, 1.f));
 			auto translate = glm::translate(rotate_z, glm::vec3(x, y, z));
 
-			data::locations.push_back(translate);
+			output.push_back(translate);
 		}
+	}
+
+	// uploads the matrices of the cubes, they are drawn from then on
+	void setup_cube_locations(std::vector<glm::mat4>&& locations) {
+
+		data::locations = std::move(locations);
 
 		data::instance_buffer = opengl::create_shader_storage_buffer(
 			data::locations.size(),
@@ -134,6 +194,28 @@ namespace game
 		);
 	}
 
+	// places the asteroids again on the main thread, the old ones and their buffer are dropped
+	void replace_cube_locations(std::size_t amount, std::uint32_t seed) {
+
+		std::vector<glm::mat4> locations;
+		create_cube_locations(
+			locations,
+			amount,
+			-asteroid_field_extent, asteroid_field_extent,
+			-asteroid_field_extent, asteroid_field_extent,
+			-asteroid_field_extent, asteroid_field_extent,
+			seed
+		);
+
+		if (!data::locations.empty()) {
+			glDeleteBuffers(1, &data::instance_buffer);
+		}
+
+		data::asteroid_count = amount;
+		data::asteroid_seed = seed;
+		setup_cube_locations(std::move(locations));
+	}
+
 	// ============================================================================================================================
 
 	void show_loc_rot_gui(world::model& for_model, bool& show) {
@@ -143,14 +225,14 @@ namespace game
 			ImGui::Begin(for_model.path_to_file().c_str(), &show);
 
 			ImGui::Text("Position");
-			ImGui::DragScalarN("xyz", ImGuiDataType_Float, &for_model.position, 3, 0.1f, nullptr, nullptr, "%.1f");
+			ImGui::DragScalarN("xyz", ImGuiDataType_Float, &for_model.position(), 3, 0.1f, nullptr, nullptr, "%.1f");
 
 			ImGui::Separator();
 
 			ImGui::Text("Rotation");
 			constexpr auto a_min = -360.f;
 			constexpr auto a_max = -360.f;
-			ImGui::DragScalarN("axyz", ImGuiDataType_Float, &for_model.rotation, 3, 0.1f, &a_min, &a_max, "%.1f deg");
+			ImGui::DragScalarN("axyz", ImGuiDataType_Float, &for_model.rotation(), 3, 0.1f, &a_min, &a_max, "%.1f deg");
 
 			ImGui::Separator();
 
@@ -202,7 +284,7 @@ namespace game
 				ImGui::Separator();
 
 				for (const auto& mesh : for_model) {
-					ImGui::Text(mesh.name().c_str());
+					ImGui::TextUnformatted(mesh.name().data(), mesh.name().data() + mesh.name().size());
 					ImGui::NextColumn();
 					ImGui::Text("%i", mesh.vertex_size());
 					ImGui::NextColumn();
@@ -249,38 +331,235 @@ namespace game
 
 	// ============================================================================================================================
 
-	void on_init() {
-		// load the shader to use for our models
-		bool ship_shader_loaded = shader::load_shader(data::ship_shader_id, shader::basic_vert, shader::basic_frag);
-		bool cube_shader_loaded = shader::load_shader(data::cube_shader_id, shader::basic_instance_vert, shader::basic_frag);
-
-		// load a new model and set the shader to use
-		world::load_model(data::ship_index, R"(assets\models\spaceship3.obj)", default_load_flags);
-		world::model_set_shader(data::ship_index, data::ship_shader_id);
+	// the tasks that compile the shaders, what uses a shader depends on its task
+	struct shader_tasks {
+		tasks::task_id ship;
+		tasks::task_id cube;
+		tasks::task_id fleet;
+	};
+
+	// compiles the shaders on the main thread, while the models are read in the background
+	shader_tasks load_shaders() {
+		return {
+			streaming::add_main_task("ship shader", []() {
+				shader::load_shader(data::ship_shader, shader::basic_vert, shader::basic_frag);
+			}),
+			streaming::add_main_task("cube shader", []() {
+				shader::load_shader(data::cube_shader, shader::basic_instance_vert, shader::basic_frag);
+			}),
+			streaming::add_main_task("fleet shader", []() {
+				shader::load_shader(data::fleet_shader, shader::basic_instance_vert, shader::basic_frag);
+			})
+		};
+	}
 
-		create_cube_locations(
-			150000llu,			// amount
-			-1500.f, 1500.f,	// min, max x
-			-1500.f, 1500.f,	// min, max y
-			-1500.f, 1500.f		// min, max z
+	// loads the models and places everything from scratch.
+	// the models can be placed right away, they are drawn as their bounds until they are loaded.
+	void load_world(const shader_tasks& shaders) {
+
+		world::stream_obj(data::ship, ship_path, default_load_flags);
+		world::stream_obj(data::cube, cube_path, default_load_flags);
+
+		streaming::add_main_task("ship set shader", []() {
+			world::model_set_shader(data::ship, data::ship_shader);
+		}, { shaders.ship });
+
+		streaming::add_main_task("cube set shader", []() {
+			world::model_set_shader(data::cube, data::cube_shader);
+		}, { shaders.cube });
+
+		// the cube locations need nothing but the buffer they are uploaded to
+		auto locations = std::make_shared<std::vector<glm::mat4>>();
+
+		streaming::add_job("cube locations",
+			[locations, amount = data::asteroid_count, seed = data::asteroid_seed]() {
+				create_cube_locations(
+					*locations,
+					amount,
+					-asteroid_field_extent, asteroid_field_extent,	// min, max x
+					-asteroid_field_extent, asteroid_field_extent,	// min, max y
+					-asteroid_field_extent, asteroid_field_extent,	// min, max z
+					seed
+				);
+			},
+			[locations]() {
+				setup_cube_locations(std::move(*locations));
+			}
 		);
 
-		// load another model and set the shader to use
-		world::load_model(data::cube_index, R"(assets\models\ico_low.obj)", default_load_flags);
-		world::model_set_shader(data::cube_index, data::cube_shader_id);
+		world::model& ship = world::model_get(data::ship);
+		ship.position().z -= 5.f;
+		ship.position().x += 1.f;
+
+		// place a fleet of ships next to ours, without loading the model again
+		streaming::add_main_task("place fleet", [position = ship.position()]() {
+			for (int i = 0; i < 8; i++) {
+				auto side = i % 2 == 0 ? 1.f : -1.f;
+				auto row = static_cast<float>(i / 2 + 1);
+
+				world::instance_handle wingman;
+				if (world::create_instance(wingman, data::ship, data::fleet_shader, position + glm::vec3(side * row * 6.f, 0.f, -row * 6.f))) {
+					data::fleet.push_back(wingman);
+				}
+			}
+		}, { shaders.fleet });
+	}
+
+	// writes the models, the instances and the cube locations into the snapshot.
+	// nothing is written while the models are still loading, a restart would restore the placeholders.
+	bool save_snapshot() {
+
+		if (streaming::is_loading()) {
+			return false;
+		}
+
+		snapshot::writer output;
+
+		std::vector<world::model_handle> models;
+		snapshot::write_models(output, models);
+		snapshot::write_instances(output, models);
+
+		if (std::find(models.begin(), models.end(), data::ship) == models.end() || std::find(models.begin(), models.end(), data::cube) == models.end()) {
+			print_error("save_snapshot the models could not be written");
+			return false;
+		}
+
+		output.add_vector("cube locations", data::locations);
+		output.add_value("ship velocity", data::ship_velocity);
+
+		if (!output.save(snapshot_path)) {
+			return false;
+		}
+
+		print_info("Saved the world to ", snapshot_path);
+		return true;
+	}
+
+	// what 'read_snapshot' read, the records are views into the snapshot which is kept open with them
+	struct snapshot_contents {
+		snapshot::reader input;
+
+		std::vector<glm::mat4> locations;
+		float ship_velocity = 0.f;
+
+		std::vector<world::snapshot_model> records;
+		std::vector<snapshot::instance_record> instances;
+
+		std::size_t ship = 0llu;
+		std::size_t cube = 0llu;
+
+		// set once the snapshot has been read and is up to date
+		bool read = false;
+	};
+
+	// reads and checks what 'save_snapshot' wrote without creating anything, so it can run on any thread.
+	// returns false when there is no snapshot or it is out of date.
+	bool read_snapshot(snapshot_contents& output) {
+		PROFILE_ZONE("read_snapshot");
+
+		if (!output.input.open(snapshot_path)) {
+			return false;
+		}
+
+		if (!output.input.read_vector("cube locations", output.locations) || output.locations.empty() || !output.input.read_value("ship velocity", output.ship_velocity)) {
+			print_error("read_snapshot incomplete snapshot: ", snapshot_path);
+			return false;
+		}
+
+		if (!snapshot::read_models(output.input, default_load_flags, output.records)) {
+			return false;
+		}
+
+		if (!snapshot::find_model(output.records, ship_path, output.ship) || !snapshot::find_model(output.records, cube_path, output.cube)) {
+			print_error("read_snapshot the snapshot does not hold every model: ", snapshot_path);
+			return false;
+		}
+
+		return snapshot::read_instances(output.input, output.records.size(), output.instances);
+	}
+
+	// creates what 'read_snapshot' read, the shaders it refers to have to be compiled.
+	// nothing here can fail, a snapshot rejected halfway would leave models behind that 'load_world' loads again.
+	void restore_snapshot(snapshot_contents& contents) {
+
+		std::vector<world::model_handle> models;
+		snapshot::restore_models(contents.records, models);
+
+#ifdef DEBUG
+		// what was restored is saved again on quit, it has to restore the same way or every other start loads from scratch
+		if (!snapshot::check_models(models, default_load_flags)) {
+			print_error("restore_snapshot the restored models would not be restored from the next snapshot");
+		}
+#endif
+
+		data::ship = models[contents.ship];
+		data::cube = models[contents.cube];
+
+		snapshot::restore_instances(contents.instances, models, data::fleet);
+
+		setup_cube_locations(std::move(contents.locations));
+		data::ship_velocity = contents.ship_velocity;
+
+		// it is as up to date as it gets, until something moves
+		data::snapshot_saved = true;
+
+		print_info("Restored the world from ", snapshot_path);
+	}
+
+	// reads the snapshot in the background while the shaders compile, then restores it once they are.
+	// the world is loaded from scratch instead when there is no up to date snapshot.
+	void stream_snapshot(const shader_tasks& shaders) {
+
+		auto contents = std::make_shared<snapshot_contents>();
 
-		world::model& ship = world::model_get(data::ship_index);
-		ship.position.z -= 5.f;
-		ship.position.x += 1.f;
+		auto reading = streaming::add_worker_task("read snapshot", [contents]() {
+			contents->read = read_snapshot(*contents);
+		});
 
-		// prepare the vertex data
-		world::setup_model(data::ship_index);
-		world::setup_model(data::cube_index);
+		streaming::add_main_task("restore snapshot", [contents, shaders]() {
+			if (contents->read) {
+				restore_snapshot(*contents);
+			}
+			else {
+				load_world(shaders);
+			}
+
+			data::main_camera = follow_camera(data::ship);
+		}, { reading, shaders.ship, shaders.cube, shaders.fleet });
+	}
+
+	// ============================================================================================================================
+
+	void on_init() {
+		PROFILE_ZONE("game on_init");
 
-		data::main_camera = follow_camera(ship);
+		// assets are read from the pack when one has been built with 'world::write_obj_pack("assets.pack", "assets", default_load_flags)',
+		// files it does not hold are still read from disk
+		std::error_code pack_error;
+		if (std::filesystem::exists("assets.pack", pack_error)) {
+			io::mount_pack("assets.pack");
+		}
+
+		// the startup is a task graph, see 'streaming::print_report' for how long each task took
+		shader_tasks shaders = load_shaders();
+
+		// until the snapshot is restored or the world is loaded in its place, the frames only show the progress
+		if (data::use_snapshot) {
+			stream_snapshot(shaders);
+		}
+		else {
+			load_world(shaders);
+			data::main_camera = follow_camera(data::ship);
+		}
+
+		// the tasks that are left run as the frames are drawn, see 'streaming::update'
+		if (!data::progressive_startup) {
+			streaming::finish_all();
+		}
 	}
 
 	void on_update() {
+		PROFILE_ZONE("game on_update");
 
 		if (sdl::is_key_down("Escape")) {
 			global.should_quit(true);
@@ -299,26 +578,90 @@ namespace game
 			sdl::set_capture_mouse(data::capture_mouse);
 		}
 
-		world::model& ship = world::model_get(data::ship_index);
-		ship.update_orientation();
+		if (sdl::is_key_up("P")) {
+			data::show_profiler = !data::show_profiler;
+		}
+
+		if (sdl::is_key_up("R")) {
+			data::show_render_stats = !data::show_render_stats;
+		}
+
+		if (sdl::is_key_up("G")) {
+			data::show_gl_calls = !data::show_gl_calls;
+		}
+
+		if (sdl::is_key_up("F9")) {
+			trace_capture::capture_next_frames(data::capture_frames);
+		}
+
+		// the first snapshot is written as soon as everything has been loaded, it is only tried once
+		if (data::use_snapshot && !data::snapshot_saved && !streaming::is_loading()) {
+			save_snapshot();
+			data::snapshot_saved = true;
+		}
+
+		// the ship is there once 'stream_snapshot' is done
+		if (!world::model_valid(data::ship)) {
+			return;
+		}
+
+		world::model& ship = world::model_get(data::ship);
 
 		//control_camera(data::main_camera/*, ship*/);
-		control_ship(ship);
+		if (data::steer_ship) {
+			control_ship(ship);
+		}
+
+		// recalculate the matrices of everything that moved this frame
+		world::update_transforms();
 	}
 
 	void on_draw() {
-		world::model& ship = world::model_get(data::ship_index);
-		world::model& cubes = world::model_get(data::cube_index);
+		PROFILE_ZONE("game on_draw");
+
+		if (!world::model_valid(data::ship) || !world::model_valid(data::cube)) {
+			streaming::show_progress();
+			return;
+		}
+
+		world::model& ship = world::model_get(data::ship);
+		world::model& cubes = world::model_get(data::cube);
+
+		camera& view = data::view_camera != nullptr ? *data::view_camera : data::main_camera;
 
 		// TODO: draw something...
-		opengl::draw_instanced(data::main_camera, cubes, data::locations.size());
-		opengl::draw(data::main_camera, ship);
+		if (!data::locations.empty()) {
+			GPU_PASS("asteroids");
+			opengl::draw_instanced(view, cubes, data::locations.size(), data::instance_buffer);
+		}
+
+		{
+			GPU_PASS("ship");
+			opengl::draw(view, ship);
+		}
+
+		{
+			GPU_PASS("fleet");
+			opengl::draw_instances(view);
+		}
+
+		streaming::show_progress();
 
 		//gui::show_demo();
 		//bool show_me = true;
 		//gui::show_logs(show_me);
 		show_loc_rot_gui(ship, data::show_ship_ui);
+		profiler::show_window(data::show_profiler);
+		render_stats::show_window(data::show_render_stats);
+		gl_intercept::show_window(data::show_gl_calls);
 
 		
 	}
+
+	// called once after the last frame, the snapshot is updated so a restart continues from here
+	void on_quit() {
+		if (data::use_snapshot) {
+			save_snapshot();
+		}
+	}
 }
\ No newline at end of file
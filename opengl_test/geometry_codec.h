@@ -0,0 +1,190 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define GEOMETRY_CODEC_SSE2
+#endif
+
+#include "lz.h"
+
+// a lossless codec for vertex and index streams.
+// a stream is a list of records made of 32 bit words, like a vertex of floats or a single index.
+// every word is stored as the zigzag encoded difference to the same word of the record before it, and the bytes of
+// those differences are transposed into planes: the lowest bytes of every record, then the second bytes and so on.
+// smooth data turns into planes that are mostly zero, which the LZ pass on top compresses well.
+namespace codec {
+
+	namespace detail {
+
+		std::uint32_t zigzag(std::uint32_t delta) {
+			return (delta << 1) ^ static_cast<std::uint32_t>(static_cast<std::int32_t>(delta) >> 31);
+		}
+
+		std::uint32_t unzigzag(std::uint32_t value) {
+			return (value >> 1) ^ (0u - (value & 1u));
+		}
+
+		// splits 'count' records of 'lanes' words into 4 byte planes per lane
+		void transpose(const std::uint32_t* words, std::size_t count, std::size_t lanes, unsigned char* planes) {
+
+			for (std::size_t lane = 0; lane < lanes; lane++) {
+
+				unsigned char* plane = planes + lane * 4llu * count;
+				std::uint32_t previous = 0u;
+
+				for (std::size_t i = 0; i < count; i++) {
+					std::uint32_t word = words[i * lanes + lane];
+					std::uint32_t value = zigzag(word - previous);
+					previous = word;
+
+					plane[i] = static_cast<unsigned char>(value);
+					plane[count + i] = static_cast<unsigned char>(value >> 8);
+					plane[2llu * count + i] = static_cast<unsigned char>(value >> 16);
+					plane[3llu * count + i] = static_cast<unsigned char>(value >> 24);
+				}
+			}
+		}
+
+		// the inverse of 'transpose'.
+		// records are restored a block at a time, so the block of the output every lane writes to stays in the cache.
+		void untranspose(const unsigned char* planes, std::size_t count, std::size_t lanes, std::uint32_t* words) {
+
+			constexpr std::size_t block_size = 256llu;
+
+			std::vector<std::uint32_t> previous(lanes, 0u);
+
+			for (std::size_t first = 0; first < count; first += block_size) {
+
+				std::size_t last = std::min(first + block_size, count);
+
+				for (std::size_t lane = 0; lane < lanes; lane++) {
+
+					const unsigned char* p0 = planes + lane * 4llu * count;
+					const unsigned char* p1 = p0 + count;
+					const unsigned char* p2 = p1 + count;
+					const unsigned char* p3 = p2 + count;
+
+					std::uint32_t* output = words + lane;
+					std::uint32_t sum = previous[lane];
+					std::size_t i = first;
+
+#ifdef GEOMETRY_CODEC_SSE2
+					// 16 records per step: interleave the planes back into words, undo the zigzag and sum up the differences
+					__m128i carry = _mm_set1_epi32(static_cast<int>(sum));
+					const __m128i one = _mm_set1_epi32(1);
+
+					alignas(16) std::uint32_t block[16];
+
+					for (; i + 16llu <= last; i += 16llu) {
+
+						__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + i));
+						__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + i));
+						__m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2 + i));
+						__m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p3 + i));
+
+						__m128i low01 = _mm_unpacklo_epi8(b0, b1);
+						__m128i high01 = _mm_unpackhi_epi8(b0, b1);
+						__m128i low23 = _mm_unpacklo_epi8(b2, b3);
+						__m128i high23 = _mm_unpackhi_epi8(b2, b3);
+
+						__m128i values[4] = {
+							_mm_unpacklo_epi16(low01, low23),
+							_mm_unpackhi_epi16(low01, low23),
+							_mm_unpacklo_epi16(high01, high23),
+							_mm_unpackhi_epi16(high01, high23)
+						};
+
+						for (int k = 0; k < 4; k++) {
+							__m128i v = values[k];
+
+							// (v >> 1) ^ -(v & 1)
+							v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(v, one)));
+
+							// inclusive prefix sum of the 4 differences, continued from the last word of the previous step
+							v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+							v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+							v = _mm_add_epi32(v, carry);
+							carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+
+							_mm_store_si128(reinterpret_cast<__m128i*>(block + k * 4), v);
+						}
+
+						if (lanes == 1llu) {
+							std::memcpy(output + i, block, sizeof(block));
+						}
+						else {
+							for (std::size_t k = 0; k < 16llu; k++) {
+								output[(i + k) * lanes] = block[k];
+							}
+						}
+					}
+
+					sum = static_cast<std::uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+
+					for (; i < last; i++) {
+						std::uint32_t value = p0[i] | (p1[i] << 8) | (p2[i] << 16) | (static_cast<std::uint32_t>(p3[i]) << 24);
+						sum += unzigzag(value);
+						output[i * lanes] = sum;
+					}
+
+					previous[lane] = sum;
+				}
+			}
+		}
+
+		void encode_words(const std::uint32_t* words, std::size_t count, std::size_t lanes, std::vector<char>& output) {
+
+			std::vector<unsigned char> planes(count * lanes * 4llu);
+			transpose(words, count, lanes, planes.data());
+
+			lz::compress(planes.data(), planes.size(), output);
+		}
+
+		bool decode_words(const char* input, std::size_t size, std::uint32_t* words, std::size_t count, std::size_t lanes) {
+
+			// decoding happens for every mesh that is loaded, keep the scratch memory around
+			thread_local std::vector<unsigned char> planes;
+			planes.resize(count * lanes * 4llu);
+
+			if (!lz::decompress(input, size, planes.data(), planes.size())) {
+				return false;
+			}
+
+			untranspose(planes.data(), count, lanes, words);
+			return true;
+		}
+	}
+
+	// encodes 'count' indices into 'output', replacing its contents
+	void encode_indices(const std::uint32_t* indices, std::size_t count, std::vector<char>& output) {
+		detail::encode_words(indices, count, 1llu, output);
+	}
+
+	// decodes 'count' indices written by 'encode_indices', returns false when 'input' is corrupt
+	bool decode_indices(const char* input, std::size_t size, std::uint32_t* indices, std::size_t count) {
+		return detail::decode_words(input, size, indices, count, 1llu);
+	}
+
+	// encodes 'count' verticies of 'stride' bytes into 'output', replacing its contents.
+	// 'stride' has to be a multiple of 4, every attribute is treated as 32 bit words.
+	void encode_verticies(const void* verticies, std::size_t count, std::size_t stride, std::vector<char>& output) {
+
+		std::vector<std::uint32_t> words(count * stride / 4llu);
+		std::memcpy(words.data(), verticies, words.size() * sizeof(std::uint32_t));
+
+		detail::encode_words(words.data(), count, stride / 4llu, output);
+	}
+
+	// decodes 'count' verticies written by 'encode_verticies' with the same 'stride', returns false when 'input' is corrupt
+	bool decode_verticies(const char* input, std::size_t size, void* verticies, std::size_t count, std::size_t stride) {
+
+		// the words are written straight into the verticies, which only have to be aligned like floats
+		return detail::decode_words(input, size, static_cast<std::uint32_t*>(verticies), count, stride / 4llu);
+	}
+}
\ No newline at end of file
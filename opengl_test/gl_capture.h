@@ -0,0 +1,1306 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <unordered_map>
+#include <functional>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "print.h"
+#include "mapped_file.h"
+#include "profiler.h"
+
+// records the GL calls of the first frames into a file, with the bytes of every buffer and texture upload, and plays
+// them back against another context to time them. a performance problem can be reproduced without the assets and the
+// input that caused it, and the cost of the driver can be compared between drivers and machines.
+//
+// the recorder replaces the function pointers of glad, like 'gl_intercept'. it starts when the context is created, so
+// every object the frames use is created in the file, and it stops after the requested amount of frames.
+// the names of objects and the locations of uniforms are mapped to the ones the replaying context hands out.
+// an upload with the same bytes as the last upload into the same buffer only stores that it repeats.
+//
+// only the GL functions the renderer and the ImGui backend call are recorded, textures are expected without row padding.
+namespace gl_capture {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	constexpr char file_magic[8] = "GLCAPT";
+	constexpr std::uint32_t file_version = 1u;
+
+	struct file_header {
+		char magic[8]{};
+		std::uint32_t version = 0u;
+		std::uint32_t frames = 0u;
+		std::uint64_t commands = 0llu;
+	};
+
+	// the kinds of GL objects, a name is mapped within its kind
+	enum class name_kind : std::uint8_t {
+		buffer = 0,
+		texture,
+		vertex_array,
+		// programs and shaders share their names
+		program,
+		query,
+		sampler,
+		count
+	};
+
+	// how the arguments of a call are recorded and played back
+
+	// copied as it is
+	struct value {};
+
+	// a pointer that is an offset into the bound buffer, like the indices of a draw
+	struct offset {};
+
+	// a pointer the call writes its answer to, it is not recorded
+	struct output {};
+
+	// the name of a GL object
+	template<name_kind kind>
+	struct name {};
+
+	// the location of a uniform of the program in use
+	struct location {};
+
+	// the location of a vertex attribute
+	struct attribute {};
+
+	// the program of glUseProgram, the uniforms after it belong to it
+	struct use_program {};
+
+	// the target and buffer of a binding, the recorder keeps track of what is bound for glBufferData
+	struct target {};
+	struct bound_buffer {};
+
+	template<typename... Kinds>
+	struct kinds {};
+
+	// the bytes of an upload
+	enum class upload : std::uint8_t {
+		none = 0,
+		bytes,
+		// the same bytes as the last upload into the same buffer
+		repeat
+	};
+
+	struct last_upload {
+		std::int64_t offset = -1ll;
+		std::vector<unsigned char> bytes;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// set before the context is created, see 'capture_first_frames'
+		std::size_t requested_frames = 0llu;
+		std::string path;
+
+		bool recording = false;
+		std::ofstream output;
+		std::uint32_t frames = 0u;
+		std::uint64_t commands = 0llu;
+		std::uint64_t stored_bytes = 0llu;
+		std::uint64_t repeated_bytes = 0llu;
+
+		// what is bound to every buffer target while recording
+		GLenum pending_target = 0u;
+		std::unordered_map<GLenum, GLuint> bound_buffers;
+
+		// by the name of the buffer in the recording, the player keeps the same
+		std::unordered_map<GLuint, last_upload> last_uploads;
+
+		// puts the pointers of glad back, in the reverse order they were replaced
+		std::vector<void(*)()> uninstalls;
+	}
+	// ============================================================================================================================
+
+	namespace detail {
+
+		// the state of the player
+		struct player {
+			std::string_view input;
+			bool ok = true;
+
+			std::array<std::unordered_map<GLuint, GLuint>, static_cast<std::size_t>(name_kind::count)> names;
+
+			// by the program in the recording and the location in the recording
+			std::unordered_map<std::uint64_t, GLint> locations;
+			std::unordered_map<GLint, GLint> attributes;
+			GLuint current_program = 0u;
+
+			// what the getters write to
+			alignas(16) std::array<unsigned char, 1024> answers{};
+
+			// the arguments that are copied out of the file, so they are aligned
+			std::vector<std::uint64_t> scratch;
+		};
+
+		player playing;
+
+		// ========================================================================================================================
+		// recording
+
+		void write_bytes(const void* bytes, std::size_t size) {
+			data::output.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+		}
+
+		template<typename T>
+		void write(const T& value) {
+			write_bytes(&value, sizeof(T));
+		}
+
+		void write_string(std::string_view text) {
+			write(static_cast<std::uint64_t>(text.size()));
+			write_bytes(text.data(), text.size());
+		}
+
+		// 'buffer' is the name of the buffer in the recording
+		void write_upload(GLuint buffer, std::int64_t offset, std::size_t size, const void* bytes) {
+
+			if (bytes == nullptr || size == 0llu) {
+				write(upload::none);
+				return;
+			}
+
+			auto& last = data::last_uploads[buffer];
+
+			if (last.offset == offset && last.bytes.size() == size && std::memcmp(last.bytes.data(), bytes, size) == 0) {
+				write(upload::repeat);
+				data::repeated_bytes += size;
+				return;
+			}
+
+			write(upload::bytes);
+			write_bytes(bytes, size);
+			data::stored_bytes += size;
+
+			last.offset = offset;
+			last.bytes.assign(static_cast<const unsigned char*>(bytes), static_cast<const unsigned char*>(bytes) + size);
+		}
+
+		template<typename Op>
+		void begin_command(Op code) {
+			write(static_cast<std::uint16_t>(code));
+			data::commands++;
+		}
+
+		template<typename Arg>
+		void write_arg(value, Arg arg) {
+			write(arg);
+		}
+
+		template<typename Arg>
+		void write_arg(offset, Arg arg) {
+			write(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(arg)));
+		}
+
+		template<typename Arg>
+		void write_arg(output, Arg) {
+		}
+
+		template<name_kind kind, typename Arg>
+		void write_arg(name<kind>, Arg arg) {
+			write(arg);
+		}
+
+		template<typename Arg>
+		void write_arg(location, Arg arg) {
+			write(arg);
+		}
+
+		template<typename Arg>
+		void write_arg(attribute, Arg arg) {
+			write(arg);
+		}
+
+		template<typename Arg>
+		void write_arg(use_program, Arg arg) {
+			write(arg);
+		}
+
+		template<typename Arg>
+		void write_arg(target, Arg arg) {
+			data::pending_target = arg;
+			write(arg);
+		}
+
+		template<typename Arg>
+		void write_arg(bound_buffer, Arg arg) {
+			data::bound_buffers[data::pending_target] = arg;
+			write(arg);
+		}
+
+		// the bytes of a 2D texture upload, the rows are expected to be packed
+		std::size_t texture_bytes(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+
+			std::size_t components = 4llu;
+			switch (format) {
+			case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1llu; break;
+			case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL: components = 2llu; break;
+			case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3llu; break;
+			default: components = 4llu; break;
+			}
+
+			std::size_t component_size = 1llu;
+			switch (type) {
+			case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: component_size = 2llu; break;
+			case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: component_size = 4llu; break;
+			default: component_size = 1llu; break;
+			}
+
+			// the default unpack alignment
+			std::size_t row = (static_cast<std::size_t>(width) * components * component_size + 3llu) / 4llu * 4llu;
+			return row * static_cast<std::size_t>(height);
+		}
+
+		// ========================================================================================================================
+		// playing
+
+		template<typename T>
+		T read() {
+			T output{};
+
+			if (playing.input.size() < sizeof(T)) {
+				playing.ok = false;
+				return output;
+			}
+
+			std::memcpy(&output, playing.input.data(), sizeof(T));
+			playing.input.remove_prefix(sizeof(T));
+			return output;
+		}
+
+		// copies 'size' bytes out of the file, the pointer stays valid until the next call
+		const void* read_bytes(std::size_t size) {
+
+			if (playing.input.size() < size) {
+				playing.ok = false;
+				return nullptr;
+			}
+
+			playing.scratch.resize(size / sizeof(std::uint64_t) + 1llu);
+			std::memcpy(playing.scratch.data(), playing.input.data(), size);
+			playing.input.remove_prefix(size);
+
+			return playing.scratch.data();
+		}
+
+		std::string read_string() {
+			auto size = static_cast<std::size_t>(read<std::uint64_t>());
+
+			if (playing.input.size() < size) {
+				playing.ok = false;
+				return {};
+			}
+
+			std::string output(playing.input.substr(0, size));
+			playing.input.remove_prefix(size);
+			return output;
+		}
+
+		// the bytes of an upload, nullptr for none. 'buffer' is the name of the buffer in the recording.
+		const void* read_upload(GLuint buffer, std::int64_t offset, std::size_t size) {
+
+			auto kind = read<upload>();
+
+			if (kind == upload::none) {
+				return nullptr;
+			}
+
+			auto& last = data::last_uploads[buffer];
+
+			if (kind == upload::repeat) {
+				if (last.offset != offset || last.bytes.size() != size) {
+					playing.ok = false;
+					return nullptr;
+				}
+
+				return last.bytes.data();
+			}
+
+			if (playing.input.size() < size) {
+				playing.ok = false;
+				return nullptr;
+			}
+
+			last.offset = offset;
+			last.bytes.assign(playing.input.data(), playing.input.data() + size);
+			playing.input.remove_prefix(size);
+
+			return last.bytes.data();
+		}
+
+		// names the player does not know, like 0, stay as they are
+		GLuint map_name(name_kind kind, GLuint recorded) {
+			auto& names = playing.names[static_cast<std::size_t>(kind)];
+			auto found = names.find(recorded);
+			return found != names.end() ? found->second : recorded;
+		}
+
+		std::uint64_t location_key(GLuint program, GLint location) {
+			return (static_cast<std::uint64_t>(program) << 32) | static_cast<std::uint32_t>(location);
+		}
+
+		GLint map_location(GLint recorded) {
+			auto found = playing.locations.find(location_key(playing.current_program, recorded));
+			return found != playing.locations.end() ? found->second : recorded;
+		}
+
+		template<typename Arg>
+		Arg read_arg(value) {
+			return read<Arg>();
+		}
+
+		template<typename Arg>
+		Arg read_arg(offset) {
+			return reinterpret_cast<Arg>(static_cast<std::uintptr_t>(read<std::uint64_t>()));
+		}
+
+		template<typename Arg>
+		Arg read_arg(output) {
+			return reinterpret_cast<Arg>(playing.answers.data());
+		}
+
+		template<typename Arg, name_kind kind>
+		Arg read_arg(name<kind>) {
+			return map_name(kind, read<GLuint>());
+		}
+
+		template<typename Arg>
+		Arg read_arg(location) {
+			return map_location(read<GLint>());
+		}
+
+		template<typename Arg>
+		Arg read_arg(attribute) {
+			auto recorded = read<Arg>();
+			auto found = playing.attributes.find(static_cast<GLint>(recorded));
+			return found != playing.attributes.end() ? static_cast<Arg>(found->second) : recorded;
+		}
+
+		template<typename Arg>
+		Arg read_arg(use_program) {
+			playing.current_program = read<GLuint>();
+			return map_name(name_kind::program, playing.current_program);
+		}
+
+		template<typename Arg>
+		Arg read_arg(target) {
+			return read<Arg>();
+		}
+
+		template<typename Arg>
+		Arg read_arg(bound_buffer) {
+			return map_name(name_kind::buffer, read<GLuint>());
+		}
+
+		// ========================================================================================================================
+		// hooks
+
+		// the function glad pointed to before the hook
+		template<auto* pointer>
+		auto& original() {
+			static std::remove_reference_t<decltype(*pointer)> function = nullptr;
+			return function;
+		}
+
+		template<auto* pointer>
+		void restore() {
+			*pointer = original<pointer>();
+		}
+
+		// functions the driver does not have stay as they are
+		template<auto* pointer, typename Function>
+		void install_hook(Function call) {
+			if (*pointer == nullptr) {
+				return;
+			}
+
+			original<pointer>() = *pointer;
+			*pointer = call;
+			data::uninstalls.push_back(&restore<pointer>);
+		}
+
+		// a call whose arguments are recorded as 'Kinds'
+		template<typename Kinds>
+		struct call;
+
+		template<typename... Kinds>
+		struct call<kinds<Kinds...>> {
+
+			template<auto* pointer, auto code, typename Function = std::remove_reference_t<decltype(*pointer)>>
+			struct hook;
+
+			template<auto* pointer, auto code, typename Result, typename... Args>
+			struct hook<pointer, code, Result(APIENTRYP)(Args...)> {
+
+				static_assert(sizeof...(Kinds) == sizeof...(Args), "every argument needs a kind");
+
+				static Result APIENTRY record(Args... args) {
+					begin_command(code);
+					(write_arg(Kinds{}, args), ...);
+
+					return original<pointer>()(args...);
+				}
+
+				static void play() {
+					// the arguments are read in order
+					std::tuple<Args...> args{ read_arg<Args>(Kinds{})... };
+
+					if (playing.ok) {
+						std::apply(*pointer, args);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glGen*, the names are recorded after the call
+		template<name_kind kind>
+		struct gen_names {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLsizei count, GLuint* names) {
+					original<pointer>()(count, names);
+
+					begin_command(code);
+					write(count);
+					write_bytes(names, static_cast<std::size_t>(count) * sizeof(GLuint));
+				}
+
+				static void play() {
+					auto count = read<GLsizei>();
+					auto* recorded = static_cast<const GLuint*>(read_bytes(static_cast<std::size_t>(count) * sizeof(GLuint)));
+
+					if (!playing.ok) {
+						return;
+					}
+
+					std::vector<GLuint> names(recorded, recorded + count);
+					std::vector<GLuint> created(names.size());
+					(*pointer)(count, created.data());
+
+					for (std::size_t i = 0; i < names.size(); i++) {
+						playing.names[static_cast<std::size_t>(kind)][names[i]] = created[i];
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glDelete* of arrays of names
+		template<name_kind kind>
+		struct remove_names {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLsizei count, const GLuint* names) {
+					begin_command(code);
+					write(count);
+					write_bytes(names, static_cast<std::size_t>(count) * sizeof(GLuint));
+
+					original<pointer>()(count, names);
+				}
+
+				static void play() {
+					auto count = read<GLsizei>();
+					auto* recorded = static_cast<const GLuint*>(read_bytes(static_cast<std::size_t>(count) * sizeof(GLuint)));
+
+					if (!playing.ok) {
+						return;
+					}
+
+					auto& names = playing.names[static_cast<std::size_t>(kind)];
+
+					std::vector<GLuint> removed(recorded, recorded + count);
+					for (auto& removed_name : removed) {
+						GLuint recorded_name = removed_name;
+						removed_name = map_name(kind, recorded_name);
+						names.erase(recorded_name);
+					}
+
+					(*pointer)(count, removed.data());
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		struct create_program {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static GLuint APIENTRY record() {
+					GLuint program = original<pointer>()();
+
+					begin_command(code);
+					write(program);
+					return program;
+				}
+
+				static void play() {
+					auto recorded = read<GLuint>();
+
+					if (playing.ok) {
+						playing.names[static_cast<std::size_t>(name_kind::program)][recorded] = (*pointer)();
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		struct create_shader {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static GLuint APIENTRY record(GLenum type) {
+					GLuint shader = original<pointer>()(type);
+
+					begin_command(code);
+					write(type);
+					write(shader);
+					return shader;
+				}
+
+				static void play() {
+					auto type = read<GLenum>();
+					auto recorded = read<GLuint>();
+
+					if (playing.ok) {
+						playing.names[static_cast<std::size_t>(name_kind::program)][recorded] = (*pointer)(type);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		struct shader_source {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+					begin_command(code);
+					write(shader);
+					write(count);
+
+					for (GLsizei i = 0; i < count; i++) {
+						bool terminated = lengths == nullptr || lengths[i] < 0;
+						write_string(terminated ? std::string_view(strings[i]) : std::string_view(strings[i], static_cast<std::size_t>(lengths[i])));
+					}
+
+					original<pointer>()(shader, count, strings, lengths);
+				}
+
+				static void play() {
+					GLuint shader = map_name(name_kind::program, read<GLuint>());
+					auto count = read<GLsizei>();
+
+					std::vector<std::string> sources;
+					for (GLsizei i = 0; i < count && playing.ok; i++) {
+						sources.push_back(read_string());
+					}
+
+					if (!playing.ok) {
+						return;
+					}
+
+					std::vector<const GLchar*> strings;
+					std::vector<GLint> lengths;
+					for (const auto& source : sources) {
+						strings.push_back(source.data());
+						lengths.push_back(static_cast<GLint>(source.size()));
+					}
+
+					(*pointer)(shader, count, strings.data(), lengths.data());
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glGetUniformLocation, the answer is recorded so the locations of the player can be mapped
+		struct uniform_location {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static GLint APIENTRY record(GLuint program, const GLchar* uniform_name) {
+					GLint found = original<pointer>()(program, uniform_name);
+
+					begin_command(code);
+					write(program);
+					write_string(uniform_name);
+					write(found);
+					return found;
+				}
+
+				static void play() {
+					auto program = read<GLuint>();
+					auto uniform_name = read_string();
+					auto recorded = read<GLint>();
+
+					if (playing.ok && recorded >= 0) {
+						playing.locations[location_key(program, recorded)] = (*pointer)(map_name(name_kind::program, program), uniform_name.c_str());
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glGetAttribLocation, like 'uniform_location'
+		struct attribute_location {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static GLint APIENTRY record(GLuint program, const GLchar* attribute_name) {
+					GLint found = original<pointer>()(program, attribute_name);
+
+					begin_command(code);
+					write(program);
+					write_string(attribute_name);
+					write(found);
+					return found;
+				}
+
+				static void play() {
+					auto program = read<GLuint>();
+					auto attribute_name = read_string();
+					auto recorded = read<GLint>();
+
+					if (playing.ok && recorded >= 0) {
+						playing.attributes[recorded] = (*pointer)(map_name(name_kind::program, program), attribute_name.c_str());
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glBufferData, into the buffer bound to 'target'
+		struct buffer_data {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLenum target, GLsizeiptr size, const void* bytes, GLenum usage) {
+					GLuint buffer = data::bound_buffers[target];
+
+					begin_command(code);
+					write(target);
+					write(static_cast<std::int64_t>(size));
+					write(usage);
+					write(buffer);
+					write_upload(buffer, 0ll, static_cast<std::size_t>(size), bytes);
+
+					original<pointer>()(target, size, bytes, usage);
+				}
+
+				static void play() {
+					auto target = read<GLenum>();
+					auto size = read<std::int64_t>();
+					auto usage = read<GLenum>();
+					auto buffer = read<GLuint>();
+					const void* bytes = read_upload(buffer, 0ll, static_cast<std::size_t>(size));
+
+					if (playing.ok) {
+						(*pointer)(target, static_cast<GLsizeiptr>(size), bytes, usage);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glBufferSubData, into the buffer bound to 'target'
+		struct buffer_sub_data {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLenum target, GLintptr offset, GLsizeiptr size, const void* bytes) {
+					GLuint buffer = data::bound_buffers[target];
+
+					begin_command(code);
+					write(target);
+					write(static_cast<std::int64_t>(offset));
+					write(static_cast<std::int64_t>(size));
+					write(buffer);
+					write_upload(buffer, offset, static_cast<std::size_t>(size), bytes);
+
+					original<pointer>()(target, offset, size, bytes);
+				}
+
+				static void play() {
+					auto target = read<GLenum>();
+					auto offset = read<std::int64_t>();
+					auto size = read<std::int64_t>();
+					auto buffer = read<GLuint>();
+					const void* bytes = read_upload(buffer, offset, static_cast<std::size_t>(size));
+
+					if (playing.ok) {
+						(*pointer)(target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), bytes);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		struct named_buffer_data {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLuint buffer, GLsizeiptr size, const void* bytes, GLenum usage) {
+					begin_command(code);
+					write(buffer);
+					write(static_cast<std::int64_t>(size));
+					write(usage);
+					write_upload(buffer, 0ll, static_cast<std::size_t>(size), bytes);
+
+					original<pointer>()(buffer, size, bytes, usage);
+				}
+
+				static void play() {
+					auto buffer = read<GLuint>();
+					auto size = read<std::int64_t>();
+					auto usage = read<GLenum>();
+					const void* bytes = read_upload(buffer, 0ll, static_cast<std::size_t>(size));
+
+					if (playing.ok) {
+						(*pointer)(map_name(name_kind::buffer, buffer), static_cast<GLsizeiptr>(size), bytes, usage);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		struct named_buffer_sub_data {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* bytes) {
+					begin_command(code);
+					write(buffer);
+					write(static_cast<std::int64_t>(offset));
+					write(static_cast<std::int64_t>(size));
+					write_upload(buffer, offset, static_cast<std::size_t>(size), bytes);
+
+					original<pointer>()(buffer, offset, size, bytes);
+				}
+
+				static void play() {
+					auto buffer = read<GLuint>();
+					auto offset = read<std::int64_t>();
+					auto size = read<std::int64_t>();
+					const void* bytes = read_upload(buffer, offset, static_cast<std::size_t>(size));
+
+					if (playing.ok) {
+						(*pointer)(map_name(name_kind::buffer, buffer), static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), bytes);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		struct tex_image_2d {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLenum texture_target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+					begin_command(code);
+					write(texture_target);
+					write(level);
+					write(internal_format);
+					write(width);
+					write(height);
+					write(border);
+					write(format);
+					write(type);
+
+					std::size_t size = texture_bytes(width, height, format, type);
+					write(static_cast<std::uint64_t>(pixels != nullptr ? size : 0llu));
+
+					if (pixels != nullptr) {
+						write_bytes(pixels, size);
+						data::stored_bytes += size;
+					}
+
+					original<pointer>()(texture_target, level, internal_format, width, height, border, format, type, pixels);
+				}
+
+				static void play() {
+					auto texture_target = read<GLenum>();
+					auto level = read<GLint>();
+					auto internal_format = read<GLint>();
+					auto width = read<GLsizei>();
+					auto height = read<GLsizei>();
+					auto border = read<GLint>();
+					auto format = read<GLenum>();
+					auto type = read<GLenum>();
+					auto size = static_cast<std::size_t>(read<std::uint64_t>());
+					const void* pixels = size > 0llu ? read_bytes(size) : nullptr;
+
+					if (playing.ok) {
+						(*pointer)(texture_target, level, internal_format, width, height, border, format, type, pixels);
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glUniform*fv with 'components' floats per element
+		template<std::size_t components>
+		struct uniform_vector {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLint uniform, GLsizei count, const GLfloat* values) {
+					begin_command(code);
+					write(uniform);
+					write(count);
+					write_bytes(values, static_cast<std::size_t>(count) * components * sizeof(GLfloat));
+
+					original<pointer>()(uniform, count, values);
+				}
+
+				static void play() {
+					GLint uniform = map_location(read<GLint>());
+					auto count = read<GLsizei>();
+					const void* values = read_bytes(static_cast<std::size_t>(count) * components * sizeof(GLfloat));
+
+					if (playing.ok) {
+						(*pointer)(uniform, count, static_cast<const GLfloat*>(values));
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+
+		// glUniformMatrix*fv with 'components' floats per matrix
+		template<std::size_t components>
+		struct uniform_matrix {
+
+			template<auto* pointer, auto code>
+			struct hook {
+
+				static void APIENTRY record(GLint uniform, GLsizei count, GLboolean transpose, const GLfloat* values) {
+					begin_command(code);
+					write(uniform);
+					write(count);
+					write(transpose);
+					write_bytes(values, static_cast<std::size_t>(count) * components * sizeof(GLfloat));
+
+					original<pointer>()(uniform, count, transpose, values);
+				}
+
+				static void play() {
+					GLint uniform = map_location(read<GLint>());
+					auto count = read<GLsizei>();
+					auto transpose = read<GLboolean>();
+					const void* values = read_bytes(static_cast<std::size_t>(count) * components * sizeof(GLfloat));
+
+					if (playing.ok) {
+						(*pointer)(uniform, count, transpose, static_cast<const GLfloat*>(values));
+					}
+				}
+
+				static void install() {
+					install_hook<pointer>(&record);
+				}
+			};
+		};
+	}
+
+	// every recorded function and how it is recorded.
+	// new entries go at the end, the position of a function is its command in the file.
+#define GL_CAPTURE_FUNCTIONS(X) \
+	X(glActiveTexture, call<kinds<value>>) \
+	X(glBindBuffer, call<kinds<target, bound_buffer>>) \
+	X(glBindBufferBase, call<kinds<target, value, bound_buffer>>) \
+	X(glBindBufferRange, call<kinds<target, value, bound_buffer, value, value>>) \
+	X(glBindSampler, call<kinds<value, name<name_kind::sampler>>>) \
+	X(glBindTexture, call<kinds<value, name<name_kind::texture>>>) \
+	X(glBindVertexArray, call<kinds<name<name_kind::vertex_array>>>) \
+	X(glBlendEquation, call<kinds<value>>) \
+	X(glBlendEquationSeparate, call<kinds<value, value>>) \
+	X(glBlendFunc, call<kinds<value, value>>) \
+	X(glBlendFuncSeparate, call<kinds<value, value, value, value>>) \
+	X(glClear, call<kinds<value>>) \
+	X(glClearColor, call<kinds<value, value, value, value>>) \
+	X(glClipControl, call<kinds<value, value>>) \
+	X(glDisable, call<kinds<value>>) \
+	X(glEnable, call<kinds<value>>) \
+	X(glPolygonMode, call<kinds<value, value>>) \
+	X(glPixelStorei, call<kinds<value, value>>) \
+	X(glScissor, call<kinds<value, value, value, value>>) \
+	X(glViewport, call<kinds<value, value, value, value>>) \
+	X(glFinish, call<kinds<>>) \
+	X(glFlush, call<kinds<>>) \
+	X(glDrawElements, call<kinds<value, value, value, offset>>) \
+	X(glDrawElementsBaseVertex, call<kinds<value, value, value, offset, value>>) \
+	X(glDrawElementsInstancedBaseVertex, call<kinds<value, value, value, offset, value, value>>) \
+	X(glEnableVertexAttribArray, call<kinds<attribute>>) \
+	X(glVertexAttribPointer, call<kinds<attribute, value, value, value, value, offset>>) \
+	X(glUseProgram, call<kinds<use_program>>) \
+	X(glCreateProgram, create_program) \
+	X(glCreateShader, create_shader) \
+	X(glShaderSource, shader_source) \
+	X(glCompileShader, call<kinds<name<name_kind::program>>>) \
+	X(glAttachShader, call<kinds<name<name_kind::program>, name<name_kind::program>>>) \
+	X(glDetachShader, call<kinds<name<name_kind::program>, name<name_kind::program>>>) \
+	X(glLinkProgram, call<kinds<name<name_kind::program>>>) \
+	X(glDeleteShader, call<kinds<name<name_kind::program>>>) \
+	X(glDeleteProgram, call<kinds<name<name_kind::program>>>) \
+	X(glGetUniformLocation, uniform_location) \
+	X(glGetAttribLocation, attribute_location) \
+	X(glUniform1f, call<kinds<location, value>>) \
+	X(glUniform1i, call<kinds<location, value>>) \
+	X(glUniform1ui, call<kinds<location, value>>) \
+	X(glUniform2fv, uniform_vector<2>) \
+	X(glUniform3fv, uniform_vector<3>) \
+	X(glUniform4fv, uniform_vector<4>) \
+	X(glUniformMatrix2fv, uniform_matrix<4>) \
+	X(glUniformMatrix2x3fv, uniform_matrix<6>) \
+	X(glUniformMatrix2x4fv, uniform_matrix<8>) \
+	X(glUniformMatrix3fv, uniform_matrix<9>) \
+	X(glUniformMatrix3x2fv, uniform_matrix<6>) \
+	X(glUniformMatrix3x4fv, uniform_matrix<12>) \
+	X(glUniformMatrix4fv, uniform_matrix<16>) \
+	X(glUniformMatrix4x2fv, uniform_matrix<8>) \
+	X(glUniformMatrix4x3fv, uniform_matrix<12>) \
+	X(glGenBuffers, gen_names<name_kind::buffer>) \
+	X(glDeleteBuffers, remove_names<name_kind::buffer>) \
+	X(glBufferData, buffer_data) \
+	X(glBufferSubData, buffer_sub_data) \
+	X(glNamedBufferData, named_buffer_data) \
+	X(glNamedBufferSubData, named_buffer_sub_data) \
+	X(glGenVertexArrays, gen_names<name_kind::vertex_array>) \
+	X(glDeleteVertexArrays, remove_names<name_kind::vertex_array>) \
+	X(glGenTextures, gen_names<name_kind::texture>) \
+	X(glDeleteTextures, remove_names<name_kind::texture>) \
+	X(glTexImage2D, tex_image_2d) \
+	X(glTexParameteri, call<kinds<value, value, value>>) \
+	X(glGenerateMipmap, call<kinds<value>>) \
+	X(glGenQueries, gen_names<name_kind::query>) \
+	X(glQueryCounter, call<kinds<name<name_kind::query>, value>>) \
+	X(glGetQueryObjectiv, call<kinds<name<name_kind::query>, value, output>>) \
+	X(glGetQueryObjectui64v, call<kinds<name<name_kind::query>, value, output>>) \
+	X(glGetError, call<kinds<>>) \
+	X(glGetIntegerv, call<kinds<value, output>>) \
+	X(glGetInteger64v, call<kinds<value, output>>) \
+	X(glGetProgramiv, call<kinds<name<name_kind::program>, value, output>>) \
+	X(glGetShaderiv, call<kinds<name<name_kind::program>, value, output>>) \
+	X(glIsBuffer, call<kinds<name<name_kind::buffer>>>) \
+	X(glIsEnabled, call<kinds<value>>) \
+	X(glIsProgram, call<kinds<name<name_kind::program>>>) \
+	X(glIsShader, call<kinds<name<name_kind::program>>>) \
+	X(glIsTexture, call<kinds<name<name_kind::texture>>>)
+
+#define GL_CAPTURE_COMMAND(function, ...) function##_command,
+
+	// a recorded function, or a marker of the file
+	enum class command : std::uint16_t {
+		GL_CAPTURE_FUNCTIONS(GL_CAPTURE_COMMAND)
+		end_of_frame,
+		end_of_file,
+		count
+	};
+
+#undef GL_CAPTURE_COMMAND
+
+	// records the first 'frames' frames into 'path', call it before the context is created
+	void capture_first_frames(std::size_t frames, std::string path) {
+		data::requested_frames = frames;
+		data::path = std::move(path);
+	}
+
+	// starts recording when it was requested, call it once after glad loaded the GL functions
+	void install() {
+
+		if (data::requested_frames == 0llu || data::recording) {
+			return;
+		}
+
+		data::output.open(data::path, std::ios::binary | std::ios::trunc);
+		if (!data::output) {
+			print_error("gl_capture could not create: ", data::path);
+			return;
+		}
+
+		// the header is written again with the counts when the recording is done
+		detail::write(file_header{});
+
+		// the function names are only used with ##, glad defines them as macros
+#define GL_CAPTURE_INSTALL(function, ...) detail::__VA_ARGS__::template hook<&glad_##function, command::function##_command>::install();
+		GL_CAPTURE_FUNCTIONS(GL_CAPTURE_INSTALL)
+#undef GL_CAPTURE_INSTALL
+
+		data::recording = true;
+		print_info("gl_capture recording ", data::requested_frames, " frames to ", data::path);
+	}
+
+	// finishes the file and puts the GL functions back, the file covers the frames until now
+	void stop() {
+
+		if (!data::recording) {
+			return;
+		}
+
+		data::recording = false;
+
+		while (!data::uninstalls.empty()) {
+			data::uninstalls.back()();
+			data::uninstalls.pop_back();
+		}
+
+		detail::begin_command(command::end_of_file);
+
+		file_header header;
+		std::memcpy(header.magic, file_magic, sizeof(file_magic));
+		header.version = file_version;
+		header.frames = data::frames;
+		header.commands = data::commands;
+
+		data::output.seekp(0);
+		detail::write(header);
+		data::output.close();
+
+		if (!data::output) {
+			print_error("gl_capture could not write: ", data::path);
+		}
+		else {
+			print_info("gl_capture saved ", data::frames, " frames with ", data::commands, " commands to ", data::path, ", ",
+				data::stored_bytes / (1024llu * 1024llu), " MB of uploads stored, ", data::repeated_bytes / (1024llu * 1024llu), " MB repeated");
+		}
+
+		data::last_uploads.clear();
+		data::bound_buffers.clear();
+	}
+
+	// marks the end of a frame, call it once per frame after the buffers are swapped
+	void end_frame() {
+
+		if (!data::recording) {
+			return;
+		}
+
+		detail::begin_command(command::end_of_frame);
+		data::frames++;
+
+		if (data::frames >= data::requested_frames) {
+			stop();
+		}
+	}
+
+	// ============================================================================================================================
+	// replay
+
+	struct replay_result {
+		std::uint64_t commands = 0llu;
+
+		// everything before the first frame, like creating the programs and uploading the models
+		double setup_ms = 0.0;
+
+		// how long every frame took to submit, and until the GPU finished it
+		std::vector<double> submit_ms;
+		std::vector<double> frame_ms;
+	};
+
+	namespace detail {
+
+		double percentile(std::vector<double> values, double fraction) {
+			if (values.empty()) {
+				return 0.0;
+			}
+
+			std::sort(values.begin(), values.end());
+			auto index = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1llu) + 0.5);
+			return values[std::min<std::size_t>(index, values.size() - 1llu)];
+		}
+
+		double milliseconds_since(std::uint64_t start) {
+			return static_cast<double>(profiler::now() - start) / 1000000.0;
+		}
+	}
+
+	// plays the recording at 'path' against the current context. 'present' is called after every frame, like swapping
+	// the buffers of a window. every frame waits for the GPU with glFinish, so the frames are timed one by one.
+	bool replay(const char* path, const std::function<void()>& present, replay_result& result) {
+
+		PROFILE_ZONE("gl_capture replay");
+
+		io::mapped_file file;
+		if (!file.open(path)) {
+			print_error("gl_capture could not open: ", path);
+			return false;
+		}
+
+		std::string_view input = file.view();
+
+		file_header header;
+		if (input.size() < sizeof(header)) {
+			print_error("gl_capture too small to be a recording: ", path);
+			return false;
+		}
+
+		std::memcpy(&header, input.data(), sizeof(header));
+		input.remove_prefix(sizeof(header));
+
+		if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version) {
+			print_error("gl_capture not a recording or of an unsupported version: ", path);
+			return false;
+		}
+
+		static constexpr std::array<void(*)(), static_cast<std::size_t>(command::count)> players{ {
+#define GL_CAPTURE_PLAYER(function, ...) &detail::__VA_ARGS__::template hook<&glad_##function, command::function##_command>::play,
+			GL_CAPTURE_FUNCTIONS(GL_CAPTURE_PLAYER)
+#undef GL_CAPTURE_PLAYER
+			nullptr,
+			nullptr
+		} };
+
+		detail::playing = {};
+		detail::playing.input = input;
+		data::last_uploads.clear();
+
+		result = {};
+		result.submit_ms.reserve(header.frames);
+		result.frame_ms.reserve(header.frames);
+
+		bool in_setup = true;
+		std::uint64_t start = profiler::now();
+
+		while (detail::playing.ok) {
+
+			auto code = detail::read<std::uint16_t>();
+
+			if (!detail::playing.ok || code >= static_cast<std::uint16_t>(command::count)) {
+				detail::playing.ok = false;
+				break;
+			}
+
+			result.commands++;
+
+			if (code == static_cast<std::uint16_t>(command::end_of_file)) {
+				break;
+			}
+
+			if (code != static_cast<std::uint16_t>(command::end_of_frame)) {
+				players[code]();
+				continue;
+			}
+
+			double submit = detail::milliseconds_since(start);
+
+			present();
+			glFinish();
+
+			if (in_setup) {
+				// the first frame also creates everything, it is counted as setup
+				result.setup_ms = detail::milliseconds_since(start);
+				in_setup = false;
+			}
+			else {
+				result.submit_ms.push_back(submit);
+				result.frame_ms.push_back(detail::milliseconds_since(start));
+			}
+
+			start = profiler::now();
+		}
+
+		data::last_uploads.clear();
+
+		if (!detail::playing.ok) {
+			print_error("gl_capture the recording is broken after ", result.commands, " commands: ", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	// plays the recording at 'path' and prints how long the frames took
+	bool replay(const char* path, const std::function<void()>& present) {
+
+		replay_result result;
+		if (!replay(path, present, result)) {
+			return false;
+		}
+
+		auto mean = [](const std::vector<double>& values) {
+			double total = 0.0;
+			for (double value : values) {
+				total += value;
+			}
+			return values.empty() ? 0.0 : total / static_cast<double>(values.size());
+		};
+
+		print_info("gl_capture replayed ", path, ": ", result.commands, " commands, setup and first frame ", result.setup_ms, " ms");
+		print_info("  ", result.frame_ms.size(), " frames in ms: mean ", mean(result.frame_ms), " | p50 ", detail::percentile(result.frame_ms, 0.5),
+			" | p95 ", detail::percentile(result.frame_ms, 0.95), " | p99 ", detail::percentile(result.frame_ms, 0.99),
+			" | max ", detail::percentile(result.frame_ms, 1.0));
+		print_info("  submitting in ms: mean ", mean(result.submit_ms), " | p50 ", detail::percentile(result.submit_ms, 0.5),
+			" | p95 ", detail::percentile(result.submit_ms, 0.95), " | p99 ", detail::percentile(result.submit_ms, 0.99),
+			" | max ", detail::percentile(result.submit_ms, 1.0));
+
+		return true;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,349 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "imgui/imgui.h"
+#include "print.h"
+#include "profiler.h"
+
+// a layer over the function pointers of glad that counts and times the GL calls of the program and of the ImGui backend.
+// some calls make the CPU wait for the driver or the GPU, like glGet*, glIs* and glFinish. when one of them is made while
+// frames are running it is reported once for the profiler zone it was made in, so hidden stalls show up without reading
+// the code for them.
+//
+// only debug builds have it, define DISABLE_GL_INTERCEPT to leave it out of those too.
+// the calls are only counted on the thread with the GL context.
+#if defined(DEBUG) && !defined(DISABLE_GL_INTERCEPT)
+#define GL_INTERCEPT
+#endif
+
+namespace gl_intercept {
+
+#ifdef GL_INTERCEPT
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	struct function_stats {
+		const char* name = nullptr;
+
+		// the call waits for the driver or the GPU to answer
+		bool sync = false;
+
+		std::uint64_t calls = 0llu;
+		std::uint64_t nanoseconds = 0llu;
+
+		// the frame that is running and the last frame that is done
+		std::uint64_t frame_calls = 0llu;
+		std::uint64_t frame_nanoseconds = 0llu;
+		std::uint64_t last_calls = 0llu;
+		std::uint64_t last_nanoseconds = 0llu;
+	};
+
+	// a call that waits, made inside of the zone 'zone' while frames are running
+	struct sync_site {
+		std::size_t function = 0llu;
+		const char* zone = nullptr;
+
+		std::uint64_t calls = 0llu;
+		std::uint64_t nanoseconds = 0llu;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		std::vector<function_stats> functions;
+		std::vector<sync_site> sync_sites;
+
+		bool installed = false;
+	}
+	// ============================================================================================================================
+
+	namespace detail {
+
+		std::size_t add_function(const char* name, bool sync) {
+			data::functions.push_back({ name, sync });
+			return data::functions.size() - 1llu;
+		}
+
+		void record_sync(std::size_t function, std::uint64_t nanoseconds) {
+
+			const char* zone = profiler::current_zone();
+
+			for (auto& site : data::sync_sites) {
+				if (site.function == function && site.zone == zone) {
+					site.calls++;
+					site.nanoseconds += nanoseconds;
+					return;
+				}
+			}
+
+			data::sync_sites.push_back({ function, zone, 1llu, nanoseconds });
+			print_info("gl_intercept ", data::functions[function].name, " waits for the driver in zone: ", zone != nullptr ? zone : "none");
+		}
+
+		void record(std::size_t function, std::uint64_t nanoseconds) {
+
+			auto& stats = data::functions[function];
+			stats.calls++;
+			stats.nanoseconds += nanoseconds;
+			stats.frame_calls++;
+			stats.frame_nanoseconds += nanoseconds;
+
+			// the calls of the startup are expected to wait, like reading back the result of compiling a shader
+			if (stats.sync && profiler::data::frame_count > 0llu) {
+				record_sync(function, nanoseconds);
+			}
+		}
+
+		// replaces the glad pointer 'pointer' with 'call', which times the function it replaced
+		template<auto* pointer, typename Function = std::remove_pointer_t<decltype(pointer)>>
+		struct hook;
+
+		template<auto* pointer, typename Result, typename... Args>
+		struct hook<pointer, Result(APIENTRYP)(Args...)> {
+
+			using function_type = Result(APIENTRYP)(Args...);
+
+			static function_type& original() {
+				static function_type function = nullptr;
+				return function;
+			}
+
+			static std::size_t& index() {
+				static std::size_t function = 0llu;
+				return function;
+			}
+
+			static Result APIENTRY call(Args... args) {
+				std::uint64_t start = profiler::now();
+
+				if constexpr (std::is_void_v<Result>) {
+					original()(args...);
+					record(index(), profiler::now() - start);
+				}
+				else {
+					Result result = original()(args...);
+					record(index(), profiler::now() - start);
+					return result;
+				}
+			}
+
+			// functions the driver does not have stay as they are
+			static void install(const char* name, bool sync) {
+				if (*pointer == nullptr || *pointer == &call) {
+					return;
+				}
+
+				index() = add_function(name, sync);
+				original() = *pointer;
+				*pointer = &call;
+			}
+		};
+	}
+
+#define GL_INTERCEPT_HOOK(function, sync) detail::hook<&glad_##function>::install(#function, sync)
+
+	// wraps the GL functions of glad, call it once after glad loaded them
+	void install() {
+
+		if (data::installed) {
+			return;
+		}
+
+		data::installed = true;
+
+		// calls that wait for the driver or the GPU
+		GL_INTERCEPT_HOOK(glFinish, true);
+		GL_INTERCEPT_HOOK(glGetError, true);
+		GL_INTERCEPT_HOOK(glGetIntegerv, true);
+		GL_INTERCEPT_HOOK(glGetInteger64v, true);
+		GL_INTERCEPT_HOOK(glGetProgramiv, true);
+		GL_INTERCEPT_HOOK(glGetProgramInfoLog, true);
+		GL_INTERCEPT_HOOK(glGetShaderiv, true);
+		GL_INTERCEPT_HOOK(glGetShaderInfoLog, true);
+		GL_INTERCEPT_HOOK(glGetUniformLocation, true);
+		GL_INTERCEPT_HOOK(glGetAttribLocation, true);
+		GL_INTERCEPT_HOOK(glGetQueryiv, true);
+		GL_INTERCEPT_HOOK(glGetQueryObjectiv, true);
+		GL_INTERCEPT_HOOK(glGetQueryObjectui64v, true);
+		GL_INTERCEPT_HOOK(glIsBuffer, true);
+		GL_INTERCEPT_HOOK(glIsEnabled, true);
+		GL_INTERCEPT_HOOK(glIsProgram, true);
+		GL_INTERCEPT_HOOK(glIsShader, true);
+		GL_INTERCEPT_HOOK(glIsTexture, true);
+		GL_INTERCEPT_HOOK(glReadPixels, true);
+		GL_INTERCEPT_HOOK(glMapBuffer, true);
+		GL_INTERCEPT_HOOK(glMapBufferRange, true);
+		GL_INTERCEPT_HOOK(glMapNamedBuffer, true);
+		GL_INTERCEPT_HOOK(glClientWaitSync, true);
+		GL_INTERCEPT_HOOK(glCheckFramebufferStatus, true);
+
+		// draws and state
+		GL_INTERCEPT_HOOK(glDrawElements, false);
+		GL_INTERCEPT_HOOK(glDrawElementsBaseVertex, false);
+		GL_INTERCEPT_HOOK(glDrawElementsInstancedBaseVertex, false);
+		GL_INTERCEPT_HOOK(glClear, false);
+		GL_INTERCEPT_HOOK(glClearColor, false);
+		GL_INTERCEPT_HOOK(glViewport, false);
+		GL_INTERCEPT_HOOK(glScissor, false);
+		GL_INTERCEPT_HOOK(glEnable, false);
+		GL_INTERCEPT_HOOK(glDisable, false);
+		GL_INTERCEPT_HOOK(glBlendEquation, false);
+		GL_INTERCEPT_HOOK(glBlendEquationSeparate, false);
+		GL_INTERCEPT_HOOK(glBlendFunc, false);
+		GL_INTERCEPT_HOOK(glBlendFuncSeparate, false);
+		GL_INTERCEPT_HOOK(glPolygonMode, false);
+		GL_INTERCEPT_HOOK(glClipControl, false);
+		GL_INTERCEPT_HOOK(glPixelStorei, false);
+		GL_INTERCEPT_HOOK(glFlush, false);
+		GL_INTERCEPT_HOOK(glQueryCounter, false);
+		GL_INTERCEPT_HOOK(glGenQueries, false);
+
+		// programs and uniforms
+		GL_INTERCEPT_HOOK(glUseProgram, false);
+		GL_INTERCEPT_HOOK(glCreateProgram, false);
+		GL_INTERCEPT_HOOK(glCreateShader, false);
+		GL_INTERCEPT_HOOK(glShaderSource, false);
+		GL_INTERCEPT_HOOK(glCompileShader, false);
+		GL_INTERCEPT_HOOK(glAttachShader, false);
+		GL_INTERCEPT_HOOK(glDetachShader, false);
+		GL_INTERCEPT_HOOK(glLinkProgram, false);
+		GL_INTERCEPT_HOOK(glDeleteShader, false);
+		GL_INTERCEPT_HOOK(glDeleteProgram, false);
+		GL_INTERCEPT_HOOK(glUniform1f, false);
+		GL_INTERCEPT_HOOK(glUniform1i, false);
+		GL_INTERCEPT_HOOK(glUniform1ui, false);
+		GL_INTERCEPT_HOOK(glUniform2fv, false);
+		GL_INTERCEPT_HOOK(glUniform3fv, false);
+		GL_INTERCEPT_HOOK(glUniform4fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix2fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix2x3fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix2x4fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix3fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix3x2fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix3x4fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix4fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix4x2fv, false);
+		GL_INTERCEPT_HOOK(glUniformMatrix4x3fv, false);
+
+		// buffers, vertex arrays and textures
+		GL_INTERCEPT_HOOK(glGenBuffers, false);
+		GL_INTERCEPT_HOOK(glDeleteBuffers, false);
+		GL_INTERCEPT_HOOK(glBindBuffer, false);
+		GL_INTERCEPT_HOOK(glBindBufferBase, false);
+		GL_INTERCEPT_HOOK(glBindBufferRange, false);
+		GL_INTERCEPT_HOOK(glBufferData, false);
+		GL_INTERCEPT_HOOK(glBufferSubData, false);
+		GL_INTERCEPT_HOOK(glNamedBufferData, false);
+		GL_INTERCEPT_HOOK(glNamedBufferSubData, false);
+		GL_INTERCEPT_HOOK(glGenVertexArrays, false);
+		GL_INTERCEPT_HOOK(glDeleteVertexArrays, false);
+		GL_INTERCEPT_HOOK(glBindVertexArray, false);
+		GL_INTERCEPT_HOOK(glEnableVertexAttribArray, false);
+		GL_INTERCEPT_HOOK(glVertexAttribPointer, false);
+		GL_INTERCEPT_HOOK(glGenTextures, false);
+		GL_INTERCEPT_HOOK(glDeleteTextures, false);
+		GL_INTERCEPT_HOOK(glActiveTexture, false);
+		GL_INTERCEPT_HOOK(glBindTexture, false);
+		GL_INTERCEPT_HOOK(glBindSampler, false);
+		GL_INTERCEPT_HOOK(glTexImage2D, false);
+		GL_INTERCEPT_HOOK(glTexParameteri, false);
+		GL_INTERCEPT_HOOK(glGenerateMipmap, false);
+
+		print_info("gl_intercept wraps ", data::functions.size(), " GL functions");
+	}
+
+#undef GL_INTERCEPT_HOOK
+
+	// finishes the counts of a frame, call it once per frame after the last GL call
+	void end_frame() {
+		for (auto& stats : data::functions) {
+			stats.last_calls = stats.frame_calls;
+			stats.last_nanoseconds = stats.frame_nanoseconds;
+			stats.frame_calls = 0llu;
+			stats.frame_nanoseconds = 0llu;
+		}
+	}
+
+	// shows the calls of the last frame, the most expensive first, and every place a call waited
+	void show_window(bool& show) {
+
+		if (!show) {
+			return;
+		}
+
+		ImGui::Begin("GL calls", &show);
+
+		std::vector<const function_stats*> sorted;
+		for (const auto& stats : data::functions) {
+			if (stats.calls > 0llu) {
+				sorted.push_back(&stats);
+			}
+		}
+
+		std::sort(sorted.begin(), sorted.end(), [](const function_stats* a, const function_stats* b) {
+			return a->last_nanoseconds > b->last_nanoseconds;
+		});
+
+		ImGui::Text("last frame");
+
+		ImGui::Columns(4);
+		ImGui::Text("function"); ImGui::NextColumn();
+		ImGui::Text("calls"); ImGui::NextColumn();
+		ImGui::Text("ms"); ImGui::NextColumn();
+		ImGui::Text("total calls"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (const auto* stats : sorted) {
+			if (stats->sync) {
+				ImGui::TextColored(ImVec4(1.f, 0.6f, 0.2f, 1.f), "%s", stats->name);
+			}
+			else {
+				ImGui::Text("%s", stats->name);
+			}
+			ImGui::NextColumn();
+
+			ImGui::Text("%llu", static_cast<unsigned long long>(stats->last_calls)); ImGui::NextColumn();
+			ImGui::Text("%.3f", static_cast<double>(stats->last_nanoseconds) / 1000000.0); ImGui::NextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(stats->calls)); ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+		ImGui::Separator();
+
+		ImGui::Text("calls that waited while frames were running");
+
+		ImGui::Columns(4);
+		ImGui::Text("function"); ImGui::NextColumn();
+		ImGui::Text("zone"); ImGui::NextColumn();
+		ImGui::Text("calls"); ImGui::NextColumn();
+		ImGui::Text("us per call"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (const auto& site : data::sync_sites) {
+			ImGui::Text("%s", data::functions[site.function].name); ImGui::NextColumn();
+			ImGui::Text("%s", site.zone != nullptr ? site.zone : "none"); ImGui::NextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(site.calls)); ImGui::NextColumn();
+			ImGui::Text("%.2f", static_cast<double>(site.nanoseconds) / static_cast<double>(site.calls) / 1000.0); ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+		ImGui::End();
+	}
+
+#else
+
+	// release builds have no layer, these are left for the callers
+
+	void install() {}
+
+	void end_frame() {}
+
+	void show_window(bool&) {}
+
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,790 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+#include "print.h"
+#include "image.h"
+#include "json.h"
+#include "vfs.h"
+#include "world.h"
+#include "profiler.h"
+
+namespace world {
+
+	namespace gltf {
+
+		// ============================================================================================================================
+		// DATA STRUCTS ===============================================================================================================
+
+		constexpr std::uint32_t glb_magic = 0x46546C67u;		// "glTF"
+		constexpr std::uint32_t glb_json_chunk = 0x4E4F534Au;	// "JSON"
+		constexpr std::uint32_t glb_binary_chunk = 0x004E4942u;	// "BIN\0"
+
+		enum component_type : int {
+			byte_component = 5120,
+			unsigned_byte_component = 5121,
+			short_component = 5122,
+			unsigned_short_component = 5123,
+			unsigned_int_component = 5125,
+			float_component = 5126
+		};
+
+		constexpr int triangles_mode = 4;
+
+		// a parsed glTF document and the memory its buffers live in.
+		// binary buffers are never copied: they are views into the .glb or .bin files as the file layer holds them.
+		struct document {
+			json::value root;
+			std::filesystem::path directory;
+
+			io::file_view file;
+			std::vector<io::file_view> external_files;
+
+			// buffers embedded as base64 data URIs have to be decoded somewhere
+			std::vector<std::string> decoded_buffers;
+
+			std::vector<std::string_view> buffers;
+		};
+
+		// the elements of an accessor, straight from the buffer they are stored in
+		struct accessor_view {
+			const unsigned char* data = nullptr;
+			std::size_t count = 0;
+			std::size_t stride = 0;
+
+			int component_type = 0;
+			int components = 0;
+			bool normalized = false;
+		};
+
+		// ============================================================================================================================
+
+		std::size_t component_size(int type) {
+			switch (type)
+			{
+			case byte_component:
+			case unsigned_byte_component:
+				return 1llu;
+			case short_component:
+			case unsigned_short_component:
+				return 2llu;
+			case unsigned_int_component:
+			case float_component:
+				return 4llu;
+			default:
+				return 0llu;
+			}
+		}
+
+		int component_count(const std::string& type) {
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			if (type == "MAT2") return 4;
+			if (type == "MAT3") return 9;
+			if (type == "MAT4") return 16;
+			return 0;
+		}
+
+		bool decode_base64(std::string_view text, std::string& output) {
+
+			auto decode = [](char c) -> int {
+				if (c >= 'A' && c <= 'Z') return c - 'A';
+				if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+				if (c >= '0' && c <= '9') return c - '0' + 52;
+				if (c == '+' || c == '-') return 62;
+				if (c == '/' || c == '_') return 63;
+				return -1;
+			};
+
+			output.clear();
+			output.reserve(text.size() / 4llu * 3llu);
+
+			std::uint32_t bits = 0u;
+			int bit_count = 0;
+
+			for (char c : text) {
+				if (c == '=') {
+					break;
+				}
+
+				int sextet = decode(c);
+				if (sextet < 0) {
+					return false;
+				}
+
+				bits = (bits << 6) | static_cast<std::uint32_t>(sextet);
+				bit_count += 6;
+
+				if (bit_count >= 8) {
+					bit_count -= 8;
+					output.push_back(static_cast<char>((bits >> bit_count) & 0xFFu));
+				}
+			}
+
+			return true;
+		}
+
+		// opens the buffer of 'uri': a data URI or a file next to the document
+		bool open_uri(document& doc, const std::string& uri, std::string_view& output) {
+
+			if (uri.rfind("data:", 0) == 0) {
+				auto comma = uri.find(',');
+				if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos) {
+					print_error("load_gltf only base64 data URIs are supported");
+					return false;
+				}
+
+				auto& decoded = doc.decoded_buffers.emplace_back();
+				if (!decode_base64(std::string_view(uri).substr(comma + 1), decoded)) {
+					print_error("load_gltf invalid base64 data URI");
+					return false;
+				}
+
+				output = decoded;
+				return true;
+			}
+
+			auto& file = doc.external_files.emplace_back();
+			if (!io::open_file((doc.directory / uri).generic_string(), file)) {
+				print_error("load_gltf could not open buffer: ", uri);
+				return false;
+			}
+
+			output = file.view();
+			return true;
+		}
+
+		// opens the document at 'path' and every buffer it refers to.
+		// a .glb is recognized by its header, everything else is expected to be a JSON .gltf.
+		bool open(const char* path, document& doc) {
+
+			if (!io::open_file(path, doc.file)) {
+				print_error("load_gltf could not open: ", path);
+				return false;
+			}
+
+			doc.directory = std::filesystem::path(path).remove_filename();
+
+			std::string_view json_text = doc.file.view();
+			std::string_view binary_chunk{};
+
+			std::uint32_t header[3]{};
+			if (doc.file.size() >= sizeof(header)) {
+				std::memcpy(header, doc.file.data(), sizeof(header));
+			}
+
+			if (header[0] == glb_magic) {
+
+				if (header[1] != 2u) {
+					print_error("load_gltf unsupported GLB version ", header[1], " in: ", path);
+					return false;
+				}
+
+				std::size_t length = std::min<std::size_t>(header[2], doc.file.size());
+				std::size_t offset = sizeof(header);
+
+				json_text = {};
+
+				// every chunk is a length, a type and the data, padded to 4 bytes
+				while (offset + 8llu <= length) {
+					std::uint32_t chunk_header[2];
+					std::memcpy(chunk_header, doc.file.data() + offset, sizeof(chunk_header));
+					offset += sizeof(chunk_header);
+
+					if (offset + chunk_header[0] > length) {
+						print_error("load_gltf truncated GLB chunk in: ", path);
+						return false;
+					}
+
+					std::string_view chunk(doc.file.data() + offset, chunk_header[0]);
+
+					if (chunk_header[1] == glb_json_chunk && json_text.empty()) {
+						json_text = chunk;
+					}
+					else if (chunk_header[1] == glb_binary_chunk && binary_chunk.empty()) {
+						binary_chunk = chunk;
+					}
+
+					offset += (chunk_header[0] + 3llu) & ~3llu;
+				}
+
+				if (json_text.empty()) {
+					print_error("load_gltf GLB without JSON chunk: ", path);
+					return false;
+				}
+			}
+
+			std::string error;
+			if (!json::parse(json_text, doc.root, error)) {
+				print_error("load_gltf invalid JSON in ", path, ": ", error);
+				return false;
+			}
+
+			const json::value* buffers = doc.root.find("buffers");
+			std::size_t buffer_count = buffers != nullptr && buffers->is_array() ? buffers->size() : 0llu;
+
+			// decoded buffers are referred to by views, they must not move
+			doc.decoded_buffers.reserve(buffer_count);
+			doc.external_files.reserve(buffer_count);
+
+			for (std::size_t i = 0; i < buffer_count; i++) {
+
+				const json::value* uri = (*buffers)[i].find("uri");
+				std::string_view buffer{};
+
+				if (uri == nullptr && i == 0llu) {
+					// the first buffer of a GLB is its binary chunk
+					buffer = binary_chunk;
+				}
+				else if (uri != nullptr && !open_uri(doc, uri->string_or(""), buffer)) {
+					return false;
+				}
+
+				std::size_t byte_length = (*buffers)[i].integer_or<std::size_t>("byteLength", 0llu);
+				if (buffer.size() < byte_length) {
+					print_error("load_gltf buffer ", i, " is smaller than its byteLength in: ", path);
+					return false;
+				}
+
+				doc.buffers.push_back(buffer.substr(0, byte_length));
+			}
+
+			return true;
+		}
+
+		// returns the element 'index' of the array 'name' of the document root, or nullptr when there is no such element
+		const json::value* element(const document& doc, std::string_view name, std::size_t index) {
+			const json::value* array = doc.root.find(name);
+			return array != nullptr && array->is_array() && index < array->size() ? &(*array)[index] : nullptr;
+		}
+
+		// resolves an accessor into a view on the buffer it is stored in, checking that every element lies inside it
+		bool accessor(const document& doc, std::size_t index, accessor_view& output) {
+
+			const json::value* acc = element(doc, "accessors", index);
+			if (acc == nullptr) {
+				print_error("load_gltf unknown accessor ", index);
+				return false;
+			}
+
+			if (acc->find("sparse") != nullptr) {
+				print_error("load_gltf sparse accessors are not supported, accessor ", index);
+				return false;
+			}
+
+			const json::value* view = element(doc, "bufferViews", acc->integer_or<std::size_t>("bufferView", ~0llu));
+			if (view == nullptr) {
+				print_error("load_gltf accessor ", index, " has no buffer view");
+				return false;
+			}
+
+			std::size_t buffer_index = view->integer_or<std::size_t>("buffer", ~0llu);
+			if (buffer_index >= doc.buffers.size()) {
+				print_error("load_gltf buffer view of accessor ", index, " refers to an unknown buffer");
+				return false;
+			}
+
+			output.component_type = acc->integer_or<int>("componentType", 0);
+			output.components = component_count(acc->string_or("type", ""));
+			output.count = acc->integer_or<std::size_t>("count", 0llu);
+			output.normalized = acc->find("normalized") != nullptr && acc->find("normalized")->boolean_or(false);
+
+			std::size_t element_size = component_size(output.component_type) * static_cast<std::size_t>(output.components);
+			if (element_size == 0llu) {
+				print_error("load_gltf accessor ", index, " has an unknown component type or type");
+				return false;
+			}
+
+			output.stride = view->integer_or<std::size_t>("byteStride", 0llu);
+			if (output.stride == 0llu) {
+				output.stride = element_size;
+			}
+
+			std::size_t view_offset = view->integer_or<std::size_t>("byteOffset", 0llu);
+			std::size_t view_length = view->integer_or<std::size_t>("byteLength", 0llu);
+			std::size_t offset = acc->integer_or<std::size_t>("byteOffset", 0llu);
+
+			const std::string_view& buffer = doc.buffers[buffer_index];
+
+			// written so that nothing can overflow, the values come straight from the file
+			bool in_bounds = view_offset <= buffer.size() && view_length <= buffer.size() - view_offset;
+
+			if (in_bounds && output.count > 0llu) {
+				in_bounds = offset <= view_length && element_size <= view_length - offset
+					&& output.count - 1llu <= (view_length - offset - element_size) / output.stride;
+			}
+
+			if (!in_bounds) {
+				print_error("load_gltf accessor ", index, " reaches outside of its buffer");
+				return false;
+			}
+
+			output.data = reinterpret_cast<const unsigned char*>(buffer.data()) + view_offset + offset;
+			return true;
+		}
+
+		// reads a component as float, normalized integers are mapped to [0, 1] or [-1, 1]
+		float read_float(const unsigned char* at, int type, bool normalized) {
+
+			switch (type)
+			{
+			case float_component: {
+				float value;
+				std::memcpy(&value, at, sizeof(value));
+				return value;
+			}
+			case unsigned_byte_component:
+				return normalized ? static_cast<float>(*at) / 255.f : static_cast<float>(*at);
+			case byte_component: {
+				auto value = static_cast<float>(static_cast<std::int8_t>(*at));
+				return normalized ? std::max(value / 127.f, -1.f) : value;
+			}
+			case unsigned_short_component: {
+				std::uint16_t value;
+				std::memcpy(&value, at, sizeof(value));
+				return normalized ? static_cast<float>(value) / 65535.f : static_cast<float>(value);
+			}
+			case short_component: {
+				std::int16_t value;
+				std::memcpy(&value, at, sizeof(value));
+				return normalized ? std::max(static_cast<float>(value) / 32767.f, -1.f) : static_cast<float>(value);
+			}
+			default:
+				return 0.f;
+			}
+		}
+
+		// copies the first 'components' components of every element of 'view' into the member at 'offset' of the verticies.
+		// tightly packed floats are copied as they are, everything else is converted component by component.
+		void copy_attribute(const accessor_view& view, vertex* verticies, std::size_t count, std::size_t offset, int components) {
+
+			int used = std::min(components, view.components);
+			std::size_t size = component_size(view.component_type);
+
+			if (view.component_type == float_component) {
+				for (std::size_t i = 0; i < count; i++) {
+					std::memcpy(reinterpret_cast<unsigned char*>(verticies + i) + offset, view.data + i * view.stride, static_cast<std::size_t>(used) * sizeof(float));
+				}
+
+				return;
+			}
+
+			for (std::size_t i = 0; i < count; i++) {
+				auto* target = reinterpret_cast<float*>(reinterpret_cast<unsigned char*>(verticies + i) + offset);
+
+				for (int c = 0; c < used; c++) {
+					target[c] = read_float(view.data + i * view.stride + static_cast<std::size_t>(c) * size, view.component_type, view.normalized);
+				}
+			}
+		}
+
+		// reads index 'i' of an accessor that 'check_indices' accepted
+		unsigned int read_index(const accessor_view& view, std::size_t i) {
+
+			const unsigned char* at = view.data + i * view.stride;
+
+			switch (view.component_type)
+			{
+			case unsigned_byte_component:
+				return *at;
+			case unsigned_short_component: {
+				std::uint16_t value;
+				std::memcpy(&value, at, sizeof(value));
+				return value;
+			}
+			default: {
+				std::uint32_t value;
+				std::memcpy(&value, at, sizeof(value));
+				return value;
+			}
+			}
+		}
+
+		// checks that 'view' holds unsigned scalars that all refer to one of 'vertex_count' verticies
+		bool check_indices(const accessor_view& view, std::size_t vertex_count) {
+
+			if (view.components != 1 || (view.component_type != unsigned_byte_component && view.component_type != unsigned_short_component && view.component_type != unsigned_int_component)) {
+				print_error("load_gltf indices have to be unsigned scalars");
+				return false;
+			}
+
+			for (std::size_t i = 0; i < view.count; i++) {
+				if (read_index(view, i) >= vertex_count) {
+					print_error("load_gltf index ", i, " refers to vertex ", read_index(view, i), " of ", vertex_count);
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// copies the indices of an accessor that 'check_indices' accepted into 'output'. 32 bit indices are copied in one go.
+		void copy_indices(const accessor_view& view, unsigned int* output) {
+
+			if (view.component_type == unsigned_int_component && view.stride == sizeof(std::uint32_t)) {
+				std::memcpy(output, view.data, view.count * sizeof(std::uint32_t));
+				return;
+			}
+
+			for (std::size_t i = 0; i < view.count; i++) {
+				output[i] = read_index(view, i);
+			}
+		}
+
+		// returns the local matrix of a node: either its 'matrix' or its translation, rotation and scale
+		glm::mat4 local_matrix(const json::value& node) {
+
+			const json::value* matrix = node.find("matrix");
+			if (matrix != nullptr && matrix->is_array() && matrix->size() == 16llu) {
+				float values[16];
+				for (std::size_t i = 0; i < 16llu; i++) {
+					values[i] = static_cast<float>((*matrix)[i].number_or(0.0));
+				}
+
+				// glTF matrices are column major, like glm
+				return glm::make_mat4(values);
+			}
+
+			auto read = [&](std::string_view name, std::size_t count, glm::vec4 fallback) {
+				const json::value* values = node.find(name);
+				if (values != nullptr && values->is_array() && values->size() == count) {
+					for (std::size_t i = 0; i < count; i++) {
+						fallback[static_cast<int>(i)] = static_cast<float>((*values)[i].number_or(0.0));
+					}
+				}
+
+				return fallback;
+			};
+
+			glm::vec4 translation = read("translation", 3llu, glm::vec4(0.f));
+			glm::vec4 rotation = read("rotation", 4llu, glm::vec4(0.f, 0.f, 0.f, 1.f));
+			glm::vec4 scale = read("scale", 3llu, glm::vec4(1.f));
+
+			// glTF stores quaternions as x, y, z, w
+			glm::quat quat(rotation.w, rotation.x, rotation.y, rotation.z);
+
+			glm::mat4 translate = glm::translate(glm::mat4(1.f), glm::vec3(translation));
+			return glm::scale(translate * glm::mat4_cast(quat), glm::vec3(scale));
+		}
+
+		// state of a single 'load_gltf' call
+		struct loader {
+			document doc;
+			std::string path;
+
+			// the meshes in the pool that were converted from each glTF mesh, one per primitive
+			std::vector<std::vector<std::size_t>> converted;
+
+			// the texture created for each glTF image
+			std::unordered_map<std::size_t, unsigned int> image_textures;
+		};
+
+		// returns the texture of the base color of a material, loading its image on first use
+		bool material_texture(loader& state, std::size_t material_index, unsigned int& texture_id) {
+
+			const json::value* material = element(state.doc, "materials", material_index);
+			const json::value* pbr = material != nullptr ? material->find("pbrMetallicRoughness") : nullptr;
+			const json::value* base_color = pbr != nullptr ? pbr->find("baseColorTexture") : nullptr;
+
+			if (base_color == nullptr) {
+				return false;
+			}
+
+			const json::value* texture = element(state.doc, "textures", base_color->integer_or<std::size_t>("index", ~0llu));
+			if (texture == nullptr) {
+				return false;
+			}
+
+			std::size_t image_index = texture->integer_or<std::size_t>("source", ~0llu);
+
+			auto found = state.image_textures.find(image_index);
+			if (found != state.image_textures.end()) {
+				texture_id = found->second;
+				return true;
+			}
+
+			const json::value* image = element(state.doc, "images", image_index);
+			if (image == nullptr) {
+				return false;
+			}
+
+			std::string name = state.path + "#image_" + std::to_string(image_index);
+			std::string_view bytes{};
+
+			// the image is either stored in a buffer view, a data URI or a file next to the document
+			io::file_view image_file;
+			std::string decoded;
+
+			if (const json::value* view = element(state.doc, "bufferViews", image->integer_or<std::size_t>("bufferView", ~0llu))) {
+
+				std::size_t buffer_index = view->integer_or<std::size_t>("buffer", ~0llu);
+				std::size_t offset = view->integer_or<std::size_t>("byteOffset", 0llu);
+				std::size_t length = view->integer_or<std::size_t>("byteLength", 0llu);
+
+				if (buffer_index < state.doc.buffers.size() && offset + length <= state.doc.buffers[buffer_index].size()) {
+					bytes = state.doc.buffers[buffer_index].substr(offset, length);
+				}
+			}
+			else if (const json::value* uri = image->find("uri")) {
+
+				std::string uri_text = uri->string_or("");
+				auto comma = uri_text.find(',');
+
+				if (uri_text.rfind("data:", 0) == 0 && comma != std::string::npos && decode_base64(std::string_view(uri_text).substr(comma + 1), decoded)) {
+					bytes = decoded;
+				}
+				else if (io::open_file((state.doc.directory / uri_text).generic_string(), image_file)) {
+					bytes = image_file.view();
+				}
+			}
+
+			if (bytes.empty()) {
+				print_error("load_gltf could not find the data of image ", image_index, " in: ", state.path);
+				return false;
+			}
+
+			// glTF puts the first row of an image at the top, which is what OpenGL samples at 0 when it is not flipped
+			opengl::image::texture_handle handle;
+			if (!opengl::image::load_from_memory(handle, reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), name.c_str(), false)) {
+				return false;
+			}
+
+			texture_id = opengl::image::get(handle)->id;
+			state.image_textures.emplace(image_index, texture_id);
+
+			return true;
+		}
+
+		// converts a primitive into a new mesh of the pool, returns false when it can not be drawn
+		bool load_primitive(loader& state, const json::value& primitive, std::string_view name, scene_graph::node_id node, mesh_pool& pool) {
+
+			if (primitive.integer_or<int>("mode", triangles_mode) != triangles_mode) {
+				print_error("load_gltf only triangle primitives are supported, skipped a primitive of ", name);
+				return false;
+			}
+
+			const json::value* attributes = primitive.find("attributes");
+			const json::value* position_index = attributes != nullptr ? attributes->find("POSITION") : nullptr;
+
+			accessor_view positions;
+			if (position_index == nullptr || !accessor(state.doc, position_index->integer_or<std::size_t>(~0llu), positions)) {
+				print_error("load_gltf skipped a primitive without positions of ", name);
+				return false;
+			}
+
+			std::size_t count = positions.count;
+
+			// the indices are checked before anything is added, a bad accessor must not leave half a mesh in the pool
+			const json::value* indices_index = primitive.find("indices");
+			accessor_view indices;
+
+			if (indices_index != nullptr && (!accessor(state.doc, indices_index->integer_or<std::size_t>(~0llu), indices) || !check_indices(indices, count))) {
+				print_error("load_gltf skipped a primitive with broken indices of ", name);
+				return false;
+			}
+
+			pool.add_mesh(name, node);
+
+			vertex* verticies = pool.add_verticies(count);
+			copy_attribute(positions, verticies, count, offsetof(vertex, position), 3);
+
+			auto copy_optional = [&](std::string_view attribute, std::size_t offset, int components) {
+				const json::value* index = attributes->find(attribute);
+				accessor_view view;
+
+				if (index != nullptr && accessor(state.doc, index->integer_or<std::size_t>(~0llu), view) && view.count >= count) {
+					copy_attribute(view, verticies, count, offset, components);
+					return true;
+				}
+
+				return false;
+			};
+
+			copy_optional("NORMAL", offsetof(vertex, normal), 3);
+			copy_optional("TEXCOORD_0", offsetof(vertex, texture_coordinates), 2);
+			copy_optional("COLOR_0", offsetof(vertex, color), 3);
+
+			// glTF stores the handedness of the tangent space in the w of the tangent, the bittangent is derived from it
+			const json::value* tangent_index = attributes->find("TANGENT");
+			accessor_view tangents;
+
+			if (tangent_index != nullptr && accessor(state.doc, tangent_index->integer_or<std::size_t>(~0llu), tangents) && tangents.count >= count && tangents.components == 4) {
+				copy_attribute(tangents, verticies, count, offsetof(vertex, tangent), 3);
+
+				for (std::size_t i = 0; i < count; i++) {
+					float handedness = read_float(tangents.data + i * tangents.stride + 3llu * component_size(tangents.component_type), tangents.component_type, tangents.normalized);
+					verticies[i].bittangent = glm::cross(verticies[i].normal, verticies[i].tangent) * (handedness < 0.f ? -1.f : 1.f);
+				}
+			}
+
+			if (indices_index != nullptr) {
+				copy_indices(indices, pool.add_indices(indices.count));
+			}
+			else {
+				// without indices every three verticies form a triangle
+				unsigned int* indices = pool.add_indices(count);
+				for (std::size_t i = 0; i < count; i++) {
+					indices[i] = static_cast<unsigned int>(i);
+				}
+			}
+
+			unsigned int texture_id;
+			if (primitive.find("material") != nullptr && material_texture(state, primitive.integer_or<std::size_t>("material", 0llu), texture_id)) {
+				pool.add_texture(texture(texture_id, texture_type::diffuse_texture));
+			}
+
+			return true;
+		}
+	}
+
+	// ============================================================================================================================
+
+	void load_gltf_node(gltf::loader& state, std::size_t node_index, scene_graph::node_id parent, mesh_pool& pool, int depth) {
+
+		const json::value* node_ptr = gltf::element(state.doc, "nodes", node_index);
+
+		// a node can not be its own ancestor, a document that says otherwise would never stop recursing
+		if (node_ptr == nullptr || depth > 256) {
+			print_error("load_gltf invalid node ", node_index, " in: ", state.path);
+			return;
+		}
+
+		auto node = data::scene.add_node(parent, gltf::local_matrix(*node_ptr));
+
+		std::size_t mesh_index = node_ptr->integer_or<std::size_t>("mesh", ~0llu);
+		const json::value* mesh_ptr = gltf::element(state.doc, "meshes", mesh_index);
+
+		if (mesh_ptr != nullptr) {
+
+			std::string name = node_ptr->string_or("name", mesh_ptr->string_or("name", "node_" + std::to_string(node_index)));
+
+			auto& converted = state.converted[mesh_index];
+
+			if (!converted.empty()) {
+				// the mesh has been converted for another node already, share its geometry
+				for (auto source : converted) {
+					pool.add_shared_mesh(source, name, node);
+				}
+			}
+			else if (const json::value* primitives = mesh_ptr->find("primitives")) {
+				for (std::size_t i = 0; i < primitives->size(); i++) {
+					std::size_t pool_index = pool.size();
+
+					if (gltf::load_primitive(state, (*primitives)[i], name, node, pool)) {
+						converted.push_back(pool_index);
+					}
+				}
+			}
+		}
+
+		if (const json::value* children = node_ptr->find("children")) {
+			for (std::size_t i = 0; i < children->size(); i++) {
+				load_gltf_node(state, (*children)[i].integer_or<std::size_t>(~0llu), node, pool, depth + 1);
+			}
+		}
+	}
+
+	// loads a glTF 2.0 model, either a .gltf with its buffers and images or a single binary .glb.
+	// buffers are mapped instead of read, their accessors are copied into the mesh pool of the model without
+	// an intermediate copy, 32 bit index ranges in one go.
+	// the node hierarchy ends up below the root node of the model, base color textures are used as diffuse textures.
+	bool load_gltf(model_handle& handle, const char* path) {
+		PROFILE_ZONE("load_gltf");
+
+		gltf::loader state;
+		state.path = path;
+
+		if (!gltf::open(path, state.doc)) {
+			print_error("load_gltf could not load: ", path);
+			return false;
+		}
+
+		const json::value* meshes = state.doc.root.find("meshes");
+		const json::value* nodes = state.doc.root.find("nodes");
+
+		std::size_t mesh_count = meshes != nullptr && meshes->is_array() ? meshes->size() : 0llu;
+		std::size_t node_count = nodes != nullptr && nodes->is_array() ? nodes->size() : 0llu;
+
+		state.converted.resize(mesh_count);
+
+		// find the nodes to start from: those of the default scene, or every node that is nobody's child
+		std::vector<std::size_t> roots;
+
+		const json::value* scene = gltf::element(state.doc, "scenes", state.doc.root.integer_or<std::size_t>("scene", 0llu));
+		if (scene != nullptr && scene->find("nodes") != nullptr) {
+			const json::value* scene_nodes = scene->find("nodes");
+			for (std::size_t i = 0; i < scene_nodes->size(); i++) {
+				roots.push_back((*scene_nodes)[i].integer_or<std::size_t>(~0llu));
+			}
+		}
+		else {
+			std::vector<bool> is_child(node_count, false);
+			for (std::size_t i = 0; i < node_count; i++) {
+				if (const json::value* children = (*nodes)[i].find("children")) {
+					for (std::size_t c = 0; c < children->size(); c++) {
+						auto child = (*children)[c].integer_or<std::size_t>(~0llu);
+						if (child < node_count) {
+							is_child[child] = true;
+						}
+					}
+				}
+			}
+
+			for (std::size_t i = 0; i < node_count; i++) {
+				if (!is_child[i]) {
+					roots.push_back(i);
+				}
+			}
+		}
+
+		auto new_handle = data::loaded_models.emplace();
+
+		model& model_ref = data::loaded_models.at(new_handle);
+		model_ref.id_ = new_handle.index;
+		model_ref.path_to_file_ = path;
+
+		// reserve the pool for every mesh converted once
+		mesh_pool_size pool_size;
+		for (std::size_t m = 0; m < mesh_count; m++) {
+			const json::value* primitives = (*meshes)[m].find("primitives");
+
+			for (std::size_t p = 0; primitives != nullptr && p < primitives->size(); p++) {
+				const json::value& primitive = (*primitives)[p];
+				const json::value* attributes = primitive.find("attributes");
+
+				gltf::accessor_view view;
+				if (attributes != nullptr && attributes->find("POSITION") != nullptr && gltf::accessor(state.doc, attributes->integer_or<std::size_t>("POSITION", ~0llu), view)) {
+					pool_size.meshes++;
+					pool_size.verticies += view.count;
+					pool_size.indices += primitive.find("indices") != nullptr && gltf::accessor(state.doc, primitive.integer_or<std::size_t>("indices", ~0llu), view) ? view.count : 0llu;
+					pool_size.textures++;
+				}
+			}
+		}
+
+		model_ref.meshes_.reserve(pool_size.meshes, pool_size.verticies, pool_size.indices, pool_size.textures, pool_size.meshes * 16llu);
+
+		create_transform(model_ref, new_handle);
+
+		for (auto root : roots) {
+			load_gltf_node(state, root, model_ref.root_node_, model_ref.meshes_, 0);
+		}
+
+		calculate_bounds(model_ref);
+
+		handle = new_handle;
+		return true;
+	}
+}
\ No newline at end of file
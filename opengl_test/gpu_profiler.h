@@ -0,0 +1,221 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+
+#include "print.h"
+#include "opengl.h"
+#include "profiler.h"
+
+// how long the GPU spends on each render pass, next to how long the CPU spent submitting it.
+// a pass writes a GPU timestamp when it starts and when it ends. the queries of a frame are read back 'frames_in_flight'
+// frames later, when the GPU is done with them, so reading them never waits for the GPU.
+//
+// GPU_PASS("name") measures until the end of the scope, it is also a profiler zone. the name has to outlive the program.
+namespace gpu_profiler {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	constexpr std::size_t frames_in_flight = 3llu;
+	constexpr std::size_t sample_history = 1llu << 12;
+
+	// how often the GPU clock is compared to the CPU clock again, they drift apart
+	constexpr std::uint64_t calibrate_every_frames = 60llu;
+
+	// how much a new sample moves the shown average
+	constexpr double average_weight = 0.1;
+
+	struct pass {
+		const char* name = nullptr;
+
+		// a start and an end timestamp for every frame in flight
+		std::array<unsigned int, frames_in_flight * 2llu> queries{};
+		std::array<bool, frames_in_flight> issued{};
+
+		double gpu_ms = 0.0;
+		double cpu_ms = 0.0;
+	};
+
+	// a pass as it ran on the GPU, in nanoseconds of the CPU clock of the profiler
+	struct sample {
+		const char* name = nullptr;
+		std::uint64_t start = 0llu;
+		std::uint64_t end = 0llu;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// a deque, a pass that is measuring keeps its place while other passes are added
+		std::deque<pass> passes;
+		std::uint64_t frame = 0llu;
+
+		// unknown until the first pass, some drivers have no timestamp queries
+		bool checked_support = false;
+		bool supported = false;
+
+		// the CPU time minus the GPU time, see 'calibrate'
+		std::int64_t gpu_to_cpu = 0ll;
+
+		// the oldest samples are dropped
+		std::deque<sample> samples;
+	}
+	// ============================================================================================================================
+
+	namespace detail {
+
+		// compares the GPU clock to the clock of the profiler, so GPU timestamps can be placed next to the CPU zones
+		void calibrate() {
+			GLint64 gpu_now = 0ll;
+			glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+
+			data::gpu_to_cpu = static_cast<std::int64_t>(profiler::now()) - static_cast<std::int64_t>(gpu_now);
+		}
+
+		bool check_support() {
+			if (!data::checked_support) {
+				GLint bits = 0;
+				glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+
+				data::supported = bits > 0;
+				data::checked_support = true;
+
+				if (data::supported) {
+					calibrate();
+				}
+				else {
+					print_info("gpu_profiler no timestamp queries, only the CPU time of a pass is measured");
+				}
+			}
+
+			return data::supported;
+		}
+
+		pass& find_pass(const char* name) {
+
+			for (auto& existing : data::passes) {
+				if (existing.name == name || std::strcmp(existing.name, name) == 0) {
+					return existing;
+				}
+			}
+
+			auto& added = data::passes.emplace_back();
+			added.name = name;
+
+			if (check_support()) {
+				glGenQueries(static_cast<GLsizei>(added.queries.size()), added.queries.data());
+			}
+
+			return added;
+		}
+
+		void add_sample(double& average, double sample) {
+			average = average == 0.0 ? sample : average + (sample - average) * average_weight;
+		}
+	}
+
+	// reads back the passes of the frame that used the same queries, call it at the top of the main loop
+	void begin_frame() {
+
+		data::frame++;
+		std::size_t slot = data::frame % frames_in_flight;
+
+		if (!data::supported) {
+			return;
+		}
+
+		if (data::frame % calibrate_every_frames == 1llu) {
+			detail::calibrate();
+		}
+
+		for (auto& measured : data::passes) {
+			if (!measured.issued[slot]) {
+				continue;
+			}
+
+			measured.issued[slot] = false;
+
+			unsigned int start_query = measured.queries[slot * 2llu];
+			unsigned int end_query = measured.queries[slot * 2llu + 1llu];
+
+			// the GPU is more than 'frames_in_flight' frames behind, the sample is dropped instead of waiting for it
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (available == GL_FALSE) {
+				continue;
+			}
+
+			GLuint64 start = 0llu;
+			GLuint64 end = 0llu;
+			glGetQueryObjectui64v(start_query, GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(end_query, GL_QUERY_RESULT, &end);
+
+			detail::add_sample(measured.gpu_ms, static_cast<double>(end - start) / 1000000.0);
+
+			if (data::samples.size() == sample_history) {
+				data::samples.pop_front();
+			}
+
+			data::samples.push_back({
+				measured.name,
+				static_cast<std::uint64_t>(static_cast<std::int64_t>(start) + data::gpu_to_cpu),
+				static_cast<std::uint64_t>(static_cast<std::int64_t>(end) + data::gpu_to_cpu)
+			});
+		}
+	}
+
+	// measures a render pass until it goes out of scope
+	struct scoped_pass {
+
+		explicit scoped_pass(const char* name)
+			: zone_(name), pass_(detail::find_pass(name)), cpu_start_(std::chrono::steady_clock::now())
+		{
+			if (data::supported) {
+				glQueryCounter(pass_.queries[slot() * 2llu], GL_TIMESTAMP);
+			}
+		}
+
+		~scoped_pass() {
+			if (data::supported) {
+				glQueryCounter(pass_.queries[slot() * 2llu + 1llu], GL_TIMESTAMP);
+				pass_.issued[slot()] = true;
+			}
+
+			detail::add_sample(pass_.cpu_ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpu_start_).count());
+		}
+
+		scoped_pass(const scoped_pass&) = delete;
+		scoped_pass& operator=(const scoped_pass&) = delete;
+
+	private:
+		static std::size_t slot() {
+			return data::frame % frames_in_flight;
+		}
+
+		profiler::scoped_zone zone_;
+		pass& pass_;
+		std::chrono::steady_clock::time_point cpu_start_;
+	};
+
+	// adds the CPU and GPU time of every pass to the current ImGui window
+	void show_passes() {
+
+		for (const auto& measured : data::passes) {
+			if (data::supported) {
+				ImGui::Text("%-12s cpu %7.3f ms | gpu %7.3f ms", measured.name, measured.cpu_ms, measured.gpu_ms);
+			}
+			else {
+				ImGui::Text("%-12s cpu %7.3f ms", measured.name, measured.cpu_ms);
+			}
+		}
+	}
+}
+
+#ifdef DISABLE_PROFILER
+#define GPU_PASS(name)
+#else
+#define GPU_PASS(name) gpu_profiler::scoped_pass PROFILE_CONCAT(gpu_pass_, __LINE__)(name)
+#endif
\ No newline at end of file
@@ -7,6 +7,9 @@
 
 #include "sdl.h"
 #include "opengl.h"
+#include "profiler.h"
+#include "gpu_profiler.h"
+#include "render_stats.h"
 
 namespace gui {
 
@@ -20,7 +23,7 @@ namespace gui {
 		return ImGui::GetIO();
 	}
 
-	void init(SDL_Window* window_ptr, SDL_GLContext gl_context) {
+	void init(SDL_Window* window_ptr, [[maybe_unused]] SDL_GLContext gl_context) {
 
 		data::window_ptr = window_ptr;
 
@@ -29,21 +32,39 @@ namespace gui {
 
 		ImGui::StyleColorsDark();
 
+#ifndef HEADLESS
 		ImGui_ImplSDL2_InitForOpenGL(window_ptr, gl_context);
+#endif
 		ImGui_ImplOpenGL3_Init("#version 450");
 	}
 
-	void process_event(const SDL_Event& event_) {
+	void process_event([[maybe_unused]] const SDL_Event& event_) {
+#ifndef HEADLESS
 		ImGui_ImplSDL2_ProcessEvent(&event_);
+#endif
 	}
 
 	void update() {
 		ImGui_ImplOpenGL3_NewFrame();
+
+#ifdef HEADLESS
+		// without a window ImGui only needs the size and the time, the SDL backend would ask the window for them
+		static std::uint64_t last_frame = SDL_GetPerformanceCounter();
+		std::uint64_t now = SDL_GetPerformanceCounter();
+
+		auto& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(static_cast<float>(sdl::data::window_width), static_cast<float>(sdl::data::window_height));
+		io.DeltaTime = now > last_frame ? static_cast<float>(now - last_frame) / static_cast<float>(SDL_GetPerformanceFrequency()) : 1.f / 60.f;
+		last_frame = now;
+#else
 		ImGui_ImplSDL2_NewFrame(data::window_ptr);
+#endif
 		ImGui::NewFrame();
 	}
 
 	void render() {
+		GPU_PASS("imgui");
+
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 	}
@@ -66,8 +87,13 @@ namespace gui {
 
 		auto& io = ImGui::GetIO();
 
-		ImGui::Begin("Hello, world!", &show_metrics, ImGuiWindowFlags_NoDecoration);
+		ImGui::Begin("Hello, world!", &show_metrics, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
 		ImGui::Text("fps: %.1f | frame time: %.3f", io.Framerate, 1000.f / io.Framerate);
+
+		const auto& stats = render_stats::last_frame();
+		ImGui::Text("draws: %llu | triangles: %llu", static_cast<unsigned long long>(stats.draw_calls), static_cast<unsigned long long>(stats.triangles));
+
+		gpu_profiler::show_passes();
 		ImGui::End();
 	}
 
@@ -77,9 +103,9 @@ namespace gui {
 
 		ImGui::Columns(2);
 
-		for (std::size_t i = 0; i < std::min(50llu, main_logger.size()); i++)
+		// loader threads keep logging while the window is drawn, so it draws from a copy
+		for (const auto& message : main_logger.copy(50llu))
 		{
-			auto& message = main_logger.at(i);
 			ImGui::Text("%d", message.timestamp);
 			ImGui::NextColumn();
 			ImGui::Text(message.text.c_str());
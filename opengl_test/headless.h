@@ -0,0 +1,259 @@
+#pragma once
+
+// an OpenGL 4.5 context without a window, for batch rendering and performance tests on servers without a display.
+// the frames are drawn into a framebuffer object instead of a window, Mesa's llvmpipe is enough to run it.
+//
+// define HEADLESS to build it instead of the SDL window, the context comes from EGL without a surface (link EGL).
+// define HEADLESS_OSMESA as well to get it from OSMesa instead (link OSMesa), for machines without EGL.
+#ifdef HEADLESS
+
+// glad has to come before any other GL header
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+
+#ifdef HEADLESS_OSMESA
+#include <GL/osmesa.h>
+#else
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "print.h"
+
+namespace headless {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	// how many frames the CPU is allowed to be ahead of the GPU, like a swap chain
+	constexpr std::size_t frames_in_flight = 2llu;
+
+	// ============================================================================================================================
+	namespace data {
+		int width = 0;
+		int height = 0;
+
+#ifdef HEADLESS_OSMESA
+		OSMesaContext context = nullptr;
+
+		// OSMesa needs memory to draw into even though the frames go into the framebuffer object
+		std::vector<unsigned char> pixels;
+#else
+		EGLDisplay display = EGL_NO_DISPLAY;
+		EGLContext context = EGL_NO_CONTEXT;
+#endif
+
+		unsigned int framebuffer = 0u;
+		unsigned int color_buffer = 0u;
+		unsigned int depth_buffer = 0u;
+
+		// a fence at the end of every frame in flight
+		std::array<GLsync, frames_in_flight> fences{};
+		std::size_t frame = 0llu;
+	}
+	// ============================================================================================================================
+
+#ifdef HEADLESS_OSMESA
+
+	bool create_context(int width, int height) {
+
+		const int attributes[] = {
+			OSMESA_FORMAT, OSMESA_RGBA,
+			OSMESA_DEPTH_BITS, 24,
+			OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+			OSMESA_CONTEXT_MAJOR_VERSION, 4,
+			OSMESA_CONTEXT_MINOR_VERSION, 5,
+			0
+		};
+
+		data::context = OSMesaCreateContextAttribs(attributes, nullptr);
+		if (data::context == nullptr) {
+			print_error("headless failed to create an OSMesa 4.5 core context");
+			return false;
+		}
+
+		data::pixels.resize(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4llu);
+
+		if (!OSMesaMakeCurrent(data::context, data::pixels.data(), GL_UNSIGNED_BYTE, width, height)) {
+			print_error("headless failed to make the OSMesa context current");
+			return false;
+		}
+
+		data::width = width;
+		data::height = height;
+		return true;
+	}
+
+	void* get_proc_address(const char* name) {
+		return reinterpret_cast<void*>(OSMesaGetProcAddress(name));
+	}
+
+	void destroy_context() {
+		if (data::context != nullptr) {
+			OSMesaDestroyContext(data::context);
+			data::context = nullptr;
+		}
+	}
+
+#else
+
+	bool create_context(int width, int height) {
+
+		// Mesa has a display that needs no window system, other drivers fall back to their default display
+		auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (get_platform_display != nullptr) {
+			data::display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+
+		if (data::display == EGL_NO_DISPLAY) {
+			data::display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		EGLint major = 0;
+		EGLint minor = 0;
+
+		if (data::display == EGL_NO_DISPLAY || !eglInitialize(data::display, &major, &minor)) {
+			print_error("headless failed to initialize EGL");
+			return false;
+		}
+
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			print_error("headless EGL has no desktop OpenGL");
+			return false;
+		}
+
+		const EGLint config_attributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+
+		EGLConfig config = nullptr;
+		EGLint config_count = 0;
+
+		if (!eglChooseConfig(data::display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+			print_error("headless EGL has no config for OpenGL");
+			return false;
+		}
+
+		const EGLint context_attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 5,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef DEBUG
+			EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+			EGL_NONE
+		};
+
+		data::context = eglCreateContext(data::display, config, EGL_NO_CONTEXT, context_attributes);
+		if (data::context == EGL_NO_CONTEXT) {
+			print_error("headless failed to create an EGL 4.5 core context");
+			return false;
+		}
+
+		// the context has no surface at all, the frames go into the framebuffer object
+		if (!eglMakeCurrent(data::display, EGL_NO_SURFACE, EGL_NO_SURFACE, data::context)) {
+			print_error("headless failed to make the EGL context current without a surface");
+			return false;
+		}
+
+		print_info("headless EGL ", major, ".", minor, " context");
+
+		data::width = width;
+		data::height = height;
+		return true;
+	}
+
+	void* get_proc_address(const char* name) {
+		return reinterpret_cast<void*>(eglGetProcAddress(name));
+	}
+
+	void destroy_context() {
+		if (data::display != EGL_NO_DISPLAY) {
+			eglMakeCurrent(data::display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+			if (data::context != EGL_NO_CONTEXT) {
+				eglDestroyContext(data::display, data::context);
+				data::context = EGL_NO_CONTEXT;
+			}
+
+			eglTerminate(data::display);
+			data::display = EGL_NO_DISPLAY;
+		}
+	}
+
+#endif
+
+	// creates the framebuffer object the frames are drawn into and binds it in place of the window, call it after glad
+	// loaded the GL functions
+	bool create_framebuffer() {
+
+		glCreateRenderbuffers(1, &data::color_buffer);
+		glNamedRenderbufferStorage(data::color_buffer, GL_RGBA8, data::width, data::height);
+
+		glCreateRenderbuffers(1, &data::depth_buffer);
+		glNamedRenderbufferStorage(data::depth_buffer, GL_DEPTH24_STENCIL8, data::width, data::height);
+
+		glCreateFramebuffers(1, &data::framebuffer);
+		glNamedFramebufferRenderbuffer(data::framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, data::color_buffer);
+		glNamedFramebufferRenderbuffer(data::framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, data::depth_buffer);
+
+		if (glCheckNamedFramebufferStatus(data::framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			print_error("headless the framebuffer is not complete");
+			return false;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, data::framebuffer);
+		return true;
+	}
+
+	// ends a frame in place of swapping the buffers of a window.
+	// it waits for the frame 'frames_in_flight' frames back, so the CPU does not run further ahead than it would with a window.
+	void present() {
+
+		auto& fence = data::fences[data::frame % frames_in_flight];
+
+		if (fence != nullptr) {
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+		}
+
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		data::frame++;
+	}
+
+	// copies the last frame into 'pixels' as RGBA rows, the bottom row first
+	void read_pixels(std::vector<unsigned char>& pixels) {
+		pixels.resize(static_cast<std::size_t>(data::width) * static_cast<std::size_t>(data::height) * 4llu);
+
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glNamedFramebufferReadBuffer(data::framebuffer, GL_COLOR_ATTACHMENT0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, data::framebuffer);
+		glReadPixels(0, 0, data::width, data::height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+
+	void destroy() {
+
+		if (data::framebuffer != 0u) {
+			for (auto& fence : data::fences) {
+				if (fence != nullptr) {
+					glDeleteSync(fence);
+					fence = nullptr;
+				}
+			}
+
+			glDeleteFramebuffers(1, &data::framebuffer);
+			glDeleteRenderbuffers(1, &data::color_buffer);
+			glDeleteRenderbuffers(1, &data::depth_buffer);
+			data::framebuffer = 0u;
+		}
+
+		destroy_context();
+	}
+}
+
+#endif
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "sdl.h"
 #include <string>
 #include <map>
+#include <vector>
+#include <cstring>
 #include <iomanip>
 #include <filesystem>
 
@@ -10,18 +12,33 @@
 #include <stb_image.h>
 
 #include "shader.h"
+#include "slot_map.h"
+#include "vfs.h"
+#include "async_io.h"
+#include "profiler.h"
+#include "render_stats.h"
 
 namespace opengl::image {
 
 	struct texture_info {
 		unsigned int id{};
-		const char * name = nullptr;
+		std::string name;
 		int width{};
 		int height{};
+
+		// the file the texture was loaded from, empty when it was loaded from memory
+		std::string path;
 	};
 
+	using texture_handle = containers::handle<texture_info>;
+
 	namespace data {
-		std::map<const char *, texture_info> loaded_textures;
+		// every texture that has been loaded
+		containers::slot_map<texture_info> textures;
+
+		// finds the handle of a loaded texture by its name
+		std::map<std::string, texture_handle> loaded_textures;
+
 		const texture_info empty_info{};
 	}
 
@@ -60,43 +77,205 @@ namespace opengl::image {
 		TEXTURE31 = 0x84DF
 	};
 
-	bool load(unsigned int& texture_id, const char * path, const char * name) {
-		stbi_set_flip_vertically_on_load(true);
+	// creates a texture from decoded pixels and registers it under 'name', 'pixels' are RGBA with 4 bytes per pixel
+	void create(texture_handle& handle, const unsigned char * pixels, int x, int y, const char * name, const char * path = "") {
+
+		unsigned int texture_id;
+		glGenTextures(1, &texture_id);
+		glBindTexture(GL_TEXTURE_2D, texture_id);
+
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		render_stats::count_texture_bind();
+		render_stats::count_texture_upload(static_cast<std::uint64_t>(x) * static_cast<std::uint64_t>(y) * 4llu);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		handle = data::textures.emplace(texture_info{ texture_id, name, x, y, path });
+		data::loaded_textures.insert_or_assign(name, handle);
+	}
+
+	// turns RGBA 'pixels' upside down in place.
+	// images are flipped here instead of by stb_image, whose flag is global and would race between the threads that decode.
+	void flip_rows(unsigned char * pixels, int x, int y) {
+
+		std::size_t row_size = static_cast<std::size_t>(x) * 4llu;
+		std::vector<unsigned char> row(row_size);
+
+		for (int top = 0, bottom = y - 1; top < bottom; top++, bottom--) {
+			unsigned char * top_row = pixels + static_cast<std::size_t>(top) * row_size;
+			unsigned char * bottom_row = pixels + static_cast<std::size_t>(bottom) * row_size;
+
+			std::memcpy(row.data(), top_row, row_size);
+			std::memcpy(top_row, bottom_row, row_size);
+			std::memcpy(bottom_row, row.data(), row_size);
+		}
+	}
+
+	// loads an image through the file layer, so it may come from a pack as well as from disk
+	bool load(texture_handle& handle, const char * path, const char * name) {
+		PROFILE_ZONE("image load");
+
+		io::file_view file;
+		if (!io::open_file(path, file)) {
+			print_error("Failed to load image ", std::quoted(name));
+			print_error(std::quoted(path), " file not found");
+			return false;
+		}
 
 		int x = 0;
 		int y = 0;
 		int comp = 0;
 
-		unsigned char * image_data = stbi_load(path, &x, &y, &comp, 0);
+		unsigned char * image_data = stbi_load_from_memory(reinterpret_cast<const unsigned char*>(file.data()), static_cast<int>(file.size()), &x, &y, &comp, 4);
 
 		if (image_data == nullptr) {
-
 			print_error("Failed to load image ", std::quoted(name));
+			return false;
+		}
+
+		flip_rows(image_data, x, y);
+
+		create(handle, image_data, x, y, name, path);
+
+		print_info("Loaded image ", std::quoted(path), " as ", std::quoted(name), ": [id:", data::textures.at(handle).id, "][w:", x, ",h:", y, "]");
+
+		stbi_image_free(image_data);
+
+		return true;
+	}
+
+	// loads an image that is already in memory, like the images embedded in a model file
+	bool load_from_memory(texture_handle& handle, const unsigned char * bytes, std::size_t size, const char * name, bool flip_vertically = true) {
+
+		int x = 0;
+		int y = 0;
+		int comp = 0;
+
+		// whatever the file holds is expanded to the RGBA 'create' uploads
+		unsigned char * image_data = stbi_load_from_memory(bytes, static_cast<int>(size), &x, &y, &comp, 4);
+
+		if (image_data == nullptr) {
+			print_error("Failed to load image ", std::quoted(name), " from memory");
+			return false;
+		}
+
+		if (flip_vertically) {
+			flip_rows(image_data, x, y);
+		}
+
+		create(handle, image_data, x, y, name);
 
-			if (!std::filesystem::exists(path)) {
-				print_error(std::quoted(path), " file not found");
+		print_info("Loaded image ", std::quoted(name), " from memory: [id:", data::textures.at(handle).id, "][w:", x, ",h:", y, "]");
+
+		stbi_image_free(image_data);
+
+		return true;
+	}
+
+	// pixels decoded by 'decode_batch' that have not been uploaded yet
+	struct decoded_image {
+		unsigned char * pixels = nullptr;
+		int x = 0;
+		int y = 0;
+	};
+
+	// reads and decodes many images at once without touching OpenGL, so it can be called from any thread.
+	// the files are read together and each image is decoded on a worker thread as soon as its file has been read.
+	// 'images' gets one entry per path, the pixels of an image that failed to load are nullptr.
+	void decode_batch(std::vector<decoded_image>& images, const std::vector<std::string>& paths) {
+		PROFILE_ZONE("decode_batch");
+
+		images.assign(paths.size(), decoded_image{});
+
+		io::read_files(paths, [&](std::size_t index, io::file_view& file) {
+			if (!file.is_open()) {
+				return;
+			}
+
+			int comp = 0;
+			decoded_image& image = images[index];
+			image.pixels = stbi_load_from_memory(reinterpret_cast<const unsigned char*>(file.data()), static_cast<int>(file.size()), &image.x, &image.y, &comp, 4);
+
+			if (image.pixels != nullptr) {
+				flip_rows(image.pixels, image.x, image.y);
 			}
+		});
+	}
+
+	// uploads images decoded by 'decode_batch' and frees their pixels, has to be called on the thread that owns the GL context.
+	// 'handles' gets one handle per path, returns false when any of the images could not be loaded.
+	bool upload_batch(std::vector<texture_handle>& handles, std::vector<decoded_image>& images, const std::vector<std::string>& paths, const std::vector<std::string>& names) {
+		PROFILE_ZONE("upload_batch");
+
+		bool all_loaded = true;
+		handles.assign(paths.size(), texture_handle{});
+
+		for (std::size_t i = 0; i < paths.size(); i++) {
+
+			if (i >= images.size() || images[i].pixels == nullptr) {
+				print_error("Failed to load image ", std::quoted(names[i]), " from ", std::quoted(paths[i]));
+				all_loaded = false;
+				continue;
+			}
+
+			create(handles[i], images[i].pixels, images[i].x, images[i].y, names[i].c_str(), paths[i].c_str());
+
+			print_info("Loaded image ", std::quoted(paths[i]), " as ", std::quoted(names[i]), ": [id:", data::textures.at(handles[i]).id, "][w:", images[i].x, ",h:", images[i].y, "]");
+
+			stbi_image_free(images[i].pixels);
+			images[i].pixels = nullptr;
+		}
+
+		return all_loaded;
+	}
+
+	// loads many images at once, see 'decode_batch', and uploads all of them here once they are decoded.
+	// 'handles' gets one handle per path, returns false when any of the images could not be loaded.
+	bool load_batch(std::vector<texture_handle>& handles, const std::vector<std::string>& paths, const std::vector<std::string>& names) {
+
+		std::vector<decoded_image> images;
+		decode_batch(images, paths);
+
+		return upload_batch(handles, images, paths, names);
+	}
+
+	bool load(unsigned int& texture_id, const char * path, const char * name) {
 
-			stbi_image_free(image_data);
+		texture_handle handle;
+		if (!load(handle, path, name)) {
 			return false;
 		}
 
-		glGenTextures(1, &texture_id);
-		glBindTexture(GL_TEXTURE_2D, texture_id);
+		texture_id = data::textures.at(handle).id;
+		return true;
+	}
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+	// returns the info of the texture 'handle' refers to, or nullptr when it has been unloaded
+	const texture_info* get(texture_handle handle) {
+		return data::textures.get(handle);
+	}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// deletes the texture 'handle' refers to, every handle to it becomes invalid
+	bool unload(texture_handle handle) {
 
-		data::loaded_textures.insert(std::make_pair(name, texture_info{ texture_id, name, x, y }));
+		const texture_info* info_ptr = data::textures.get(handle);
 
-		print_info("Loaded image ", std::quoted(path), " as ", std::quoted(name), ": [id:", texture_id, "][w:", x, ",h:", y, "]");
+		if (info_ptr == nullptr) {
+			print_error("unload Unkown image handle: ", handle.index);
+			return false;
+		}
 
-		stbi_image_free(image_data);
+		auto find = data::loaded_textures.find(info_ptr->name);
+		if (find != data::loaded_textures.end() && find->second == handle) {
+			data::loaded_textures.erase(find);
+		}
+
+		glDeleteTextures(1, &info_ptr->id);
+		data::textures.erase(handle);
 
 		return true;
 	}
@@ -115,6 +294,7 @@ namespace opengl::image {
 			shader::set(uniform_name, shader_id, data);
 
 			glBindTexture(GL_TEXTURE_2D, texture_id);
+			render_stats::count_texture_bind();
 		}
 		else {
 			print_error("bind Unkown image id: ", texture_id);
@@ -125,12 +305,10 @@ namespace opengl::image {
 
 		auto find = data::loaded_textures.find(name);
 
-		if (find != data::loaded_textures.end()) {
-
-			const auto& name_info_pair = *find;
+		const texture_info* info_ptr = find != data::loaded_textures.end() ? data::textures.get(find->second) : nullptr;
 
-			unsigned int texture_id = name_info_pair.second.id;
-			bind(uniform_name, texture_id, shader_id, tex_num);
+		if (info_ptr != nullptr) {
+			bind(uniform_name, info_ptr->id, shader_id, tex_num);
 		}
 		else {
 			print_error("bind Unkown image: ", std::quoted(name));
@@ -155,9 +333,9 @@ namespace opengl::image {
 		auto find = data::loaded_textures.find(name);
 
 		if (find != data::loaded_textures.end()) {
-			const auto& name_info_pair = *find;
-
-			return name_info_pair.second;
+			if (const texture_info* info_ptr = data::textures.get(find->second)) {
+				return *info_ptr;
+			}
 		}
 		
 		print_error("info Unkown image: ", std::quoted(name));
@@ -0,0 +1,219 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+
+#include "print.h"
+#include "shader.h"
+#include "transforms.h"
+#include "slot_map.h"
+#include "world.h"
+
+namespace world {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	// a placed copy of a model.
+	// the model is the asset: it owns the meshes, the buffers and the node hierarchy.
+	// an instance only owns a transform, so any amount of them can share one loaded model.
+	struct instance {
+
+		// the model this instance draws
+		model_handle asset{};
+
+		// the id of the program this instance is drawn with; it has to read its model matrices from the storage buffer
+		unsigned int shader_id = 0;
+
+		// returns the id of the transform of this instance in 'data::transforms'
+		const transform_store::transform_id& transform() const {
+			return transform_;
+		}
+
+		glm::vec3& position() { return data::transforms.position(transform_); }
+		const glm::vec3& position() const { return data::transforms.position(transform_); }
+
+		glm::vec3& scale() { return data::transforms.scale(transform_); }
+		const glm::vec3& scale() const { return data::transforms.scale(transform_); }
+
+		rotation_values& rotation() { return data::transforms.rotation(transform_); }
+		const rotation_values& rotation() const { return data::transforms.rotation(transform_); }
+
+		const glm::vec3& forward() const { return data::transforms.forward(transform_); }
+		const glm::vec3& up() const { return data::transforms.up(transform_); }
+		const glm::vec3& right() const { return data::transforms.right(transform_); }
+
+	private:
+		transform_store::transform_id transform_ = transform_store::invalid_id;
+
+		friend bool create_instance(containers::handle<instance>& handle, model_handle asset, unsigned int shader_id, const glm::vec3& position, const glm::vec3& scale, const rotation_values& rotation);
+	};
+
+	using instance_handle = containers::handle<instance>;
+
+	// instances that share an asset and a program.
+	// their model matrices are stored in [first, first + count) of 'instance_batches::matrices'.
+	struct instance_batch {
+		model_handle asset{};
+		unsigned int shader_id = 0;
+
+		std::size_t first = 0;
+		std::size_t count = 0;
+	};
+
+	// every instance of a frame, grouped into batches that can each be drawn with one instanced draw per mesh
+	struct instance_batches {
+		std::vector<instance_batch> batches;
+		std::vector<glm::mat4> matrices;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// every placed instance
+		containers::slot_map<instance> instances;
+
+		// transforms of removed instances, reused by the next instance that gets created
+		std::vector<transform_store::transform_id> free_instance_transforms;
+	}
+	// ============================================================================================================================
+
+	// places a new instance of 'asset', drawn with the program 'shader_id'
+	bool create_instance(
+		instance_handle& handle,
+		model_handle asset,
+		unsigned int shader_id,
+		const glm::vec3& position = {},
+		const glm::vec3& scale = { 1.f, 1.f, 1.f },
+		const rotation_values& rotation = {}
+	) {
+
+		if (!model_valid(asset)) {
+			print_error("create_instance Unknown model handle: ", asset.index);
+			return false;
+		}
+
+		transform_store::transform_id transform;
+
+		if (!data::free_instance_transforms.empty()) {
+			transform = data::free_instance_transforms.back();
+			data::free_instance_transforms.pop_back();
+
+			data::transforms.position(transform) = position;
+			data::transforms.scale(transform) = scale;
+			data::transforms.rotation(transform) = rotation;
+			data::transforms.update(transform);
+		}
+		else {
+			transform = data::transforms.create(position, scale, rotation);
+		}
+
+		// instances have no node of their own, the meshes are placed by the node hierarchy of the asset
+		render_ref& ref = data::transforms.render(transform);
+		ref.model = asset;
+		ref.node = scene_graph::no_parent;
+
+		handle = data::instances.emplace();
+
+		instance& new_instance = data::instances.at(handle);
+		new_instance.asset = asset;
+		new_instance.shader_id = shader_id;
+		new_instance.transform_ = transform;
+
+		return true;
+	}
+
+	bool create_instance(
+		instance_handle& handle,
+		model_handle asset,
+		shader::program_handle program,
+		const glm::vec3& position = {},
+		const glm::vec3& scale = { 1.f, 1.f, 1.f },
+		const rotation_values& rotation = {}
+	) {
+
+		const auto* program_ptr = shader::program_get(program);
+
+		if (program_ptr == nullptr) {
+			print_error("create_instance Unknown program handle: ", program.index);
+			return false;
+		}
+
+		return create_instance(handle, asset, program_ptr->id, position, scale, rotation);
+	}
+
+	// returns the instance 'handle' refers to, throws std::out_of_range when it has been removed
+	instance& instance_get(instance_handle handle) {
+		return data::instances.at(handle);
+	}
+
+	// returns true when 'handle' refers to an instance that has not been removed
+	bool instance_valid(instance_handle handle) {
+		return data::instances.valid(handle);
+	}
+
+	// removes an instance, its transform is handed to the next instance that gets created
+	bool destroy_instance(instance_handle handle) {
+
+		const instance* instance_ptr = data::instances.get(handle);
+
+		if (instance_ptr == nullptr) {
+			print_error("destroy_instance Unknown instance handle: ", handle.index);
+			return false;
+		}
+
+		data::transforms.render(instance_ptr->transform()) = render_ref{};
+		data::free_instance_transforms.push_back(instance_ptr->transform());
+
+		data::instances.erase(handle);
+		return true;
+	}
+
+	// groups every instance by asset and program and gathers their model matrices batch by batch.
+	// the first matrix of every batch is placed at a multiple of 'alignment' matrices, so a batch can be bound as a buffer range.
+	void collect_instances(instance_batches& output, std::size_t alignment = 1llu) {
+
+		assert(alignment > 0);
+
+		output.batches.clear();
+		output.matrices.clear();
+
+		using batch_key = std::tuple<model_handle, unsigned int, transform_store::transform_id>;
+
+		thread_local std::vector<batch_key> keys;
+		keys.clear();
+		keys.reserve(data::instances.size());
+
+		data::instances.for_each([&](instance_handle, const instance& inst) {
+			if (model_valid(inst.asset)) {
+				keys.emplace_back(inst.asset, inst.shader_id, inst.transform());
+			}
+		});
+
+		std::sort(keys.begin(), keys.end());
+
+		output.matrices.reserve(keys.size());
+
+		for (const auto& [asset, shader_id, transform] : keys) {
+
+			bool same_batch = !output.batches.empty()
+				&& output.batches.back().asset == asset
+				&& output.batches.back().shader_id == shader_id;
+
+			if (!same_batch) {
+
+				// pad the matrices up to the alignment of the next batch
+				std::size_t first = (output.matrices.size() + alignment - 1llu) / alignment * alignment;
+				output.matrices.resize(first);
+
+				instance_batch& batch = output.batches.emplace_back();
+				batch.asset = asset;
+				batch.shader_id = shader_id;
+				batch.first = first;
+			}
+
+			output.matrices.push_back(data::transforms.matrix(transform));
+			output.batches.back().count++;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,428 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <charconv>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <ostream>
+
+namespace json {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	enum value_type {
+		null_type = 0,
+		boolean_type,
+		number_type,
+		string_type,
+		array_type,
+		object_type
+	};
+
+	// a parsed JSON value.
+	// objects keep their members in the order of the document, lookups are linear which is fine for the small objects of
+	// file formats like glTF.
+	struct value {
+		value_type type = null_type;
+
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+
+		std::vector<value> array;
+		std::vector<std::pair<std::string, value>> object;
+
+		bool is_null() const { return type == null_type; }
+		bool is_boolean() const { return type == boolean_type; }
+		bool is_number() const { return type == number_type; }
+		bool is_string() const { return type == string_type; }
+		bool is_array() const { return type == array_type; }
+		bool is_object() const { return type == object_type; }
+
+		// returns the member 'key' of an object, or nullptr when there is no such member
+		const value* find(std::string_view key) const {
+			for (const auto& [name, member] : object) {
+				if (name == key) {
+					return &member;
+				}
+			}
+
+			return nullptr;
+		}
+
+		// returns the amount of elements of an array or members of an object
+		std::size_t size() const {
+			return type == array_type ? array.size() : object.size();
+		}
+
+		const value& operator[](std::size_t index) const {
+			return array[index];
+		}
+
+		double number_or(double fallback) const {
+			return type == number_type ? number : fallback;
+		}
+
+		// returns 'fallback' as well when the number is not whole or does not fit into 'T'
+		template<typename T>
+		T integer_or(T fallback) const {
+			static_assert(std::is_integral_v<T>, "integer_or reads integers");
+
+			if (type != number_type || !std::isfinite(number) || std::trunc(number) != number) {
+				return fallback;
+			}
+
+			// the maximum of a 64 bit integer rounds up to the next power of two as a double, so the upper bound is exclusive
+			if (number < static_cast<double>(std::numeric_limits<T>::lowest()) || number >= static_cast<double>(std::numeric_limits<T>::max()) + 1.0) {
+				return fallback;
+			}
+
+			return static_cast<T>(number);
+		}
+
+		bool boolean_or(bool fallback) const {
+			return type == boolean_type ? boolean : fallback;
+		}
+
+		const std::string& string_or(const std::string& fallback) const {
+			return type == string_type ? string : fallback;
+		}
+
+		// shorthands for members of objects, returning 'fallback' when the member is missing or of another type
+
+		double number_or(std::string_view key, double fallback) const {
+			const value* member = find(key);
+			return member != nullptr ? member->number_or(fallback) : fallback;
+		}
+
+		template<typename T>
+		T integer_or(std::string_view key, T fallback) const {
+			const value* member = find(key);
+			return member != nullptr ? member->integer_or(fallback) : fallback;
+		}
+
+		std::string string_or(std::string_view key, const std::string& fallback) const {
+			const value* member = find(key);
+			return member != nullptr ? member->string_or(fallback) : fallback;
+		}
+	};
+
+	// ============================================================================================================================
+
+	namespace detail {
+
+		struct parser {
+			const char* it;
+			const char* last;
+
+			std::string error;
+
+			// guards the stack against documents nested deep enough to overflow it
+			int depth = 0;
+			static constexpr int max_depth = 512;
+
+			void skip_whitespace() {
+				while (it < last && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r')) {
+					it++;
+				}
+			}
+
+			bool fail(const char* message) {
+				if (error.empty()) {
+					error = message;
+				}
+
+				return false;
+			}
+
+			bool literal(std::string_view text) {
+				if (static_cast<std::size_t>(last - it) < text.size() || std::string_view(it, text.size()) != text) {
+					return fail("unknown literal");
+				}
+
+				it += text.size();
+				return true;
+			}
+
+			static void append_utf8(std::string& output, std::uint32_t code_point) {
+				if (code_point < 0x80u) {
+					output.push_back(static_cast<char>(code_point));
+				}
+				else if (code_point < 0x800u) {
+					output.push_back(static_cast<char>(0xC0u | (code_point >> 6)));
+					output.push_back(static_cast<char>(0x80u | (code_point & 0x3Fu)));
+				}
+				else if (code_point < 0x10000u) {
+					output.push_back(static_cast<char>(0xE0u | (code_point >> 12)));
+					output.push_back(static_cast<char>(0x80u | ((code_point >> 6) & 0x3Fu)));
+					output.push_back(static_cast<char>(0x80u | (code_point & 0x3Fu)));
+				}
+				else {
+					output.push_back(static_cast<char>(0xF0u | (code_point >> 18)));
+					output.push_back(static_cast<char>(0x80u | ((code_point >> 12) & 0x3Fu)));
+					output.push_back(static_cast<char>(0x80u | ((code_point >> 6) & 0x3Fu)));
+					output.push_back(static_cast<char>(0x80u | (code_point & 0x3Fu)));
+				}
+			}
+
+			bool hex4(std::uint32_t& output) {
+				if (last - it < 4) {
+					return fail("unterminated unicode escape");
+				}
+
+				auto result = std::from_chars(it, it + 4, output, 16);
+				if (result.ec != std::errc() || result.ptr != it + 4) {
+					return fail("invalid unicode escape");
+				}
+
+				it += 4;
+				return true;
+			}
+
+			bool string(std::string& output) {
+				// skip the opening quote
+				it++;
+
+				while (it < last && *it != '"') {
+
+					// copy everything up to the next quote or escape in one go
+					const char* run = it;
+					while (it < last && *it != '"' && *it != '\\') {
+						it++;
+					}
+					output.append(run, it);
+
+					if (it < last && *it == '\\') {
+						it++;
+
+						if (it >= last) {
+							return fail("unterminated escape");
+						}
+
+						char escaped = *it++;
+						switch (escaped)
+						{
+						case '"': output.push_back('"'); break;
+						case '\\': output.push_back('\\'); break;
+						case '/': output.push_back('/'); break;
+						case 'b': output.push_back('\b'); break;
+						case 'f': output.push_back('\f'); break;
+						case 'n': output.push_back('\n'); break;
+						case 'r': output.push_back('\r'); break;
+						case 't': output.push_back('\t'); break;
+						case 'u': {
+							std::uint32_t code_point;
+							if (!hex4(code_point)) {
+								return false;
+							}
+
+							// a surrogate pair encodes a code point above the basic plane
+							if (code_point >= 0xD800u && code_point < 0xDC00u && last - it >= 6 && it[0] == '\\' && it[1] == 'u') {
+								it += 2;
+
+								std::uint32_t low;
+								if (!hex4(low)) {
+									return false;
+								}
+
+								code_point = 0x10000u + ((code_point - 0xD800u) << 10) + (low - 0xDC00u);
+							}
+
+							append_utf8(output, code_point);
+							break;
+						}
+						default:
+							return fail("unknown escape");
+						}
+					}
+				}
+
+				if (it >= last) {
+					return fail("unterminated string");
+				}
+
+				// skip the closing quote
+				it++;
+				return true;
+			}
+
+			bool number(double& output) {
+				// from_chars does not accept a leading '+', JSON does not allow one either
+				auto result = std::from_chars(it, last, output);
+				if (result.ec != std::errc()) {
+					return fail("invalid number");
+				}
+
+				it = result.ptr;
+				return true;
+			}
+
+			bool parse_value(value& output) {
+				skip_whitespace();
+
+				if (it >= last) {
+					return fail("unexpected end of document");
+				}
+
+				switch (*it)
+				{
+				case '{': {
+					if (++depth > max_depth) {
+						return fail("document nested too deep");
+					}
+
+					output.type = object_type;
+					it++;
+					skip_whitespace();
+
+					if (it < last && *it == '}') {
+						it++;
+						depth--;
+						return true;
+					}
+
+					while (true) {
+						skip_whitespace();
+
+						if (it >= last || *it != '"') {
+							return fail("expected a member name");
+						}
+
+						auto& member = output.object.emplace_back();
+						if (!string(member.first)) {
+							return false;
+						}
+
+						skip_whitespace();
+						if (it >= last || *it != ':') {
+							return fail("expected ':'");
+						}
+						it++;
+
+						if (!parse_value(member.second)) {
+							return false;
+						}
+
+						skip_whitespace();
+						if (it < last && *it == ',') {
+							it++;
+							continue;
+						}
+
+						if (it < last && *it == '}') {
+							it++;
+							depth--;
+							return true;
+						}
+
+						return fail("expected ',' or '}'");
+					}
+				}
+				case '[': {
+					if (++depth > max_depth) {
+						return fail("document nested too deep");
+					}
+
+					output.type = array_type;
+					it++;
+					skip_whitespace();
+
+					if (it < last && *it == ']') {
+						it++;
+						depth--;
+						return true;
+					}
+
+					while (true) {
+						if (!parse_value(output.array.emplace_back())) {
+							return false;
+						}
+
+						skip_whitespace();
+						if (it < last && *it == ',') {
+							it++;
+							continue;
+						}
+
+						if (it < last && *it == ']') {
+							it++;
+							depth--;
+							return true;
+						}
+
+						return fail("expected ',' or ']'");
+					}
+				}
+				case '"':
+					output.type = string_type;
+					return string(output.string);
+				case 't':
+					output.type = boolean_type;
+					output.boolean = true;
+					return literal("true");
+				case 'f':
+					output.type = boolean_type;
+					output.boolean = false;
+					return literal("false");
+				case 'n':
+					output.type = null_type;
+					return literal("null");
+				default:
+					output.type = number_type;
+					return number(output.number);
+				}
+			}
+		};
+	}
+
+	// parses a JSON document, 'error' describes what went wrong when false is returned
+	bool parse(std::string_view text, value& output, std::string& error) {
+
+		detail::parser p{ text.data(), text.data() + text.size(), std::string{} };
+
+		output = value{};
+		if (!p.parse_value(output)) {
+			error = p.error + " at byte " + std::to_string(p.it - text.data());
+			return false;
+		}
+
+		p.skip_whitespace();
+		if (p.it != p.last) {
+			error = "unexpected data after the document at byte " + std::to_string(p.it - text.data());
+			return false;
+		}
+
+		return true;
+	}
+
+	// writes 'text' as a JSON string, with the quotes
+	void write_string(std::ostream& output, std::string_view text) {
+
+		output << '"';
+
+		for (char c : text) {
+			switch (c) {
+			case '"': output << "\\\""; break;
+			case '\\': output << "\\\\"; break;
+			case '\n': output << "\\n"; break;
+			case '\r': output << "\\r"; break;
+			case '\t': output << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					static constexpr char hex[] = "0123456789abcdef";
+					output << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+				}
+				else {
+					output << c;
+				}
+			}
+		}
+
+		output << '"';
+	}
+}
\ No newline at end of file
@@ -0,0 +1,253 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// a byte oriented LZ77 codec that writes the LZ4 block format.
+// compression is a single greedy pass over a hash table of 4 byte sequences, decompression is a bounds checked copy loop.
+namespace lz {
+
+	namespace detail {
+		constexpr int hash_bits = 16;
+
+		// the format wants the last 5 bytes to be literals and the last match to start 12 bytes before the end
+		constexpr std::size_t last_literals = 5llu;
+		constexpr std::size_t match_limit = 12llu;
+		constexpr std::size_t min_match = 4llu;
+		constexpr std::size_t max_offset = 65535llu;
+
+		// literals and matches up to this length are decompressed with one fixed size copy
+		constexpr std::size_t fast_copy = 16llu;
+
+		std::uint32_t read32(const unsigned char* p) {
+			std::uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		std::uint32_t hash(std::uint32_t sequence) {
+			return (sequence * 2654435761u) >> (32 - hash_bits);
+		}
+
+		void write_length(unsigned char*& output, std::size_t length) {
+			while (length >= 255llu) {
+				*output++ = 255;
+				length -= 255llu;
+			}
+			*output++ = static_cast<unsigned char>(length);
+		}
+
+		// writes one sequence: 'literal_count' bytes from 'literals' followed by a match, or no match when 'match_length' is 0
+		void write_sequence(unsigned char*& output, const unsigned char* literals, std::size_t literal_count, std::size_t offset, std::size_t match_length) {
+
+			std::size_t match_code = match_length > 0llu ? match_length - min_match : 0llu;
+
+			*output++ = static_cast<unsigned char>((std::min<std::size_t>(literal_count, 15llu) << 4) | std::min<std::size_t>(match_code, 15llu));
+
+			if (literal_count >= 15llu) {
+				write_length(output, literal_count - 15llu);
+			}
+
+			std::memcpy(output, literals, literal_count);
+			output += literal_count;
+
+			if (match_length == 0llu) {
+				return;
+			}
+
+			*output++ = static_cast<unsigned char>(offset & 0xFFu);
+			*output++ = static_cast<unsigned char>(offset >> 8);
+
+			if (match_code >= 15llu) {
+				write_length(output, match_code - 15llu);
+			}
+		}
+
+		// reads the extension bytes of a literal or match length, returns false when the input ends first
+		bool read_length(const unsigned char*& input, const unsigned char* input_end, std::size_t limit, std::size_t& length) {
+			unsigned char byte;
+			do {
+				if (input >= input_end) {
+					return false;
+				}
+
+				byte = *input++;
+				length += byte;
+
+				// more than the output can hold, the data is corrupt
+				if (length > limit) {
+					return false;
+				}
+			} while (byte == 255);
+
+			return true;
+		}
+	}
+
+	// the most bytes 'compress' can write for 'size' input bytes
+	constexpr std::size_t compress_bound(std::size_t size) {
+		return size + size / 255llu + 16llu;
+	}
+
+	// compresses 'size' bytes of 'input' into 'output', which must hold 'compress_bound(size)' bytes.
+	// returns the amount of bytes written.
+	std::size_t compress(const void* input, std::size_t size, void* output) {
+		using namespace detail;
+
+		const auto* in = static_cast<const unsigned char*>(input);
+		auto* out = static_cast<unsigned char*>(output);
+		auto* out_begin = out;
+
+		std::size_t anchor = 0llu;
+
+		if (size > match_limit + 1llu) {
+
+			std::vector<std::uint32_t> table(1llu << hash_bits, 0u);
+
+			std::size_t position = 1llu;
+			std::size_t limit = size - match_limit;
+			std::size_t misses = 0llu;
+
+			while (position < limit) {
+
+				std::uint32_t sequence = read32(in + position);
+				std::uint32_t& slot = table[hash(sequence)];
+
+				std::size_t candidate = slot;
+				slot = static_cast<std::uint32_t>(position);
+
+				if (candidate >= position || position - candidate > max_offset || read32(in + candidate) != sequence) {
+					// skip ahead faster through data that does not compress
+					position += 1llu + (misses++ >> 6);
+					continue;
+				}
+
+				misses = 0llu;
+
+				// walk back over bytes before the match that are equal too
+				while (position > anchor && candidate > 0llu && in[position - 1llu] == in[candidate - 1llu]) {
+					position--;
+					candidate--;
+				}
+
+				std::size_t length = min_match;
+				std::size_t match_end = size - last_literals;
+				while (position + length < match_end && in[candidate + length] == in[position + length]) {
+					length++;
+				}
+
+				write_sequence(out, in + anchor, position - anchor, position - candidate, length);
+
+				position += length;
+				anchor = position;
+
+				// remember a position inside the match, repeated data often continues the same way
+				if (position - 2llu < limit) {
+					table[hash(read32(in + position - 2llu))] = static_cast<std::uint32_t>(position - 2llu);
+				}
+			}
+		}
+
+		write_sequence(out, in + anchor, size - anchor, 0llu, 0llu);
+
+		return static_cast<std::size_t>(out - out_begin);
+	}
+
+	// decompresses 'size' bytes of 'input' into 'output', which has to be exactly 'output_size' bytes.
+	// returns false when the input is corrupt or does not decompress to 'output_size' bytes.
+	bool decompress(const void* input, std::size_t size, void* output, std::size_t output_size) {
+		using namespace detail;
+
+		const auto* in = static_cast<const unsigned char*>(input);
+		const auto* in_end = in + size;
+
+		auto* out = static_cast<unsigned char*>(output);
+		std::size_t written = 0llu;
+
+		while (in < in_end) {
+
+			unsigned char token = *in++;
+
+			std::size_t literal_count = token >> 4;
+			if (literal_count == 15llu && !read_length(in, in_end, output_size, literal_count)) {
+				return false;
+			}
+
+			if (literal_count > static_cast<std::size_t>(in_end - in) || literal_count > output_size - written) {
+				return false;
+			}
+
+			// short runs are copied as a fixed 16 bytes while both buffers have room, the extra bytes get overwritten later
+			if (literal_count <= fast_copy && in_end - in >= static_cast<std::ptrdiff_t>(fast_copy) && output_size - written >= fast_copy) {
+				std::memcpy(out + written, in, fast_copy);
+			}
+			else {
+				std::memcpy(out + written, in, literal_count);
+			}
+			in += literal_count;
+			written += literal_count;
+
+			// the last sequence has no match
+			if (in == in_end) {
+				break;
+			}
+
+			if (in_end - in < 2) {
+				return false;
+			}
+
+			std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+			in += 2;
+
+			if (offset == 0llu || offset > written) {
+				return false;
+			}
+
+			std::size_t length = token & 15u;
+			if (length == 15llu && !read_length(in, in_end, output_size, length)) {
+				return false;
+			}
+			length += min_match;
+
+			if (length > output_size - written) {
+				return false;
+			}
+
+			unsigned char* destination = out + written;
+			const unsigned char* source = destination - offset;
+
+			if (length <= fast_copy && offset >= fast_copy && output_size - written >= fast_copy) {
+				std::memcpy(destination, source, fast_copy);
+			}
+			else if (offset >= length) {
+				std::memcpy(destination, source, length);
+			}
+			else {
+				// the match overlaps the bytes it produces, like a run of one repeated byte.
+				// the output repeats every 'offset' bytes, so every copy can reach back twice as far as the one before.
+				std::size_t copied = 0llu;
+				std::size_t distance = offset;
+
+				while (copied < length) {
+					std::size_t chunk = std::min(distance, length - copied);
+					std::memcpy(destination + copied, destination + copied - distance, chunk);
+
+					copied += chunk;
+					distance *= 2llu;
+				}
+			}
+
+			written += length;
+		}
+
+		return written == output_size;
+	}
+
+	// compresses 'input' into 'output', replacing its contents
+	void compress(const void* input, std::size_t size, std::vector<char>& output) {
+		output.resize(compress_bound(size));
+		output.resize(compress(input, size, output.data()));
+	}
+}
\ No newline at end of file
@@ -7,17 +7,96 @@
 #include "shader.h"
 #include "game.h"
 #include "image.h"
+#include "access_trace.h"
+#include "streaming.h"
+#include "profiler.h"
+#include "gpu_profiler.h"
+#include "trace_capture.h"
+#include "render_stats.h"
+#include "gl_intercept.h"
+#include "gl_capture.h"
+#include "benchmark.h"
 //#include "objects/sprite.h"
 
 #include <iostream>
+#include <chrono>
+#include <string_view>
+#include <cstdlib>
 
 // ============================================================================================================================
 constexpr auto initial_view_width = 1920;
 constexpr auto initial_view_height = 1080;
 const glm::vec4 clear_color{ 0.f, 0.f, 0.f, 1.f };
+constexpr auto startup_trace_path = "startup.trace";
+constexpr auto gl_capture_path = "frames.glcapture";
+constexpr auto benchmark_path = "benchmark.json";
+constexpr auto benchmark_asteroids = "150000";
+
+// frames slower than this are captured once everything is loaded, see 'trace_capture::update'
+constexpr auto slow_frame_capture_ms = 100.0;
 // ============================================================================================================================
 
-int main() {
+// --capture <frames>				captures the first frames into a trace file
+// --capture-slow-frames <ms>		captures frames that take longer than 'ms' once loaded, 0 turns it off
+// --gl-capture <frames>			records the GL calls of the first frames into 'gl_capture_path'
+// --replay <path>					plays a recording of GL calls, prints how long its frames took and quits
+// --benchmark <frames>				flies a fixed path for every asteroid count, writes the times to 'benchmark_path' and quits
+// --benchmark-asteroids <counts>	the asteroid counts of the benchmark, like 10000,50000,150000
+int main(int argc, char* argv[]) {
+
+	std::size_t capture_frames = 0llu;
+	double slow_frame_ms = slow_frame_capture_ms;
+	const char* replay_path = nullptr;
+	std::size_t benchmark_frames = 0llu;
+	const char* benchmark_counts = benchmark_asteroids;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string_view option = argv[i];
+
+		if (option == "--capture") {
+			capture_frames = std::strtoull(argv[i + 1], nullptr, 10);
+		}
+		else if (option == "--capture-slow-frames") {
+			slow_frame_ms = std::strtod(argv[i + 1], nullptr);
+		}
+		else if (option == "--gl-capture") {
+			gl_capture::capture_first_frames(std::strtoull(argv[i + 1], nullptr, 10), gl_capture_path);
+		}
+		else if (option == "--replay") {
+			replay_path = argv[i + 1];
+		}
+		else if (option == "--benchmark") {
+			benchmark_frames = std::strtoull(argv[i + 1], nullptr, 10);
+		}
+		else if (option == "--benchmark-asteroids") {
+			benchmark_counts = argv[i + 1];
+		}
+		else {
+			print_error("unknown option: ", option);
+		}
+	}
+
+	// a benchmark measures the frames as they are, no slow frame is captured in between
+	if (benchmark_frames > 0llu) {
+		benchmark::configure(benchmark_frames, benchmark_counts, benchmark_path);
+		slow_frame_ms = 0.0;
+	}
+
+	// the time to the first frame and until everything is loaded is measured from here
+	auto startup_start = std::chrono::steady_clock::now();
+	bool first_frame = true;
+	bool startup_reported = false;
+
+	profiler::set_thread_name("main");
+
+	// read ahead what the last startup read, while the window, the context and the shaders are created.
+	// this startup is recorded again, so the trace follows the assets as they change.
+	// a replay reads no assets, it neither reads ahead nor records.
+	io::prefetcher prefetch;
+	if (replay_path == nullptr) {
+		prefetch.start(startup_trace_path);
+		io::start_access_trace();
+	}
 
 	if (!sdl::create_window("OpenGL Test", 100, 100, initial_view_width, initial_view_height, false) ||
 		!opengl::create_opengl(initial_view_width, initial_view_height)) {
@@ -27,6 +106,16 @@ int main() {
 
 		return 1;
 	}
+
+	// a replay needs nothing but the context, and runs as fast as it can
+	if (replay_path != nullptr) {
+		sdl::set_vsync(false);
+
+		bool replayed = gl_capture::replay(replay_path, [] { sdl::swap_window(); });
+		sdl::destroy_window();
+
+		return replayed ? 0 : 1;
+	}
 /*
 	objects::sprite_sheet ss(glm::vec2(0.5f, 1.f), 4u, 8u, R"(assets/textures/sheet_01.png)");
 	ss.load();
@@ -37,9 +126,15 @@ int main() {
 
 	gui::init(sdl::window_ptr, sdl::gl_context);
 
-	// initialize any game data
+	// initialize any game data, the models keep loading in the background while the first frames are drawn
 	game::on_init();
 
+	if (capture_frames > 0llu) {
+		trace_capture::capture_next_frames(capture_frames);
+	}
+
+	benchmark::start();
+
 	print_info("all okay!");
 
 	// create an epmty SDL_Event variable to hold the current event while itterating below
@@ -49,12 +144,25 @@ int main() {
 	// keep running until should_quit becomes true
 	while (!global.should_quit()) {
 
+		profiler::begin_frame();
+		gpu_profiler::begin_frame();
+		trace_capture::update();
+		PROFILE_ZONE("frame");
+
+		benchmark::begin_frame();
+
 		opengl::clear_screen(clear_color);
 
 		// update the global timer
 		// this can be used to get the elapsed time between updates
 		main_timer.update();
 
+		// put what finished loading in the background into place, within the frame budget
+		{
+			PROFILE_ZONE("streaming update");
+			streaming::update();
+		}
+
 		bool had_mouse_update = false;
 		bool had_key_up_update = false;
 
@@ -101,9 +209,44 @@ int main() {
 
 		gui::render();
 
-		SDL_GL_SwapWindow(sdl::window_ptr);
+		benchmark::end_submit();
+
+		{
+			PROFILE_ZONE("swap");
+			sdl::swap_window();
+		}
+
+		render_stats::end_frame();
+		gl_intercept::end_frame();
+		gl_capture::end_frame();
+		benchmark::end_frame();
+
+		auto since_startup = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_start);
+
+		if (first_frame) {
+			print_info("first frame after ", since_startup.count(), " ms");
+			first_frame = false;
+		}
+
+		// the startup is over once everything is loaded, the trace covers all of it
+		if (!startup_reported && !streaming::is_loading()) {
+			print_info("loaded after ", since_startup.count(), " ms");
+			streaming::print_report();
+			startup_reported = true;
+
+			// the loading frames are slow on purpose
+			trace_capture::data::slow_frame_ms = slow_frame_ms;
+
+			io::save_access_trace(startup_trace_path);
+			prefetch.stop();
+		}
 	}
 
+	game::on_quit();
+
+	// a recording of more frames than were drawn covers the frames until here
+	gl_capture::stop();
+
 	sdl::destroy_window();
 
 	return 0;
@@ -0,0 +1,199 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "print.h"
+
+namespace io {
+
+	// ============================================================================================================================
+
+	// maps a whole file read-only into memory.
+	// the pages are loaded by the OS on first access, nothing is copied into a buffer of our own.
+	struct mapped_file {
+
+		mapped_file() = default;
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		mapped_file(mapped_file&& other) noexcept {
+			swap(other);
+		}
+
+		mapped_file& operator=(mapped_file&& other) noexcept {
+			close();
+			swap(other);
+			return *this;
+		}
+
+		~mapped_file() {
+			close();
+		}
+
+		// maps the file at 'path', returns false when it could not be opened
+		bool open(const char* path) {
+			close();
+
+#ifdef _WIN32
+			file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if (file_ == INVALID_HANDLE_VALUE) {
+				print_error("mapped_file could not open: ", path);
+				file_ = nullptr;
+				return false;
+			}
+
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file_, &file_size)) {
+				print_error("mapped_file could not read the size of: ", path);
+				close();
+				return false;
+			}
+
+			size_ = static_cast<std::size_t>(file_size.QuadPart);
+
+			// an empty file can not be mapped, but it is a valid file
+			if (size_ == 0llu) {
+				return true;
+			}
+
+			mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping_ == nullptr) {
+				print_error("mapped_file could not map: ", path);
+				close();
+				return false;
+			}
+
+			data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+#else
+			descriptor_ = ::open(path, O_RDONLY);
+
+			if (descriptor_ < 0) {
+				print_error("mapped_file could not open: ", path);
+				return false;
+			}
+
+			struct stat file_stat;
+			if (fstat(descriptor_, &file_stat) != 0) {
+				print_error("mapped_file could not read the size of: ", path);
+				close();
+				return false;
+			}
+
+			size_ = static_cast<std::size_t>(file_stat.st_size);
+
+			// an empty file can not be mapped, but it is a valid file
+			if (size_ == 0llu) {
+				return true;
+			}
+
+			void* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor_, 0);
+			data_ = address == MAP_FAILED ? nullptr : static_cast<const char*>(address);
+
+			if (data_ != nullptr) {
+				// the file is read front to back, let the OS read ahead
+				madvise(address, size_, MADV_SEQUENTIAL);
+			}
+#endif
+
+			if (data_ == nullptr) {
+				print_error("mapped_file could not map: ", path);
+				close();
+				return false;
+			}
+
+			return true;
+		}
+
+		void close() {
+#ifdef _WIN32
+			if (data_ != nullptr) {
+				UnmapViewOfFile(data_);
+			}
+
+			if (mapping_ != nullptr) {
+				CloseHandle(mapping_);
+			}
+
+			if (file_ != nullptr) {
+				CloseHandle(file_);
+			}
+
+			mapping_ = nullptr;
+			file_ = nullptr;
+#else
+			if (data_ != nullptr) {
+				munmap(const_cast<char*>(data_), size_);
+			}
+
+			if (descriptor_ >= 0) {
+				::close(descriptor_);
+			}
+
+			descriptor_ = -1;
+#endif
+
+			data_ = nullptr;
+			size_ = 0llu;
+		}
+
+		bool is_open() const {
+#ifdef _WIN32
+			return file_ != nullptr;
+#else
+			return descriptor_ >= 0;
+#endif
+		}
+
+		const char* data() const {
+			return data_;
+		}
+
+		std::size_t size() const {
+			return size_;
+		}
+
+		std::string_view view() const {
+			return std::string_view(data_, size_);
+		}
+
+	private:
+		void swap(mapped_file& other) {
+			std::swap(data_, other.data_);
+			std::swap(size_, other.size_);
+#ifdef _WIN32
+			std::swap(file_, other.file_);
+			std::swap(mapping_, other.mapping_);
+#else
+			std::swap(descriptor_, other.descriptor_);
+#endif
+		}
+
+		const char* data_ = nullptr;
+		std::size_t size_ = 0llu;
+
+#ifdef _WIN32
+		HANDLE file_ = nullptr;
+		HANDLE mapping_ = nullptr;
+#else
+		int descriptor_ = -1;
+#endif
+	};
+}
\ No newline at end of file
@@ -0,0 +1,1401 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <map>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <numeric>
+#include <algorithm>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+
+#include "print.h"
+#include "image.h"
+#include "vfs.h"
+#include "geometry_codec.h"
+#include "world.h"
+#include "profiler.h"
+
+namespace world {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	// a mesh read from an OBJ file, before it is packed into a model
+	struct obj_mesh {
+		// the name of the object or group the mesh belongs to
+		std::string name;
+		std::string material;
+
+		std::vector<vertex> verticies;
+		std::vector<unsigned int> indices;
+
+		// the path of the diffuse texture of the material, empty when it has none
+		std::string diffuse_path;
+	};
+
+	struct obj_scene {
+		std::vector<obj_mesh> meshes;
+
+		// the diffuse textures of the meshes that have one, in the order of the meshes.
+		// empty until 'read_obj' decoded them, 'fill_obj_model' uploads and frees them.
+		std::vector<opengl::image::decoded_image> textures;
+	};
+
+	namespace obj {
+
+		// marks an element a face corner does not refer to, like the normal in 'f 1/2 3/4 5/6'
+		constexpr std::int64_t missing = std::numeric_limits<std::int64_t>::min();
+
+		// negative indices of a chunk are stored with this subtracted, so they stay negative and apart from the positive ones
+		// even when they point back past the start of their chunk
+		constexpr std::int64_t relative_bias = std::int64_t(1) << 62;
+
+		// a corner of a face.
+		// positive indices in the file are global and stored 0 based. negative ones count back from the last element before
+		// the face, they are stored as (local index - relative_bias) until the chunks have been joined. the local index is
+		// negative when it points into the chunks before.
+		struct corner {
+			std::int64_t v = missing;
+			std::int64_t vt = missing;
+			std::int64_t vn = missing;
+		};
+
+		// the object, group or material changed before face 'first_face' of a chunk
+		struct segment {
+			std::size_t first_face = 0;
+			std::string name;
+			std::string material;
+			bool name_changed = false;
+			bool material_changed = false;
+		};
+
+		// everything parsed from a range of lines of the file
+		struct chunk {
+			const char* first = nullptr;
+			const char* last = nullptr;
+
+			std::vector<glm::vec3> positions;
+			std::vector<glm::vec3> colors;
+			std::vector<glm::vec3> normals;
+			std::vector<glm::vec2> texture_coordinates;
+
+			// the corners of face 'i' are [face_starts[i], face_starts[i + 1])
+			std::vector<corner> corners;
+			std::vector<std::size_t> face_starts;
+
+			std::vector<segment> segments;
+			std::vector<std::string> libraries;
+
+			// the index of the first element of this chunk in the joined arrays
+			std::size_t position_base = 0;
+			std::size_t normal_base = 0;
+			std::size_t texture_coordinate_base = 0;
+
+			bool failed = false;
+			std::size_t failed_line = 0;
+		};
+
+		// a range of faces of a chunk that ends up in a mesh
+		struct face_range {
+			std::size_t chunk = 0;
+			std::size_t first = 0;
+			std::size_t last = 0;
+		};
+
+		// identifies a vertex for deduplication: the elements it was built from plus the normal generated for it
+		struct vertex_key {
+			std::int64_t v;
+			std::int64_t vt;
+			std::int64_t vn;
+			glm::vec3 normal;
+
+			bool operator==(const vertex_key& rhs) const {
+				return v == rhs.v && vt == rhs.vt && vn == rhs.vn && normal == rhs.normal;
+			}
+		};
+
+		struct vertex_key_hash {
+			std::size_t operator()(const vertex_key& key) const {
+
+				auto mix = [](std::size_t seed, std::uint64_t value) {
+					return seed ^ (value + 0x9e3779b97f4a7c15llu + (seed << 6) + (seed >> 2));
+				};
+
+				std::uint32_t normal_bits[3];
+				std::memcpy(normal_bits, &key.normal, sizeof(normal_bits));
+
+				std::size_t seed = static_cast<std::size_t>(key.v);
+				seed = mix(seed, static_cast<std::uint64_t>(key.vt));
+				seed = mix(seed, static_cast<std::uint64_t>(key.vn));
+				seed = mix(seed, normal_bits[0]);
+				seed = mix(seed, normal_bits[1]);
+				seed = mix(seed, normal_bits[2]);
+
+				return seed;
+			}
+		};
+
+		// finds the vertex that was built from a key, or remembers a new one.
+		// an open addressing table of vertex indices; the keys themselves are stored once per vertex, in insertion order.
+		struct vertex_table {
+
+			static constexpr unsigned int empty = std::numeric_limits<unsigned int>::max();
+
+			void reserve(std::size_t amount) {
+				keys_.reserve(amount);
+				rehash(amount * 2llu);
+			}
+
+			// returns the index of the vertex built from 'key' and whether it has just been added
+			std::pair<unsigned int, bool> insert(const vertex_key& key) {
+
+				if ((keys_.size() + 1llu) * 2llu > slots_.size()) {
+					rehash(slots_.size() * 2llu);
+				}
+
+				std::size_t mask = slots_.size() - 1llu;
+				std::size_t slot = vertex_key_hash{}(key) & mask;
+
+				while (slots_[slot] != empty) {
+					if (keys_[slots_[slot]] == key) {
+						return { slots_[slot], false };
+					}
+
+					slot = (slot + 1llu) & mask;
+				}
+
+				auto index = static_cast<unsigned int>(keys_.size());
+				slots_[slot] = index;
+				keys_.push_back(key);
+
+				return { index, true };
+			}
+
+		private:
+			void rehash(std::size_t amount) {
+
+				std::size_t capacity = 16llu;
+				while (capacity < amount) {
+					capacity *= 2llu;
+				}
+
+				slots_.assign(capacity, empty);
+
+				std::size_t mask = capacity - 1llu;
+				for (std::size_t i = 0; i < keys_.size(); i++) {
+
+					std::size_t slot = vertex_key_hash{}(keys_[i]) & mask;
+					while (slots_[slot] != empty) {
+						slot = (slot + 1llu) & mask;
+					}
+
+					slots_[slot] = static_cast<unsigned int>(i);
+				}
+			}
+
+			std::vector<unsigned int> slots_;
+			std::vector<vertex_key> keys_;
+		};
+
+		// what the load flags of 'load_model' ask for
+		struct options {
+			bool join_identical_vertices = true;
+			bool flat_normals = false;
+			bool smooth_normals = false;
+
+			// faces of the same material end up in one mesh, whichever object or group they belong to
+			bool optimize_meshes = false;
+		};
+
+		// the smallest amount of bytes parsed by one task, smaller files are not worth splitting up
+		constexpr std::size_t min_chunk_size = 1024llu * 1024llu;
+
+		// ========================================================================================================================
+
+		bool is_space(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		void skip_spaces(const char*& it, const char* last) {
+			while (it < last && is_space(*it)) {
+				it++;
+			}
+		}
+
+		// returns the rest of the line without surrounding whitespace
+		std::string_view rest_of_line(const char* it, const char* line_end) {
+			skip_spaces(it, line_end);
+
+			const char* end = line_end;
+			while (end > it && is_space(end[-1])) {
+				end--;
+			}
+
+			return std::string_view(it, static_cast<std::size_t>(end - it));
+		}
+
+		bool parse_float(const char*& it, const char* last, float& value) {
+			skip_spaces(it, last);
+
+			// from_chars does not accept a leading '+'
+			if (it < last && *it == '+') {
+				it++;
+			}
+
+			auto result = std::from_chars(it, last, value);
+			if (result.ec != std::errc()) {
+				return false;
+			}
+
+			it = result.ptr;
+			return true;
+		}
+
+		bool parse_index(const char*& it, const char* last, std::int64_t& value) {
+
+			if (it < last && *it == '+') {
+				it++;
+			}
+
+			auto result = std::from_chars(it, last, value);
+			if (result.ec != std::errc() || value == 0) {
+				return false;
+			}
+
+			it = result.ptr;
+			return true;
+		}
+
+		// stores an index of the file in the form described at 'corner', returns false when it is too far back for any file
+		bool to_stored_index(std::int64_t index, std::size_t local_count, std::int64_t& output) {
+
+			if (index > 0) {
+				output = index - 1;
+				return true;
+			}
+
+			if (index < -(relative_bias / 2)) {
+				return false;
+			}
+
+			output = static_cast<std::int64_t>(local_count) + index - relative_bias;
+			return true;
+		}
+
+		// parses a face corner: v, v/vt, v//vn or v/vt/vn
+		bool parse_corner(const char*& it, const char* last, const chunk& c, corner& output) {
+
+			std::int64_t index;
+
+			if (!parse_index(it, last, index) || !to_stored_index(index, c.positions.size(), output.v)) {
+				return false;
+			}
+
+			if (it < last && *it == '/') {
+				it++;
+
+				if (it < last && *it != '/') {
+					if (!parse_index(it, last, index) || !to_stored_index(index, c.texture_coordinates.size(), output.vt)) {
+						return false;
+					}
+				}
+
+				if (it < last && *it == '/') {
+					it++;
+
+					if (!parse_index(it, last, index) || !to_stored_index(index, c.normals.size(), output.vn)) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		bool starts_with(const char* it, const char* line_end, std::string_view keyword) {
+			auto length = static_cast<std::size_t>(line_end - it);
+
+			return length > keyword.size()
+				&& std::memcmp(it, keyword.data(), keyword.size()) == 0
+				&& is_space(it[keyword.size()]);
+		}
+
+		// parses every line of a chunk
+		void parse_chunk(chunk& c) {
+
+			std::size_t line = 0;
+
+			const char* it = c.first;
+			while (it < c.last) {
+
+				const char* line_end = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(c.last - it)));
+				if (line_end == nullptr) {
+					line_end = c.last;
+				}
+
+				line++;
+				skip_spaces(it, line_end);
+
+				bool ok = true;
+
+				if (it == line_end || *it == '#') {
+					// empty line or comment
+				}
+				else if (starts_with(it, line_end, "v")) {
+					it += 1;
+
+					glm::vec3 position;
+					ok = parse_float(it, line_end, position.x) && parse_float(it, line_end, position.y) && parse_float(it, line_end, position.z);
+
+					// some exporters write a vertex color after the position
+					glm::vec3 color;
+					bool has_color = ok
+						&& parse_float(it, line_end, color.x)
+						&& parse_float(it, line_end, color.y)
+						&& parse_float(it, line_end, color.z);
+
+					if (has_color && c.colors.size() < c.positions.size()) {
+						c.colors.resize(c.positions.size(), glm::vec3(1.f, 1.f, 1.f));
+					}
+
+					c.positions.push_back(position);
+
+					if (has_color) {
+						c.colors.push_back(color);
+					}
+					else if (!c.colors.empty()) {
+						c.colors.emplace_back(1.f, 1.f, 1.f);
+					}
+				}
+				else if (starts_with(it, line_end, "vt")) {
+					it += 2;
+
+					glm::vec2 coordinates;
+					ok = parse_float(it, line_end, coordinates.x);
+
+					// the second coordinate is optional
+					if (!parse_float(it, line_end, coordinates.y)) {
+						coordinates.y = 0.f;
+					}
+
+					c.texture_coordinates.push_back(coordinates);
+				}
+				else if (starts_with(it, line_end, "vn")) {
+					it += 2;
+
+					glm::vec3 normal;
+					ok = parse_float(it, line_end, normal.x) && parse_float(it, line_end, normal.y) && parse_float(it, line_end, normal.z);
+
+					c.normals.push_back(normal);
+				}
+				else if (starts_with(it, line_end, "f")) {
+					it += 1;
+
+					std::size_t first_corner = c.corners.size();
+
+					skip_spaces(it, line_end);
+					while (ok && it < line_end) {
+						corner face_corner;
+						ok = parse_corner(it, line_end, c, face_corner);
+
+						c.corners.push_back(face_corner);
+						skip_spaces(it, line_end);
+					}
+
+					if (ok) {
+						c.face_starts.push_back(first_corner);
+					}
+					else {
+						c.corners.resize(first_corner);
+					}
+				}
+				else if (starts_with(it, line_end, "o") || starts_with(it, line_end, "g")) {
+					it += 1;
+
+					segment& s = c.segments.emplace_back();
+					s.first_face = c.face_starts.size();
+					s.name = rest_of_line(it, line_end);
+					s.name_changed = true;
+				}
+				else if (starts_with(it, line_end, "usemtl")) {
+					it += 6;
+
+					segment& s = c.segments.emplace_back();
+					s.first_face = c.face_starts.size();
+					s.material = rest_of_line(it, line_end);
+					s.material_changed = true;
+				}
+				else if (starts_with(it, line_end, "mtllib")) {
+					it += 6;
+
+					c.libraries.emplace_back(rest_of_line(it, line_end));
+				}
+
+				// everything else: smoothing groups, lines, points and free form geometry, is not used
+
+				if (!ok && !c.failed) {
+					c.failed = true;
+					c.failed_line = line;
+				}
+
+				it = line_end + 1;
+			}
+
+			c.face_starts.push_back(c.corners.size());
+		}
+
+		// splits the file into chunks of whole lines
+		std::vector<chunk> split_into_chunks(const char* data, std::size_t size) {
+
+			std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+			std::size_t amount = std::clamp<std::size_t>(size / min_chunk_size, 1, threads * 4);
+
+			std::vector<chunk> chunks(amount);
+
+			const char* first = data;
+			const char* last = data + size;
+
+			for (std::size_t i = 0; i < amount; i++) {
+
+				const char* end = i + 1 == amount ? last : data + size * (i + 1) / amount;
+
+				// move the end of the chunk behind the next line break
+				if (end < first) {
+					end = first;
+				}
+
+				const char* line_end = end < last ? static_cast<const char*>(std::memchr(end, '\n', static_cast<std::size_t>(last - end))) : nullptr;
+				end = line_end == nullptr ? last : line_end + 1;
+
+				chunks[i].first = first;
+				chunks[i].last = end;
+
+				first = end;
+			}
+
+			return chunks;
+		}
+
+		// turns a stored index into an index of the joined arrays, returns false when it is out of range.
+		// 'base' is how many elements the chunks before the one of the index hold, a relative index is counted from there.
+		bool resolve(std::int64_t stored, std::size_t base, std::size_t count, std::int64_t& output) {
+
+			if (stored == missing) {
+				output = missing;
+				return true;
+			}
+
+			output = stored >= 0 ? stored : static_cast<std::int64_t>(base) + (stored + relative_bias);
+			return output >= 0 && static_cast<std::size_t>(output) < count;
+		}
+
+		// parses a file split into two chunks, whose second chunk has faces that point back into the first one with
+		// relative indices, and checks that they resolve to the right positions. returns false when they do not.
+		bool check_relative_indices() {
+
+			constexpr std::string_view text = "v 0 0 0\nv 1 0 0\nv 2 0 0\nv 3 0 0\nf -4 -3 -2\nf -3 -2 -1\n";
+			constexpr std::int64_t expected[] = { 0, 1, 2, 1, 2, 3 };
+
+			// the first chunk holds the first two positions only
+			chunk chunks[2];
+			chunks[0].first = text.data();
+			chunks[0].last = text.data() + 16;
+			chunks[1].first = chunks[0].last;
+			chunks[1].last = text.data() + text.size();
+
+			for (auto& c : chunks) {
+				parse_chunk(c);
+			}
+
+			chunks[1].position_base = chunks[0].positions.size();
+
+			const chunk& c = chunks[1];
+			if (chunks[0].failed || c.failed || c.corners.size() != std::size(expected)) {
+				return false;
+			}
+
+			for (std::size_t i = 0; i < c.corners.size(); i++) {
+				std::int64_t resolved;
+				if (!resolve(c.corners[i].v, c.position_base, 4llu, resolved) || resolved != expected[i]) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// the material library of an OBJ file: material name to diffuse texture path
+		using material_library = std::unordered_map<std::string, std::string>;
+
+		void parse_material_library(const std::filesystem::path& path, material_library& output) {
+
+			io::file_view file;
+			if (!io::open_file(path.generic_string(), file)) {
+				print_error("parse_obj could not open material library: ", path.generic_string());
+				return;
+			}
+
+			std::string current;
+
+			const char* it = file.data();
+			const char* last = file.data() + file.size();
+
+			while (it < last) {
+
+				const char* line_end = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(last - it)));
+				if (line_end == nullptr) {
+					line_end = last;
+				}
+
+				skip_spaces(it, line_end);
+
+				if (starts_with(it, line_end, "newmtl")) {
+					current = rest_of_line(it + 6, line_end);
+					output[current];
+				}
+				else if (starts_with(it, line_end, "map_Kd") && !current.empty()) {
+
+					// options like '-s 1 1 1' may come before the file name, which is always last
+					std::string_view arguments = rest_of_line(it + 6, line_end);
+					auto space = arguments.find_last_of(" \t");
+
+					output[current] = std::string(space == std::string_view::npos ? arguments : arguments.substr(space + 1));
+				}
+
+				it = line_end + 1;
+			}
+		}
+	}
+
+	// ============================================================================================================================
+
+	// parses an OBJ file and its material libraries without touching OpenGL.
+	// the file is read through the file layer, mapped or straight from a pack, and its lines are parsed in parallel chunks.
+	// 'load_flags' are interpreted like ASSIMP does: normals are generated for faces that have none when
+	// 'aiProcess_GenNormals' or 'aiProcess_GenSmoothNormals' is set, identical verticies are joined with 'aiProcess_JoinIdenticalVertices'
+	// and 'aiProcess_OptimizeMeshes' joins the meshes of the same material into one, named after the first of them.
+	// unlike ASSIMP without 'aiProcess_Triangulate', polygons are always split into triangles. other flags are ignored.
+	bool parse_obj(const char* path, unsigned int load_flags, obj_scene& output) {
+		PROFILE_ZONE("parse_obj");
+
+#ifdef DEBUG
+		// relative indices that reach into the chunk before are easy to get wrong, they are checked on the first parse
+		static std::once_flag relative_indices_checked;
+		std::call_once(relative_indices_checked, []() {
+			if (!obj::check_relative_indices()) {
+				print_error("parse_obj resolves relative indices across chunks wrong");
+			}
+		});
+#endif
+
+		io::file_view file;
+		if (!io::open_file(path, file)) {
+			print_error("parse_obj could not open: ", path);
+			return false;
+		}
+
+		obj::options options;
+		options.join_identical_vertices = (load_flags & aiProcess_JoinIdenticalVertices) != 0;
+		options.smooth_normals = (load_flags & aiProcess_GenSmoothNormals) != 0;
+		options.flat_normals = !options.smooth_normals && (load_flags & aiProcess_GenNormals) != 0;
+		options.optimize_meshes = (load_flags & aiProcess_OptimizeMeshes) != 0;
+
+		// parse ===================================================================================================================
+
+		auto chunks = obj::split_into_chunks(file.data(), file.size());
+
+		std::for_each(std::execution::par, chunks.begin(), chunks.end(), [](obj::chunk& c) {
+			obj::parse_chunk(c);
+		});
+
+		for (const auto& c : chunks) {
+			if (c.failed) {
+				print_error("parse_obj malformed line ", c.failed_line, " of chunk at byte ", c.first - file.data(), " in: ", path);
+				return false;
+			}
+		}
+
+		// join the elements of all chunks =========================================================================================
+
+		std::size_t position_count = 0, normal_count = 0, texture_coordinate_count = 0;
+		bool has_colors = false;
+
+		for (auto& c : chunks) {
+			c.position_base = position_count;
+			c.normal_base = normal_count;
+			c.texture_coordinate_base = texture_coordinate_count;
+
+			position_count += c.positions.size();
+			normal_count += c.normals.size();
+			texture_coordinate_count += c.texture_coordinates.size();
+			has_colors = has_colors || !c.colors.empty();
+		}
+
+		std::vector<glm::vec3> positions, colors, normals;
+		std::vector<glm::vec2> texture_coordinates;
+
+		positions.reserve(position_count);
+		normals.reserve(normal_count);
+		texture_coordinates.reserve(texture_coordinate_count);
+
+		if (has_colors) {
+			colors.reserve(position_count);
+		}
+
+		for (auto& c : chunks) {
+			positions.insert(positions.end(), c.positions.begin(), c.positions.end());
+			normals.insert(normals.end(), c.normals.begin(), c.normals.end());
+			texture_coordinates.insert(texture_coordinates.end(), c.texture_coordinates.begin(), c.texture_coordinates.end());
+
+			if (has_colors) {
+				colors.insert(colors.end(), c.colors.begin(), c.colors.end());
+				colors.resize(positions.size(), glm::vec3(1.f, 1.f, 1.f));
+			}
+
+			std::vector<glm::vec3>().swap(c.positions);
+			std::vector<glm::vec3>().swap(c.colors);
+			std::vector<glm::vec3>().swap(c.normals);
+			std::vector<glm::vec2>().swap(c.texture_coordinates);
+		}
+
+		// sort the faces into meshes, one per object and material ================================================================
+
+		std::map<std::pair<std::string, std::string>, std::size_t> mesh_indices;
+		std::vector<std::vector<obj::face_range>> mesh_faces;
+		std::vector<std::string> libraries;
+
+		std::string name = std::filesystem::path(path).stem().string();
+		std::string material;
+
+		auto add_faces = [&](std::size_t chunk_index, std::size_t first, std::size_t last) {
+			if (first == last) {
+				return;
+			}
+
+			auto [found, inserted] = mesh_indices.try_emplace({ options.optimize_meshes ? std::string() : name, material }, output.meshes.size());
+
+			if (inserted) {
+				obj_mesh& new_mesh = output.meshes.emplace_back();
+				new_mesh.name = name;
+				new_mesh.material = material;
+				mesh_faces.emplace_back();
+			}
+
+			mesh_faces[found->second].push_back(obj::face_range{ chunk_index, first, last });
+		};
+
+		for (std::size_t i = 0; i < chunks.size(); i++) {
+
+			const auto& c = chunks[i];
+			std::size_t face_count = c.face_starts.size() - 1llu;
+			std::size_t first = 0;
+
+			for (const auto& s : c.segments) {
+				add_faces(i, first, s.first_face);
+				first = s.first_face;
+
+				if (s.name_changed) {
+					name = s.name;
+				}
+
+				if (s.material_changed) {
+					material = s.material;
+				}
+			}
+
+			add_faces(i, first, face_count);
+			libraries.insert(libraries.end(), c.libraries.begin(), c.libraries.end());
+		}
+
+		// build the meshes in parallel ============================================================================================
+
+		std::atomic<bool> out_of_range = false;
+
+		std::vector<std::size_t> mesh_order(output.meshes.size());
+		std::iota(mesh_order.begin(), mesh_order.end(), 0llu);
+
+		std::for_each(std::execution::par, mesh_order.begin(), mesh_order.end(), [&](std::size_t mesh_index) {
+
+			obj_mesh& mesh = output.meshes[mesh_index];
+
+			std::size_t corner_count = 0;
+			for (const auto& range : mesh_faces[mesh_index]) {
+				const auto& c = chunks[range.chunk];
+				corner_count += c.face_starts[range.last] - c.face_starts[range.first];
+			}
+
+			obj::vertex_table known;
+			if (options.join_identical_vertices) {
+				known.reserve(corner_count);
+			}
+
+			// the normal of every position, summed up over all faces of this mesh that use it
+			std::unordered_map<std::int64_t, glm::vec3> smooth_normals;
+
+			mesh.verticies.reserve(corner_count);
+			mesh.indices.reserve(corner_count * 3llu / 2llu);
+
+			std::vector<obj::corner> face;
+			std::vector<unsigned int> face_verticies;
+
+			for (int pass = options.smooth_normals ? 0 : 1; pass < 2; pass++) {
+				for (const auto& range : mesh_faces[mesh_index]) {
+
+					const auto& c = chunks[range.chunk];
+
+					for (std::size_t f = range.first; f < range.last; f++) {
+
+						std::size_t first_corner = c.face_starts[f];
+						std::size_t last_corner = c.face_starts[f + 1];
+
+						if (last_corner - first_corner < 3llu) {
+							continue;
+						}
+
+						face.clear();
+						for (std::size_t i = first_corner; i < last_corner; i++) {
+							obj::corner resolved;
+
+							bool in_range = obj::resolve(c.corners[i].v, c.position_base, positions.size(), resolved.v)
+								&& obj::resolve(c.corners[i].vt, c.texture_coordinate_base, texture_coordinates.size(), resolved.vt)
+								&& obj::resolve(c.corners[i].vn, c.normal_base, normals.size(), resolved.vn);
+
+							if (!in_range || resolved.v == obj::missing) {
+								out_of_range = true;
+								return;
+							}
+
+							face.push_back(resolved);
+						}
+
+						glm::vec3 face_normal{};
+						if (options.flat_normals || options.smooth_normals) {
+							const glm::vec3& a = positions[face[0].v];
+							const glm::vec3& b = positions[face[1].v];
+							const glm::vec3& d = positions[face[2].v];
+
+							face_normal = glm::cross(b - a, d - a);
+							float length = glm::length(face_normal);
+							face_normal = length > 0.f ? face_normal / length : glm::vec3{};
+						}
+
+						if (pass == 0) {
+							for (const auto& face_corner : face) {
+								if (face_corner.vn == obj::missing) {
+									smooth_normals[face_corner.v] += face_normal;
+								}
+							}
+
+							continue;
+						}
+
+						face_verticies.clear();
+						for (const auto& face_corner : face) {
+
+							obj::vertex_key key{ face_corner.v, face_corner.vt, face_corner.vn, glm::vec3{} };
+
+							if (face_corner.vn == obj::missing && options.flat_normals) {
+								key.normal = face_normal;
+							}
+							else if (face_corner.vn == obj::missing && options.smooth_normals) {
+								glm::vec3 sum = smooth_normals[face_corner.v];
+								float length = glm::length(sum);
+								key.normal = length > 0.f ? sum / length : glm::vec3{};
+							}
+
+							if (options.join_identical_vertices) {
+								auto [index, added] = known.insert(key);
+								if (!added) {
+									face_verticies.push_back(index);
+									continue;
+								}
+							}
+
+							auto index = static_cast<unsigned int>(mesh.verticies.size());
+
+							vertex& vert = mesh.verticies.emplace_back();
+							vert.position = positions[key.v];
+							vert.normal = key.vn != obj::missing ? normals[key.vn] : key.normal;
+
+							if (key.vt != obj::missing) {
+								vert.texture_coordinates = texture_coordinates[key.vt];
+							}
+
+							if (has_colors) {
+								vert.color = colors[key.v];
+							}
+
+							face_verticies.push_back(index);
+						}
+
+						// split polygons into a fan of triangles
+						for (std::size_t i = 2; i < face_verticies.size(); i++) {
+							mesh.indices.push_back(face_verticies[0]);
+							mesh.indices.push_back(face_verticies[i - 1]);
+							mesh.indices.push_back(face_verticies[i]);
+						}
+					}
+				}
+			}
+		});
+
+		if (out_of_range) {
+			print_error("parse_obj face refers to an element that does not exist in: ", path);
+			output.meshes.clear();
+			return false;
+		}
+
+		// meshes without triangles, like those of a group that only has lines, are dropped
+		output.meshes.erase(
+			std::remove_if(output.meshes.begin(), output.meshes.end(), [](const obj_mesh& mesh) { return mesh.indices.empty(); }),
+			output.meshes.end()
+		);
+
+		// resolve the textures of the materials ==================================================================================
+
+		auto directory = std::filesystem::path(path);
+		directory.remove_filename();
+
+		obj::material_library materials;
+
+		for (const auto& line : libraries) {
+
+			// a single 'mtllib' can name multiple files
+			std::size_t first = 0;
+			while (first < line.size()) {
+				std::size_t last = line.find_first_of(" \t", first);
+				if (last == std::string::npos) {
+					last = line.size();
+				}
+
+				if (last > first) {
+					obj::parse_material_library(directory / line.substr(first, last - first), materials);
+				}
+
+				first = last + 1;
+			}
+		}
+
+		for (auto& mesh : output.meshes) {
+			auto found = materials.find(mesh.material);
+
+			if (found != materials.end() && !found->second.empty()) {
+				mesh.diffuse_path = (directory / found->second).generic_string();
+			}
+		}
+
+		return true;
+	}
+
+	// CACHE ======================================================================================================================
+
+	namespace data {
+		// when set, 'load_obj' writes a cache next to every OBJ file it had to parse
+		bool write_obj_caches = false;
+	}
+
+	namespace obj {
+
+		constexpr char cache_magic[4] = { 'O', 'B', 'J', 'C' };
+		constexpr std::uint32_t cache_version = 3u;
+
+		// a cache holds the meshes 'parse_obj' produced for one file and one set of load flags.
+		// every mesh is its names followed by its verticies and indices, encoded with the geometry codec.
+		struct cache_header {
+			char magic[4];
+			std::uint32_t version;
+			std::uint32_t load_flags;
+			std::uint32_t mesh_count;
+
+			// the size of the OBJ file the cache was made from, a cache of another size is stale
+			std::uint64_t source_size;
+
+			// the bounding box of every mesh, so a model can be placed before its meshes are read
+			glm::vec3 bounds_min;
+			glm::vec3 bounds_max;
+		};
+
+		std::string cache_path(const char* path) {
+			return std::string(path) + ".cache";
+		}
+
+		void write_bytes(std::vector<char>& output, const void* bytes, std::size_t size) {
+			output.insert(output.end(), static_cast<const char*>(bytes), static_cast<const char*>(bytes) + size);
+		}
+
+		template<typename T>
+		void write_value(std::vector<char>& output, const T& value) {
+			write_bytes(output, &value, sizeof(T));
+		}
+
+		// strings and encoded streams are stored as their size followed by their bytes
+		void write_block(std::vector<char>& output, std::string_view block) {
+			write_value(output, static_cast<std::uint64_t>(block.size()));
+			write_bytes(output, block.data(), block.size());
+		}
+
+		struct cache_reader {
+			const char* it;
+			const char* last;
+
+			template<typename T>
+			bool read_value(T& output) {
+				if (static_cast<std::size_t>(last - it) < sizeof(T)) {
+					return false;
+				}
+
+				std::memcpy(&output, it, sizeof(T));
+				it += sizeof(T);
+				return true;
+			}
+
+			bool read_block(std::string_view& output) {
+				std::uint64_t size;
+				if (!read_value(size) || static_cast<std::uint64_t>(last - it) < size) {
+					return false;
+				}
+
+				output = std::string_view(it, static_cast<std::size_t>(size));
+				it += size;
+				return true;
+			}
+		};
+
+		// a mesh of the cache whose streams have been located but not decoded yet
+		struct cached_mesh {
+			std::string_view verticies;
+			std::string_view indices;
+		};
+	}
+
+	// writes the meshes of 'scene', parsed from 'path' with 'load_flags', into the cache of 'path'
+	bool save_obj_cache(const char* path, unsigned int load_flags, const obj_scene& scene) {
+		PROFILE_ZONE("save_obj_cache");
+
+		obj::cache_header header{};
+		std::memcpy(header.magic, obj::cache_magic, sizeof(obj::cache_magic));
+		header.version = obj::cache_version;
+		header.load_flags = load_flags;
+		header.mesh_count = static_cast<std::uint32_t>(scene.meshes.size());
+
+		if (!io::file_size(path, header.source_size)) {
+			print_error("save_obj_cache source file not found: ", path);
+			return false;
+		}
+
+		bool first = true;
+		for (const auto& mesh : scene.meshes) {
+			for (const auto& vert : mesh.verticies) {
+				header.bounds_min = first ? vert.position : glm::min(header.bounds_min, vert.position);
+				header.bounds_max = first ? vert.position : glm::max(header.bounds_max, vert.position);
+				first = false;
+			}
+		}
+
+		std::vector<char> output;
+		obj::write_value(output, header);
+
+		std::vector<char> encoded;
+
+		for (const auto& mesh : scene.meshes) {
+			obj::write_block(output, mesh.name);
+			obj::write_block(output, mesh.material);
+			obj::write_block(output, mesh.diffuse_path);
+
+			obj::write_value(output, static_cast<std::uint64_t>(mesh.verticies.size()));
+			obj::write_value(output, static_cast<std::uint64_t>(mesh.indices.size()));
+
+			codec::encode_verticies(mesh.verticies.data(), mesh.verticies.size(), sizeof(vertex), encoded);
+			obj::write_block(output, std::string_view(encoded.data(), encoded.size()));
+
+			codec::encode_indices(mesh.indices.data(), mesh.indices.size(), encoded);
+			obj::write_block(output, std::string_view(encoded.data(), encoded.size()));
+		}
+
+		std::string cache_path = obj::cache_path(path);
+		io::release_mapped_file(cache_path);
+
+		std::ofstream file(cache_path, std::ios::binary | std::ios::trunc);
+		file.write(output.data(), static_cast<std::streamsize>(output.size()));
+
+		if (!file) {
+			print_error("save_obj_cache could not write: ", cache_path);
+			return false;
+		}
+
+		return true;
+	}
+
+	namespace obj {
+
+		// opens the cache of 'path' and reads its header into 'header', 'reader' is left right behind it.
+		// returns false without an error when there is no cache, or when it was made from another file or with other flags.
+		bool open_cache(const char* path, unsigned int load_flags, io::file_view& file, cache_reader& reader, cache_header& header) {
+
+			std::string cache_path = obj::cache_path(path);
+
+			if (!io::open_file(cache_path, file)) {
+				return false;
+			}
+
+			reader = cache_reader{ file.data(), file.data() + file.size() };
+
+			if (!reader.read_value(header) || std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version) {
+				print_error("load_obj_cache not a cache or of an unsupported version: ", cache_path);
+				return false;
+			}
+
+			std::uint64_t source_size;
+			bool has_source = io::file_size(path, source_size);
+
+			if (header.load_flags != load_flags || (has_source && source_size != header.source_size)) {
+				return false;
+			}
+
+			// a cache on disk that is older than the OBJ file next to it is stale, even when the size did not change
+			std::error_code source_error, cache_error;
+			auto source_time = std::filesystem::last_write_time(path, source_error);
+			auto cache_time = std::filesystem::last_write_time(cache_path, cache_error);
+			if (!source_error && !cache_error && source_time > cache_time) {
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	// reads only the bounding box of the meshes of 'path' from its cache, without decoding any of them.
+	// returns false without an error when there is no up to date cache.
+	bool load_obj_bounds(const char* path, unsigned int load_flags, bounds& output) {
+
+		io::file_view file;
+		obj::cache_reader reader{};
+		obj::cache_header header;
+
+		if (!obj::open_cache(path, load_flags, file, reader, header)) {
+			return false;
+		}
+
+		output.min = header.bounds_min;
+		output.max = header.bounds_max;
+		return true;
+	}
+
+	// reads the meshes of 'path' from its cache, the cache can be on disk or in a pack.
+	// returns false without an error when there is no cache, or when it was made from another file or with other flags.
+	bool load_obj_cache(const char* path, unsigned int load_flags, obj_scene& output) {
+		PROFILE_ZONE("load_obj_cache");
+
+		std::string cache_path = obj::cache_path(path);
+
+		io::file_view file;
+		obj::cache_reader reader{};
+		obj::cache_header header;
+
+		if (!obj::open_cache(path, load_flags, file, reader, header)) {
+			return false;
+		}
+
+		output.meshes.resize(header.mesh_count);
+		std::vector<obj::cached_mesh> streams(header.mesh_count);
+
+		for (std::size_t i = 0; i < output.meshes.size(); i++) {
+			auto& mesh = output.meshes[i];
+
+			std::string_view name, material, diffuse_path;
+			std::uint64_t vertex_count = 0, index_count = 0;
+
+			bool valid = reader.read_block(name)
+				&& reader.read_block(material)
+				&& reader.read_block(diffuse_path)
+				&& reader.read_value(vertex_count)
+				&& reader.read_value(index_count)
+				&& reader.read_block(streams[i].verticies)
+				&& reader.read_block(streams[i].indices)
+				// a corrupt count must not allocate more than the streams could ever decode to
+				&& vertex_count <= (streams[i].verticies.size() + 16llu) * 256llu / sizeof(vertex)
+				&& index_count <= (streams[i].indices.size() + 16llu) * 256llu / sizeof(unsigned int);
+
+			if (!valid) {
+				print_error("load_obj_cache truncated cache: ", cache_path);
+				output.meshes.clear();
+				return false;
+			}
+
+			mesh.name = name;
+			mesh.material = material;
+			mesh.diffuse_path = diffuse_path;
+			mesh.verticies.resize(vertex_count);
+			mesh.indices.resize(index_count);
+		}
+
+		std::vector<std::size_t> mesh_order(output.meshes.size());
+		std::iota(mesh_order.begin(), mesh_order.end(), 0llu);
+
+		std::atomic<bool> decoded = true;
+
+		std::for_each(std::execution::par, mesh_order.begin(), mesh_order.end(), [&](std::size_t i) {
+			auto& mesh = output.meshes[i];
+
+			bool valid = codec::decode_verticies(streams[i].verticies.data(), streams[i].verticies.size(), mesh.verticies.data(), mesh.verticies.size(), sizeof(vertex))
+				&& codec::decode_indices(streams[i].indices.data(), streams[i].indices.size(), mesh.indices.data(), mesh.indices.size());
+
+			if (!valid) {
+				decoded = false;
+			}
+		});
+
+		if (!decoded) {
+			print_error("load_obj_cache corrupt geometry in: ", cache_path);
+			output.meshes.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	// packs every file below 'directory' like 'io::write_pack_directory', except that OBJ files go in as their caches.
+	// the cache of every OBJ file is made again with 'load_flags', which have to be the flags the game loads it with,
+	// so the geometry in the pack is stored by the geometry codec instead of as text.
+	// the OBJ text is left out, 'load_obj_cache' takes a cache without its OBJ file as up to date.
+	bool write_obj_pack(const char* pack_path, const char* directory, unsigned int load_flags = default_load_flags) {
+		PROFILE_ZONE("write_obj_pack");
+
+		std::vector<std::string> paths;
+		if (!io::list_directory(directory, paths)) {
+			return false;
+		}
+
+		for (auto& path : paths) {
+
+			auto extension = std::filesystem::path(path).extension().generic_string();
+			if (extension != ".obj" && extension != ".OBJ") {
+				continue;
+			}
+
+			obj_scene scene;
+			if (!parse_obj(path.c_str(), load_flags, scene) || !save_obj_cache(path.c_str(), load_flags, scene)) {
+				print_error("write_obj_pack could not make the cache of: ", path);
+				return false;
+			}
+
+			path = obj::cache_path(path.c_str());
+		}
+
+		// caches that were already on disk are now listed twice
+		std::sort(paths.begin(), paths.end());
+		paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+		return io::write_pack(pack_path, paths);
+	}
+
+	// reads the meshes of an OBJ file and decodes their textures without touching OpenGL, so it can be called from any thread.
+	// the meshes are read from the cache of the file instead when there is an up to date one, see 'parse_obj'.
+	bool read_obj(const char* path, unsigned int load_flags, obj_scene& output) {
+		PROFILE_ZONE("read_obj");
+
+		if (!load_obj_cache(path, load_flags, output)) {
+
+			if (!parse_obj(path, load_flags, output)) {
+				return false;
+			}
+
+			if (data::write_obj_caches) {
+				save_obj_cache(path, load_flags, output);
+			}
+		}
+
+		// the textures of every mesh are read and decoded together
+		std::vector<std::string> texture_paths;
+
+		for (const auto& mesh : output.meshes) {
+			if (!mesh.diffuse_path.empty()) {
+				texture_paths.push_back(mesh.diffuse_path);
+			}
+		}
+
+		opengl::image::decode_batch(output.textures, texture_paths);
+		return true;
+	}
+
+	// moves the meshes of 'scene' into a model that has no meshes yet and uploads their textures.
+	// every object gets a node below the root node of the model, like ASSIMP does.
+	void fill_obj_model(model& into_model, obj_scene& scene) {
+		PROFILE_ZONE("fill_obj_model");
+
+		if (into_model.placeholder_) {
+			// the root of a placeholder was added long before its meshes and a subtree has to be added in one go,
+			// so the meshes get a new root. the old one is left in the graph without a model, nothing moves it anymore.
+			into_model.root_node_ = data::scene.add_node(scene_graph::no_parent, data::transforms.matrix(into_model.transform_));
+			data::transforms.render(into_model.transform_).node = into_model.root_node_;
+		}
+
+		mesh_pool_size pool_size;
+		for (const auto& mesh : scene.meshes) {
+			pool_size.meshes++;
+			pool_size.name_length += mesh.name.size();
+			pool_size.verticies += mesh.verticies.size();
+			pool_size.indices += mesh.indices.size();
+			pool_size.textures += mesh.diffuse_path.empty() ? 0llu : 1llu;
+		}
+
+		into_model.meshes_.reserve(pool_size.meshes, pool_size.verticies, pool_size.indices, pool_size.textures, pool_size.name_length);
+
+		std::vector<std::string> texture_paths;
+		std::vector<std::string> texture_names;
+
+		for (const auto& mesh : scene.meshes) {
+			if (!mesh.diffuse_path.empty()) {
+				texture_paths.push_back(mesh.diffuse_path);
+				texture_names.push_back(mesh.name + "_diffuse");
+			}
+		}
+
+		// a scene that did not come from 'read_obj' has its textures decoded here
+		if (scene.textures.size() != texture_paths.size()) {
+			opengl::image::decode_batch(scene.textures, texture_paths);
+		}
+
+		std::vector<opengl::image::texture_handle> textures;
+		opengl::image::upload_batch(textures, scene.textures, texture_paths, texture_names);
+
+		std::unordered_map<std::string, scene_graph::node_id> object_nodes;
+		std::size_t next_texture = 0llu;
+
+		for (auto& mesh : scene.meshes) {
+
+			auto [found, inserted] = object_nodes.try_emplace(mesh.name, scene_graph::no_parent);
+			if (inserted) {
+				found->second = data::scene.add_node(into_model.root_node_);
+			}
+
+			mesh_data new_mesh;
+			new_mesh.name = mesh.name;
+			new_mesh.verticies = std::move(mesh.verticies);
+			new_mesh.indices = std::move(mesh.indices);
+
+			if (!mesh.diffuse_path.empty()) {
+
+				if (const auto* info = opengl::image::get(textures[next_texture])) {
+					new_mesh.textures.emplace_back(info->id, texture_type::diffuse_texture);
+				}
+
+				next_texture++;
+			}
+
+			into_model.meshes_.add_mesh(new_mesh, found->second);
+		}
+
+		calculate_bounds(into_model);
+		into_model.placeholder_ = false;
+	}
+
+	// builds a model from a scene read by 'read_obj' with 'load_flags', returns the handle of the loaded model.
+	// uploads the textures of the model, so it has to be called on the thread that owns the GL context.
+	bool load_obj(model_handle& handle, obj_scene& scene, const char* path, unsigned int load_flags = default_load_flags) {
+
+		auto new_handle = data::loaded_models.emplace();
+
+		model& model_ref = data::loaded_models.at(new_handle);
+		model_ref.id_ = new_handle.index;
+		model_ref.path_to_file_ = path;
+		model_ref.load_flags_ = load_flags;
+
+		create_transform(model_ref, new_handle);
+		fill_obj_model(model_ref, scene);
+
+		handle = new_handle;
+		return true;
+	}
+
+	// loads a model from an OBJ file without ASSIMP, see 'read_obj' and 'parse_obj' for the load flags it follows
+	bool load_obj(model_handle& handle, const char* path, unsigned int load_flags = default_load_flags) {
+
+		obj_scene scene;
+		if (!read_obj(path, load_flags, scene)) {
+			return false;
+		}
+
+		return load_obj(handle, scene, path, load_flags);
+	}
+
+	// loads 'path' with 'parse_obj' and with ASSIMP 'runs' times each, prints the best time of both and
+	// whether they produced the same amount of meshes, verticies and indices.
+	// nothing is uploaded or kept, so it can be pointed at files of hundreds of megabytes.
+	void benchmark_obj(const char* path, unsigned int load_flags = default_load_flags, int runs = 3) {
+
+		using clock = std::chrono::steady_clock;
+
+		auto best_native = std::chrono::duration<double, std::milli>::max();
+		auto best_assimp = std::chrono::duration<double, std::milli>::max();
+
+		std::size_t native_meshes = 0, native_verticies = 0, native_indices = 0;
+		std::size_t assimp_meshes = 0, assimp_verticies = 0, assimp_indices = 0;
+
+		for (int run = 0; run < runs; run++) {
+
+			auto start = clock::now();
+
+			obj_scene scene;
+			if (!parse_obj(path, load_flags, scene)) {
+				return;
+			}
+
+			best_native = std::min(best_native, std::chrono::duration<double, std::milli>(clock::now() - start));
+
+			native_meshes = scene.meshes.size();
+			native_verticies = native_indices = 0;
+
+			for (const auto& mesh : scene.meshes) {
+				native_verticies += mesh.verticies.size();
+				native_indices += mesh.indices.size();
+			}
+		}
+
+		for (int run = 0; run < runs; run++) {
+
+			auto start = clock::now();
+
+			// triangulate, so the index counts can be compared
+			Assimp::Importer importer;
+			const aiScene* scene = importer.ReadFile(path, load_flags | aiProcess_Triangulate);
+
+			if (scene == nullptr) {
+				print_error("benchmark_obj ASSIMP failed: ", importer.GetErrorString());
+				return;
+			}
+
+			best_assimp = std::min(best_assimp, std::chrono::duration<double, std::milli>(clock::now() - start));
+
+			assimp_meshes = scene->mNumMeshes;
+			assimp_verticies = assimp_indices = 0;
+
+			for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+				assimp_verticies += scene->mMeshes[i]->mNumVertices;
+
+				for (unsigned int y = 0; y < scene->mMeshes[i]->mNumFaces; y++) {
+					assimp_indices += scene->mMeshes[i]->mFaces[y].mNumIndices;
+				}
+			}
+		}
+
+		print_info("benchmark_obj ", path);
+		print_info("  native: ", best_native.count(), " ms, ", native_meshes, " meshes, ", native_verticies, " verticies, ", native_indices, " indices");
+		print_info("  assimp: ", best_assimp.count(), " ms, ", assimp_meshes, " meshes, ", assimp_verticies, " verticies, ", assimp_indices, " indices");
+
+		if (native_verticies != assimp_verticies || native_indices != assimp_indices) {
+			print_error("benchmark_obj the loaders do not agree on ", path);
+		}
+	}
+}
\ No newline at end of file
@@ -168,9 +168,10 @@ namespace objects {
 				}
 
 				auto size = static_cast<GLsizei>(mesh.index_size());
+				auto offset = (void*)(mesh.index_offset() * sizeof(unsigned int));
 
 				glBindVertexArray(mesh.vao());
-				glDrawElementsInstanced(global.draw_mode(), size, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(sprites_.size()));
+				glDrawElementsInstancedBaseVertex(global.draw_mode(), size, GL_UNSIGNED_INT, offset, static_cast<GLsizei>(sprites_.size()), static_cast<GLint>(mesh.vertex_offset()));
 				glBindVertexArray(0);
 			}
 		}
@@ -181,7 +182,7 @@ namespace objects {
 			std::string name = "plane";
 			auto normal = glm::vec3(0.f, 0.f, 1.f);
 
-			std::initializer_list<world::mesh> mesh{
+			std::initializer_list<world::mesh_data> mesh{
 				{	name,
 					{
 						{ // 0
@@ -232,7 +233,7 @@ namespace objects {
 		glm::vec2 sprite_size;
 		glm::vec2 uv_rect;
 
-		std::size_t model_id = 0;
+		world::model_handle model_id{};
 
 		const char * path_to_file;
 
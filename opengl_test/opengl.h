@@ -3,14 +3,40 @@
 #include "sdl.h"
 #include "print.h"
 #include "world.h"
+#include "instances.h"
 #include "shader.h"
 #include "globals.h"
 #include "camera.h"
+#include "profiler.h"
+#include "render_stats.h"
+#include "gl_intercept.h"
+#include "gl_capture.h"
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 
 namespace opengl {
 
+	namespace data {
+		// the storage buffer the matrices of all instances are streamed into every frame
+		unsigned int instance_buffer = 0u;
+		std::size_t instance_buffer_size = 0llu;
+
+		// a batch is bound as a range of the instance buffer, its offset has to be a multiple of this.
+		// it is asked for once in 'create_opengl', a query like it every frame can stall the driver.
+		std::size_t storage_offset_alignment = 0llu;
+
+		// the batches of the current frame, kept around so their memory is reused
+		world::instance_batches instance_batches;
+
+		// the edges of a unit box and the program that stretches them over the bounds of a model that is still loading
+		unsigned int bounds_vao = 0u;
+		unsigned int bounds_vbo = 0u;
+		unsigned int bounds_ebo = 0u;
+		unsigned int bounds_shader = 0u;
+
+		glm::vec4 placeholder_color{ 0.2f, 0.8f, 1.f, 1.f };
+	}
+
 	// ============================================================================================================================
 	void opengl_debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam) {
 		print_error(message);
@@ -40,11 +66,23 @@ namespace opengl {
 	bool create_opengl(int width, int height) {
 		// load all the OpenGL methods using glad
 		// assert that everything went okay
-		if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
+		if (!gladLoadGLLoader((GLADloadproc)sdl::get_proc_address)) {
 			print_error("GLAD failed to load");
 			return false;
 		}
 
+#ifdef HEADLESS
+		// the frames go into a framebuffer object, there is no window to draw into
+		if (!headless::create_framebuffer()) {
+			return false;
+		}
+#endif
+
+		gl_intercept::install();
+
+		// recorded last, so the recording is played back through the intercept layer too
+		gl_capture::install();
+
 		auto gl_major = GLVersion.major;
 		auto gl_minor = GLVersion.minor;
 
@@ -64,6 +102,10 @@ namespace opengl {
 		);
 #endif // DEBUG
 
+		GLint offset_alignment = 0;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+		data::storage_offset_alignment = static_cast<std::size_t>(offset_alignment);
+
 		// enable depth testing and face culling
 		glEnable(GL_DEPTH_TEST);
 		glEnable(GL_CULL_FACE);
@@ -90,6 +132,7 @@ namespace opengl {
 		glBindBuffer(GL_UNIFORM_BUFFER, buffer_id);
 
 		glBufferData(GL_UNIFORM_BUFFER, amount_gl, &data, GL_STATIC_DRAW);
+		render_stats::count_buffer_upload(amount_sizet);
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
 		return buffer_id;
@@ -111,6 +154,7 @@ namespace opengl {
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_id);
 
 		glBufferData(GL_SHADER_STORAGE_BUFFER, amount_gl, &data, GL_DYNAMIC_DRAW);
+		render_stats::count_buffer_upload(amount_sizet);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer_id);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
@@ -130,6 +174,7 @@ namespace opengl {
 
 		if (glIsBuffer(buffer_id) == GL_TRUE) {
 			glNamedBufferSubData(buffer_id, offset, size, &data);
+			render_stats::count_buffer_upload(sizeof(T));
 		}
 		else {
 			print_error("Unknown buffer: ", buffer_id);
@@ -146,9 +191,8 @@ namespace opengl {
 
 	// ============================================================================================================================
 
-	void draw(const world::mesh& mesh, unsigned int shader_id) {
-		glBindVertexArray(mesh.vao());
-
+	// binds the textures of a mesh
+	void bind_textures(const world::mesh& mesh, unsigned int shader_id) {
 
 		if (mesh.has_textures()) {
 			mesh.for_each_texture([&](const std::size_t& i, const world::texture& tex) {
@@ -159,65 +203,275 @@ namespace opengl {
 				image::bind(name.c_str(), tex.id, shader_id, tex_num);
 			});
 		}
+	}
+
+	// the triangles of one draw of 'mesh', lines and points are no triangles
+	std::uint64_t triangles_of(const world::mesh& mesh) {
+		return global.draw_mode() == GL_TRIANGLES ? mesh.index_size() / 3llu : 0llu;
+	}
+
+	// draws the range of a mesh in the buffers of its model, the VAO of the model has to be bound
+	void draw_elements(const world::mesh& mesh, unsigned int shader_id) {
 
-		glDrawElements(global.draw_mode(), static_cast<int>(mesh.index_size()), GL_UNSIGNED_INT, nullptr);
+		bind_textures(mesh, shader_id);
+
+		glDrawElementsBaseVertex(
+			global.draw_mode(),
+			static_cast<GLsizei>(mesh.index_size()),
+			GL_UNSIGNED_INT,
+			(void*)(mesh.index_offset() * sizeof(unsigned int)),
+			static_cast<GLint>(mesh.vertex_offset())
+		);
+		render_stats::count_draw(triangles_of(mesh));
+	}
+
+	void draw(const world::mesh& mesh, unsigned int shader_id) {
+		glBindVertexArray(mesh.vao());
+		render_stats::count_vao_bind();
+		draw_elements(mesh, shader_id);
 		glBindVertexArray(0);
 		glActiveTexture(GL_TEXTURE0);
 	}
 
+	// creates the box and the program 'draw_bounds' draws with
+	bool setup_bounds() {
+
+		if (!shader::load_shader(data::bounds_shader, shader::bounds_vert, shader::bounds_frag)) {
+			return false;
+		}
+
+		constexpr float corners[] = {
+			0.f, 0.f, 0.f,	1.f, 0.f, 0.f,	1.f, 1.f, 0.f,	0.f, 1.f, 0.f,
+			0.f, 0.f, 1.f,	1.f, 0.f, 1.f,	1.f, 1.f, 1.f,	0.f, 1.f, 1.f
+		};
+
+		constexpr unsigned int edges[] = {
+			0, 1, 1, 2, 2, 3, 3, 0,
+			4, 5, 5, 6, 6, 7, 7, 4,
+			0, 4, 1, 5, 2, 6, 3, 7
+		};
+
+		glGenVertexArrays(1, &data::bounds_vao);
+		glGenBuffers(1, &data::bounds_vbo);
+		glGenBuffers(1, &data::bounds_ebo);
+
+		glBindVertexArray(data::bounds_vao);
+
+		glBindBuffer(GL_ARRAY_BUFFER, data::bounds_vbo);
+		glNamedBufferData(data::bounds_vbo, sizeof(corners), corners, GL_STATIC_DRAW);
+		render_stats::count_buffer_upload(sizeof(corners));
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data::bounds_ebo);
+		glNamedBufferData(data::bounds_ebo, sizeof(edges), edges, GL_STATIC_DRAW);
+		render_stats::count_buffer_upload(sizeof(edges));
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	// draws the edges of 'box', placed by 'matrix'
+	void draw_bounds(camera& use_camera, const world::bounds& box, const glm::mat4& matrix, const glm::vec4& color) {
+		PROFILE_ZONE("draw_bounds");
+
+		if (data::bounds_vao == 0u && !setup_bounds()) {
+			return;
+		}
+
+		glUseProgram(data::bounds_shader);
+		render_stats::count_program_bind();
+
+		shader::set("projection", data::bounds_shader, use_camera.projection(sdl::get_aspect_ratio()));
+		shader::set("view", data::bounds_shader, use_camera.view());
+		shader::set("model", data::bounds_shader, matrix);
+		shader::set("box_min", data::bounds_shader, box.min);
+		shader::set("box_max", data::bounds_shader, box.max);
+		shader::set("color", data::bounds_shader, color);
+
+		glBindVertexArray(data::bounds_vao);
+		render_stats::count_vao_bind();
+
+		glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, nullptr);
+		render_stats::count_draw(0llu);
+		glBindVertexArray(0);
+	}
+
 	void draw(camera& use_camera, const world::model& model, unsigned int shader_id) {
+		PROFILE_ZONE("draw");
+
+		// a model that is still loading is drawn as its bounding box
+		if (model.is_placeholder()) {
+			draw_bounds(use_camera, model.local_bounds(), world::data::scene.world(model.root_node()), data::placeholder_color);
+			return;
+		}
 
 		glUseProgram(static_cast<GLuint>(shader_id));
+		render_stats::count_program_bind();
 
 		//shader::set("another_name", shader_id, glm::mat4{ 1.f });
 		shader::set("projection", shader_id, use_camera.projection(sdl::get_aspect_ratio()));
 		shader::set("view", shader_id, use_camera.view());
 
-		auto translate	= glm::translate(glm::mat4(1.f), model.position);
-
-		auto rotate_y	= glm::rotate(translate, glm::radians(model.rotation.angle_y), glm::vec3(0.f, 1.f, 0.f));
-		auto rotate_z	= glm::rotate(rotate_y, glm::radians(model.rotation.angle_z), glm::vec3(0.f, 0.f, 1.f));
-		auto rotate_x	= glm::rotate(rotate_z, glm::radians(model.rotation.angle_x), glm::vec3(1.f, 0.f, 0.f));
-
-		auto scale		= glm::scale(rotate_x, model.scale);
-
-		shader::set("model", shader_id, scale);
+		// all meshes of a model share one set of buffers
+		glBindVertexArray(model.meshes().vao());
+		render_stats::count_vao_bind();
 
 		for (const auto & mesh : model) {
-			draw(mesh, model.shader_id);
+			shader::set("model", shader_id, world::data::scene.world(mesh.node()));
+			draw_elements(mesh, model.shader_id);
 		}
+
+		glBindVertexArray(0);
+		glActiveTexture(GL_TEXTURE0);
 	}
 
 	void draw(camera& use_camera, const world::model& model) {
 		draw(use_camera, model, model.shader_id);
 	}
 
+	// the "origin" of the instanced shaders: where a node of a model sits relative to the root of the model.
+	// the instance matrices place the model, so the transform of the model itself must not be in it as well.
+	struct instance_origin {
+
+		explicit instance_origin(const world::model& model)
+			: to_model_(glm::inverse(world::data::scene.world(model.root_node())))
+		{}
+
+		glm::mat4 operator()(world::scene_graph::node_id node) const {
+			return to_model_ * world::data::scene.world(node);
+		}
+
+	private:
+		glm::mat4 to_model_;
+	};
+
 	template<typename T>
 	void draw_instanced(camera& use_camera, const world::model& model, const T& instance_amount) {
+		PROFILE_ZONE("draw_instanced");
+
+		// there is nothing to draw yet, a box for every instance would cost more than the model itself
+		if (model.is_placeholder()) {
+			return;
+		}
 
 		glUseProgram(model.shader_id);
+		render_stats::count_program_bind();
 
-		//shader::set("origin", model.shader_id, glm::mat4{ 1.f });
 		shader::set("projection", model.shader_id, use_camera.projection(sdl::get_aspect_ratio()));
 		shader::set("view", model.shader_id, use_camera.view());
 
+		instance_origin origin(model);
+
+		glBindVertexArray(model.meshes().vao());
+		render_stats::count_vao_bind();
+
 		for (const auto& mesh : model) {
 
-			if (mesh.has_textures()) {
-				mesh.for_each_texture([&](const std::size_t& i, const world::texture& tex) {
+			// places the mesh relative to every instance
+			shader::set("origin", model.shader_id, origin(mesh.node()));
+
+			bind_textures(mesh, model.shader_id);
+
+			glDrawElementsInstancedBaseVertex(
+				global.draw_mode(),
+				static_cast<GLsizei>(mesh.index_size()),
+				GL_UNSIGNED_INT,
+				(void*)(mesh.index_offset() * sizeof(unsigned int)),
+				static_cast<GLsizei>(instance_amount),
+				static_cast<GLint>(mesh.vertex_offset())
+			);
+			render_stats::count_draw(triangles_of(mesh), static_cast<std::uint64_t>(instance_amount));
+		}
 
-					auto tex_num = static_cast<image::texture_number>(static_cast<int>(i) + static_cast<int>(image::TEXTURE0));
-					auto name = tex.name(i);
+		glBindVertexArray(0);
+	}
 
-					image::bind(name.c_str(), tex.id, model.shader_id, tex_num);
-				});
+	// draws 'model' once for every matrix in the storage buffer 'buffer_id'
+	template<typename T>
+	void draw_instanced(camera& use_camera, const world::model& model, const T& instance_amount, unsigned int buffer_id) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer_id);
+		draw_instanced(use_camera, model, instance_amount);
+	}
+
+	// draws every 'world::instance'.
+	// instances of the same model and program are drawn together: one instanced draw per mesh, however many instances there are.
+	void draw_instances(camera& use_camera) {
+		PROFILE_ZONE("draw_instances");
+
+		// every batch is bound as a range of the buffer, so it has to start at the offset alignment
+		std::size_t alignment = std::max(data::storage_offset_alignment, sizeof(glm::mat4));
+		std::size_t matrix_alignment = (alignment + sizeof(glm::mat4) - 1llu) / sizeof(glm::mat4);
+
+		auto& batches = data::instance_batches;
+		world::collect_instances(batches, matrix_alignment);
+
+		if (batches.batches.empty()) {
+			return;
+		}
+
+		auto size = batches.matrices.size() * sizeof(glm::mat4);
+
+		if (data::instance_buffer == 0u) {
+			glGenBuffers(1, &data::instance_buffer);
+		}
+
+		// grow the buffer when needed, otherwise orphan it, so the driver does not wait for the last frame to finish drawing
+		data::instance_buffer_size = std::max(data::instance_buffer_size, size);
+		glNamedBufferData(data::instance_buffer, static_cast<GLsizeiptr>(data::instance_buffer_size), nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(data::instance_buffer, 0, static_cast<GLsizeiptr>(size), batches.matrices.data());
+		render_stats::count_buffer_upload(size);
+
+		for (const auto& batch : batches.batches) {
+
+			const world::model& model = world::model_get(batch.asset);
+
+			if (model.is_placeholder()) {
+				for (std::size_t i = 0; i < batch.count; i++) {
+					draw_bounds(use_camera, model.local_bounds(), batches.matrices[batch.first + i], data::placeholder_color);
+				}
+
+				continue;
 			}
 
-			auto size = static_cast<GLsizei>(mesh.index_size());
+			glBindBufferRange(
+				GL_SHADER_STORAGE_BUFFER, 0, data::instance_buffer,
+				static_cast<GLintptr>(batch.first * sizeof(glm::mat4)),
+				static_cast<GLsizeiptr>(batch.count * sizeof(glm::mat4))
+			);
+
+			glUseProgram(batch.shader_id);
+			render_stats::count_program_bind();
+
+			shader::set("projection", batch.shader_id, use_camera.projection(sdl::get_aspect_ratio()));
+			shader::set("view", batch.shader_id, use_camera.view());
+
+			instance_origin origin(model);
+
+			glBindVertexArray(model.meshes().vao());
+			render_stats::count_vao_bind();
+
+			for (const auto& mesh : model) {
+
+				shader::set("origin", batch.shader_id, origin(mesh.node()));
+
+				bind_textures(mesh, batch.shader_id);
+
+				glDrawElementsInstancedBaseVertex(
+					global.draw_mode(),
+					static_cast<GLsizei>(mesh.index_size()),
+					GL_UNSIGNED_INT,
+					(void*)(mesh.index_offset() * sizeof(unsigned int)),
+					static_cast<GLsizei>(batch.count),
+					static_cast<GLint>(mesh.vertex_offset())
+				);
+				render_stats::count_draw(triangles_of(mesh), batch.count);
+			}
 
-			glBindVertexArray(mesh.vao());
-			glDrawElementsInstanced(global.draw_mode(), size, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(instance_amount));
 			glBindVertexArray(0);
 		}
+
+		glActiveTexture(GL_TEXTURE0);
 	}
 }
\ No newline at end of file
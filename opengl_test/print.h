@@ -4,6 +4,8 @@
 #include <string>
 #include <chrono>
 #include <sstream>
+#include <mutex>
+#include <algorithm>
 
 namespace logger {
 	enum log_level {
@@ -25,29 +27,33 @@ namespace logger {
 
 	struct logger_impl {
 
+		// assets are loaded in the background while the main thread runs, so messages can come from any thread
 		template<typename ... Args>
 		void emplace_back(Args&& ... args) {
+			std::lock_guard lock(mutex_);
 			log_messages.emplace_back(std::forward<Args>(args)...);
 		}
 
-		typename std::vector<logger::message>::const_iterator begin() const {
-			return log_messages.begin();
+		// returns the first 'count' messages, or all of them when there are fewer.
+		// readers get copies taken under the lock, a reference into the messages would not survive the next message.
+		std::vector<message> copy(std::size_t count) const {
+			std::lock_guard lock(mutex_);
+			return std::vector<message>(log_messages.begin(), log_messages.begin() + std::min(count, log_messages.size()));
 		}
 
-		typename std::vector<logger::message>::const_iterator end() const {
-			return log_messages.end();
-		}
-
-		const message& at(std::size_t index) const {
+		message at(std::size_t index) const {
+			std::lock_guard lock(mutex_);
 			return log_messages.at(index);
 		}
 
 		std::size_t size() const {
+			std::lock_guard lock(mutex_);
 			return log_messages.size();
 		}
 
 	private:
 		std::vector<message> log_messages;
+		mutable std::mutex mutex_;
 	};
 
 	logger_impl& instance() {
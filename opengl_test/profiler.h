@@ -0,0 +1,517 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <array>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#include "imgui/imgui.h"
+
+// where the CPU time of a frame goes.
+// a zone measures the scope it is placed in, every thread stores its zones in a ring buffer of its own without locking.
+// the window shows the last frames as a timeline of every thread and as a flame graph.
+//
+// PROFILE_ZONE("name") measures until the end of the scope, the name has to outlive the program, like a string literal.
+// define DISABLE_PROFILER to compile the zones out.
+namespace profiler {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	constexpr std::size_t zones_per_thread = 1llu << 14;
+	constexpr std::size_t frame_history = 240llu;
+	constexpr std::size_t counter_history = 1llu << 14;
+
+	// the oldest zones of a ring are not read, the thread can be overwriting them while they are copied
+	constexpr std::size_t zones_read_margin = 1llu << 10;
+
+	struct zone {
+		const char* name = nullptr;
+
+		// nanoseconds of the steady clock
+		std::uint64_t start = 0llu;
+		std::uint64_t end = 0llu;
+
+		// how many zones of the same thread this one is inside of
+		std::uint32_t depth = 0u;
+	};
+
+	// the zones of one thread, only that thread writes them.
+	// 'written' is published after a zone is stored, so the zones before it can be read from other threads.
+	struct thread_buffer {
+		std::string name;
+		std::array<zone, zones_per_thread> zones;
+		std::atomic<std::uint64_t> written = 0llu;
+
+		// a buffer is handed to a new thread once its thread exited
+		std::atomic<bool> in_use = false;
+
+		// only used by the thread that owns the buffer
+		std::uint32_t depth = 0u;
+		const char* open_zone = nullptr;
+	};
+
+	// a value sampled at a point in time, like the frame time
+	struct counter_sample {
+		const char* name = nullptr;
+		std::uint64_t time = 0llu;
+		double value = 0.0;
+	};
+
+	// the zones of one thread within the frames that are shown
+	struct lane {
+		std::string name;
+		std::vector<zone> zones;
+		std::uint32_t depth_count = 0u;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		std::atomic<bool> enabled = true;
+
+		std::mutex buffers_mutex;
+		std::vector<std::unique_ptr<thread_buffer>> buffers;
+
+		// when every frame started, see 'begin_frame'
+		std::array<std::uint64_t, frame_history> frame_starts{};
+		std::uint64_t frame_count = 0llu;
+
+		// only recorded on the main thread, the oldest samples are dropped
+		std::deque<counter_sample> counters;
+
+		// what the window shows, kept while it is paused
+		bool paused = false;
+		int visible_frames = 3;
+		std::uint64_t view_start = 0llu;
+		std::uint64_t view_end = 0llu;
+		std::vector<std::uint64_t> view_frames;
+		std::vector<lane> lanes;
+	}
+	// ============================================================================================================================
+
+	std::uint64_t now() {
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	namespace detail {
+
+		// gives the buffer of a thread back when the thread exits
+		struct buffer_owner {
+			thread_buffer* buffer = nullptr;
+
+			~buffer_owner() {
+				if (buffer != nullptr) {
+					buffer->in_use = false;
+				}
+			}
+		};
+
+		thread_local buffer_owner owner;
+
+		thread_buffer* acquire_buffer() {
+
+			std::lock_guard lock(data::buffers_mutex);
+
+			for (auto& buffer : data::buffers) {
+				bool expected = false;
+				if (buffer->in_use.compare_exchange_strong(expected, true)) {
+					buffer->depth = 0u;
+					buffer->open_zone = nullptr;
+					return buffer.get();
+				}
+			}
+
+			auto& buffer = data::buffers.emplace_back(std::make_unique<thread_buffer>());
+			buffer->name = "thread " + std::to_string(data::buffers.size() - 1llu);
+			buffer->in_use = true;
+
+			return buffer.get();
+		}
+	}
+
+	// the buffer of the calling thread, it gets one the first time
+	thread_buffer& this_thread_buffer() {
+		if (detail::owner.buffer == nullptr) {
+			detail::owner.buffer = detail::acquire_buffer();
+		}
+
+		return *detail::owner.buffer;
+	}
+
+	// names the lane of the calling thread in the timeline
+	void set_thread_name(std::string name) {
+		thread_buffer& buffer = this_thread_buffer();
+
+		std::lock_guard lock(data::buffers_mutex);
+		buffer.name = std::move(name);
+	}
+
+	// records the value of the counter 'name' at this time, call it from the main thread
+	void record_counter(const char* name, double value) {
+		if (!data::enabled.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		if (data::counters.size() == counter_history) {
+			data::counters.pop_front();
+		}
+
+		data::counters.push_back({ name, now(), value });
+	}
+
+	// the time frame 'frame' started, only the last 'frame_history' frames are known
+	std::uint64_t frame_start(std::uint64_t frame) {
+		return data::frame_starts[frame % frame_history];
+	}
+
+	// marks the start of a frame, call it at the top of the main loop
+	void begin_frame() {
+		std::uint64_t start = now();
+
+		if (data::frame_count > 0llu) {
+			record_counter("frame ms", static_cast<double>(start - frame_start(data::frame_count - 1llu)) / 1000000.0);
+		}
+
+		data::frame_starts[data::frame_count % frame_history] = start;
+		data::frame_count++;
+	}
+
+	// the innermost zone the calling thread is in, nullptr outside of every zone
+	const char* current_zone() {
+		return this_thread_buffer().open_zone;
+	}
+
+	// measures the time until it goes out of scope
+	struct scoped_zone {
+
+		explicit scoped_zone(const char* name) {
+			if (!data::enabled.load(std::memory_order_relaxed)) {
+				return;
+			}
+
+			buffer_ = &this_thread_buffer();
+			name_ = name;
+			parent_ = buffer_->open_zone;
+			buffer_->open_zone = name;
+			depth_ = buffer_->depth++;
+			start_ = now();
+		}
+
+		~scoped_zone() {
+			if (buffer_ == nullptr) {
+				return;
+			}
+
+			std::uint64_t end = now();
+			buffer_->depth--;
+			buffer_->open_zone = parent_;
+
+			std::uint64_t index = buffer_->written.load(std::memory_order_relaxed);
+			buffer_->zones[index % zones_per_thread] = { name_, start_, end, depth_ };
+			buffer_->written.store(index + 1llu, std::memory_order_release);
+		}
+
+		scoped_zone(const scoped_zone&) = delete;
+		scoped_zone& operator=(const scoped_zone&) = delete;
+
+	private:
+		thread_buffer* buffer_ = nullptr;
+		const char* name_ = nullptr;
+		const char* parent_ = nullptr;
+		std::uint64_t start_ = 0llu;
+		std::uint32_t depth_ = 0u;
+	};
+
+	// copies the zones of every thread that overlap 'start' to 'end' into 'output', one lane per thread
+	void collect(std::uint64_t start, std::uint64_t end, std::vector<lane>& output) {
+
+		std::lock_guard lock(data::buffers_mutex);
+
+		output.resize(data::buffers.size());
+
+		for (std::size_t i = 0; i < data::buffers.size(); i++) {
+			const thread_buffer& buffer = *data::buffers[i];
+			lane& target = output[i];
+
+			target.name = buffer.name;
+			target.zones.clear();
+			target.depth_count = 0u;
+
+			std::uint64_t written = buffer.written.load(std::memory_order_acquire);
+			std::uint64_t kept = zones_per_thread - zones_read_margin;
+			std::uint64_t first = written > kept ? written - kept : 0llu;
+
+			for (std::uint64_t index = first; index < written; index++) {
+				const zone& recorded = buffer.zones[index % zones_per_thread];
+
+				if (recorded.end >= start && recorded.start < end) {
+					target.zones.push_back(recorded);
+					target.depth_count = std::max(target.depth_count, recorded.depth + 1u);
+				}
+			}
+
+			// parents are stored after their children, the flame graph needs them first
+			std::sort(target.zones.begin(), target.zones.end(), [](const zone& left, const zone& right) {
+				return left.start != right.start ? left.start < right.start : left.depth < right.depth;
+			});
+		}
+	}
+
+	namespace detail {
+
+		double to_ms(std::uint64_t nanoseconds) {
+			return static_cast<double>(nanoseconds) / 1000000.0;
+		}
+
+		// the same name gets the same color in both views
+		ImU32 zone_color(const char* name) {
+			auto hash = std::hash<std::string_view>{}(name);
+			float hue = static_cast<float>(hash % 1000llu) / 1000.f;
+
+			return ImColor::HSV(hue, 0.5f, 0.7f);
+		}
+
+		// draws a named box, with as much of the name as fits into it
+		void draw_zone_box(ImDrawList* draw, ImVec2 min, ImVec2 max, const char* name) {
+			draw->AddRectFilled(min, max, zone_color(name));
+			draw->AddRect(min, max, IM_COL32(0, 0, 0, 128));
+
+			if (max.x - min.x > 8.f) {
+				draw->PushClipRect(min, max, true);
+				draw->AddText(ImVec2(min.x + 2.f, min.y), IM_COL32_WHITE, name);
+				draw->PopClipRect();
+			}
+		}
+
+		void show_timeline() {
+
+			ImDrawList* draw = ImGui::GetWindowDrawList();
+
+			float width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+			float row = ImGui::GetTextLineHeightWithSpacing();
+			double scale = width / static_cast<double>(data::view_end - data::view_start);
+
+			for (std::size_t i = 0; i < data::lanes.size(); i++) {
+				const lane& shown = data::lanes[i];
+
+				if (shown.zones.empty()) {
+					continue;
+				}
+
+				ImGui::Text("%s", shown.name.c_str());
+
+				ImVec2 origin = ImGui::GetCursorScreenPos();
+				float height = row * static_cast<float>(shown.depth_count);
+
+				ImGui::PushID(static_cast<int>(i));
+				ImGui::InvisibleButton("lane", ImVec2(width, height));
+				ImGui::PopID();
+
+				for (std::uint64_t boundary : data::view_frames) {
+					float x = origin.x + static_cast<float>((boundary - data::view_start) * scale);
+					draw->AddLine(ImVec2(x, origin.y), ImVec2(x, origin.y + height), IM_COL32(255, 255, 255, 64));
+				}
+
+				for (const zone& shown_zone : shown.zones) {
+					std::uint64_t start = std::max(shown_zone.start, data::view_start);
+					std::uint64_t end = std::min(shown_zone.end, data::view_end);
+
+					float x0 = origin.x + static_cast<float>((start - data::view_start) * scale);
+					float x1 = std::max(origin.x + static_cast<float>((end - data::view_start) * scale), x0 + 1.f);
+					float y0 = origin.y + row * static_cast<float>(shown_zone.depth);
+
+					ImVec2 min(x0, y0);
+					ImVec2 max(x1, y0 + row - 1.f);
+
+					draw_zone_box(draw, min, max, shown_zone.name);
+
+					if (ImGui::IsMouseHoveringRect(min, max)) {
+						ImGui::SetTooltip("%s\n%.3f ms", shown_zone.name, to_ms(shown_zone.end - shown_zone.start));
+					}
+				}
+			}
+		}
+
+		struct flame_node {
+			const char* name = nullptr;
+			std::uint64_t total = 0llu;
+			std::uint32_t calls = 0u;
+			std::vector<std::size_t> children;
+		};
+
+		// merges the zones of a lane with the same path of names, the time is clipped to the frames that are shown
+		void build_flame(const lane& shown, std::vector<flame_node>& nodes) {
+
+			nodes.clear();
+			nodes.emplace_back();
+
+			// the node of every depth on the path of the last zone
+			std::vector<std::size_t> path;
+
+			for (const zone& shown_zone : shown.zones) {
+				std::size_t parent = 0llu;
+				if (shown_zone.depth > 0u && !path.empty()) {
+					parent = path[std::min<std::size_t>(shown_zone.depth, path.size()) - 1llu];
+				}
+
+				std::size_t found = nodes.size();
+				for (std::size_t child : nodes[parent].children) {
+					if (std::strcmp(nodes[child].name, shown_zone.name) == 0) {
+						found = child;
+						break;
+					}
+				}
+
+				if (found == nodes.size()) {
+					nodes[parent].children.push_back(found);
+					nodes.emplace_back().name = shown_zone.name;
+				}
+
+				std::uint64_t start = std::max(shown_zone.start, data::view_start);
+				std::uint64_t end = std::min(shown_zone.end, data::view_end);
+
+				nodes[found].total += end > start ? end - start : 0llu;
+				nodes[found].calls++;
+
+				path.resize(std::min<std::size_t>(shown_zone.depth, path.size()));
+				path.push_back(found);
+			}
+
+			for (auto& node : nodes) {
+				std::sort(node.children.begin(), node.children.end(), [&](std::size_t left, std::size_t right) {
+					return nodes[left].total > nodes[right].total;
+				});
+			}
+		}
+
+		void draw_flame_node(ImDrawList* draw, const std::vector<flame_node>& nodes, std::size_t index, float x, float y, double scale, float row, std::size_t frames) {
+
+			for (std::size_t child : nodes[index].children) {
+				const flame_node& node = nodes[child];
+				float width = static_cast<float>(node.total * scale);
+
+				ImVec2 min(x, y);
+				ImVec2 max(x + std::max(width, 1.f), y + row - 1.f);
+
+				draw_zone_box(draw, min, max, node.name);
+
+				if (ImGui::IsMouseHoveringRect(min, max)) {
+					ImGui::SetTooltip("%s\n%.3f ms total\n%.3f ms per frame\n%u calls",
+						node.name, to_ms(node.total), to_ms(node.total) / static_cast<double>(frames), node.calls);
+				}
+
+				draw_flame_node(draw, nodes, child, x, y + row, scale, row, frames);
+				x += width;
+			}
+		}
+
+		void show_flame() {
+
+			ImDrawList* draw = ImGui::GetWindowDrawList();
+
+			float width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+			float row = ImGui::GetTextLineHeightWithSpacing();
+			double scale = width / static_cast<double>(data::view_end - data::view_start);
+			std::size_t frames = std::max<std::size_t>(data::view_frames.size(), 1llu);
+
+			std::vector<flame_node> nodes;
+
+			for (std::size_t i = 0; i < data::lanes.size(); i++) {
+				const lane& shown = data::lanes[i];
+
+				if (shown.zones.empty()) {
+					continue;
+				}
+
+				build_flame(shown, nodes);
+
+				ImGui::Text("%s", shown.name.c_str());
+
+				ImVec2 origin = ImGui::GetCursorScreenPos();
+
+				ImGui::PushID(static_cast<int>(i));
+				ImGui::InvisibleButton("flame", ImVec2(width, row * static_cast<float>(shown.depth_count)));
+				ImGui::PopID();
+
+				draw_flame_node(draw, nodes, 0llu, origin.x, origin.y, scale, row, frames);
+			}
+		}
+	}
+
+	// shows the last frames of every thread, the frames are chosen again every frame until the window is paused
+	void show_window(bool& show) {
+
+		if (!show) {
+			return;
+		}
+
+		ImGui::Begin("Profiler", &show);
+
+		std::size_t complete_frames = data::frame_count > 0llu ? std::min<std::size_t>(data::frame_count - 1llu, frame_history - 1llu) : 0llu;
+
+		if (complete_frames == 0llu) {
+			ImGui::Text("no frames yet");
+			ImGui::End();
+			return;
+		}
+
+		std::uint64_t last = data::frame_count - 1llu;
+
+		std::vector<float> frame_ms(complete_frames);
+		for (std::size_t i = 0; i < complete_frames; i++) {
+			std::uint64_t frame = last - complete_frames + i;
+			frame_ms[i] = static_cast<float>(detail::to_ms(frame_start(frame + 1llu) - frame_start(frame)));
+		}
+
+		ImGui::PlotHistogram("##frames", frame_ms.data(), static_cast<int>(frame_ms.size()), 0, "frame time", 0.f, 33.3f, ImVec2(0.f, 60.f));
+
+		ImGui::Checkbox("pause", &data::paused);
+		ImGui::SameLine();
+		ImGui::SliderInt("frames", &data::visible_frames, 1, 30);
+
+		if (!data::paused || data::view_end == 0llu) {
+			std::size_t visible = std::min<std::size_t>(static_cast<std::size_t>(std::max(data::visible_frames, 1)), complete_frames);
+
+			data::view_frames.clear();
+			for (std::uint64_t frame = last - visible; frame < last; frame++) {
+				data::view_frames.push_back(frame_start(frame));
+			}
+
+			data::view_start = frame_start(last - visible);
+			data::view_end = frame_start(last);
+
+			collect(data::view_start, data::view_end, data::lanes);
+		}
+
+		ImGui::Text("%zu frames, %.3f ms", data::view_frames.size(), detail::to_ms(data::view_end - data::view_start));
+
+		if (ImGui::CollapsingHeader("timeline", ImGuiTreeNodeFlags_DefaultOpen)) {
+			detail::show_timeline();
+		}
+
+		if (ImGui::CollapsingHeader("flame graph", ImGuiTreeNodeFlags_DefaultOpen)) {
+			detail::show_flame();
+		}
+
+		ImGui::End();
+	}
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef DISABLE_PROFILER
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE(name) profiler::scoped_zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#endif
+
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
\ No newline at end of file
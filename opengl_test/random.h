@@ -43,6 +43,12 @@ namespace random {
 	template<typename RandomEngine>
 	struct random_impl {
 
+		random_impl() = default;
+
+		// the same seed gives the same numbers every run, for what has to be repeatable
+		explicit random_impl(typename RandomEngine::result_type seed)
+			: generator{ seed } { }
+
 		template<typename T, 
 			typename std::enable_if_t<traits::is_valid_integeral<T>::value, int> = 0>
 		T next(const T& min, const T& max) {
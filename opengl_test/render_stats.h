@@ -0,0 +1,167 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+#include "imgui/imgui.h"
+#include "profiler.h"
+
+// what the renderer asked of OpenGL every frame: draws, the geometry they submitted, state changes and uploads.
+// the count functions are called next to the GL calls they count, only from the thread with the GL context.
+// the draws of the ImGui renderer are not counted.
+namespace render_stats {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	constexpr std::size_t frame_history = 240llu;
+
+	struct counters {
+		std::uint64_t draw_calls = 0llu;
+		std::uint64_t instances = 0llu;
+		std::uint64_t triangles = 0llu;
+		std::uint64_t program_binds = 0llu;
+		std::uint64_t vao_binds = 0llu;
+		std::uint64_t texture_binds = 0llu;
+		std::uint64_t uniform_sets = 0llu;
+		std::uint64_t buffer_bytes = 0llu;
+		std::uint64_t texture_bytes = 0llu;
+	};
+
+	// the name of every counter and where it is, for the panel and the profiler counters
+	struct counter_info {
+		const char* name;
+		std::uint64_t counters::* value;
+	};
+
+	constexpr std::array<counter_info, 9> counter_infos{ {
+		{ "draw calls", &counters::draw_calls },
+		{ "instances", &counters::instances },
+		{ "triangles", &counters::triangles },
+		{ "program binds", &counters::program_binds },
+		{ "vao binds", &counters::vao_binds },
+		{ "texture binds", &counters::texture_binds },
+		{ "uniform sets", &counters::uniform_sets },
+		{ "buffer bytes", &counters::buffer_bytes },
+		{ "texture bytes", &counters::texture_bytes }
+	} };
+
+	// ============================================================================================================================
+	namespace data {
+		// the frame that is being drawn
+		counters current;
+
+		// the frames that are done, see 'end_frame'
+		std::array<counters, frame_history> history{};
+		std::uint64_t frame_count = 0llu;
+	}
+	// ============================================================================================================================
+
+	// 'triangles' is the amount of one instance
+	void count_draw(std::uint64_t triangles, std::uint64_t instances = 1llu) {
+		data::current.draw_calls++;
+		data::current.instances += instances;
+		data::current.triangles += triangles * instances;
+	}
+
+	void count_program_bind() {
+		data::current.program_binds++;
+	}
+
+	void count_vao_bind() {
+		data::current.vao_binds++;
+	}
+
+	void count_texture_bind() {
+		data::current.texture_binds++;
+	}
+
+	void count_uniform_set() {
+		data::current.uniform_sets++;
+	}
+
+	void count_buffer_upload(std::uint64_t bytes) {
+		data::current.buffer_bytes += bytes;
+	}
+
+	void count_texture_upload(std::uint64_t bytes) {
+		data::current.texture_bytes += bytes;
+	}
+
+	// the counters of the last frame that is done, all zero before the first
+	const counters& last_frame() {
+		static const counters none{};
+		return data::frame_count > 0llu ? data::history[(data::frame_count - 1llu) % frame_history] : none;
+	}
+
+	// finishes the counters of a frame and starts the next, call it once per frame after the last draw.
+	// the counters are also recorded as profiler counters, so they are part of trace captures.
+	void end_frame() {
+
+		data::history[data::frame_count % frame_history] = data::current;
+		data::frame_count++;
+
+		for (const auto& info : counter_infos) {
+			profiler::record_counter(info.name, static_cast<double>(data::current.*info.value));
+		}
+
+		data::current = {};
+	}
+
+	// shows the counters of the last frame, the average and the maximum of the history, and a graph of the history
+	void show_window(bool& show) {
+
+		if (!show) {
+			return;
+		}
+
+		ImGui::Begin("Render stats", &show);
+
+		std::size_t frames = static_cast<std::size_t>(std::min<std::uint64_t>(data::frame_count, frame_history));
+
+		if (frames == 0llu) {
+			ImGui::Text("no frames yet");
+			ImGui::End();
+			return;
+		}
+
+		std::array<float, frame_history> graph{};
+
+		ImGui::Columns(4);
+		ImGui::Text("counter"); ImGui::NextColumn();
+		ImGui::Text("last frame"); ImGui::NextColumn();
+		ImGui::Text("average"); ImGui::NextColumn();
+		ImGui::Text("max"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (const auto& info : counter_infos) {
+
+			std::uint64_t total = 0llu;
+			std::uint64_t most = 0llu;
+
+			// oldest first
+			for (std::size_t i = 0; i < frames; i++) {
+				std::uint64_t frame = data::frame_count - frames + i;
+				std::uint64_t value = data::history[frame % frame_history].*info.value;
+
+				graph[i] = static_cast<float>(value);
+				total += value;
+				most = std::max(most, value);
+			}
+
+			ImGui::Text("%s", info.name); ImGui::NextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(last_frame().*info.value)); ImGui::NextColumn();
+			ImGui::Text("%.1f", static_cast<double>(total) / static_cast<double>(frames)); ImGui::NextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(most)); ImGui::NextColumn();
+
+			ImGui::Columns(1);
+			ImGui::PushID(info.name);
+			ImGui::PlotLines("##history", graph.data(), static_cast<int>(frames), 0, nullptr, 0.f, static_cast<float>(most) * 1.1f + 1.f, ImVec2(ImGui::GetContentRegionAvail().x, 40.f));
+			ImGui::PopID();
+			ImGui::Columns(4);
+		}
+
+		ImGui::Columns(1);
+		ImGui::End();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+#include <execution>
+
+namespace world {
+
+	// ============================================================================================================================
+
+	// a transform hierarchy stored in topological order.
+	// nodes are stored depth first: the subtree of node 'i' is the range [i, i + subtree_size(i)).
+	// that means every parent comes before its children and every root owns a contiguous range,
+	// so the subtrees of different roots can be updated on different threads.
+	struct scene_graph {
+
+		using node_id = std::size_t;
+
+		static constexpr node_id no_parent = std::numeric_limits<node_id>::max();
+
+		// the minimum amount of dirty roots before 'update' spreads the work over multiple threads
+		static constexpr std::size_t parallel_threshold = 8llu;
+
+		// adds a node below 'parent', or a new root when 'parent' is 'no_parent'.
+		// children have to be added directly after the subtree of their parent, which is what a depth first import does.
+		node_id add_node(node_id parent, const glm::mat4& local = glm::mat4(1.f)) {
+
+			node_id id = parents_.size();
+
+			if (parent != no_parent) {
+				assert(parent < id);
+				assert(parent + subtree_sizes_[parent] == id && "a subtree has to be added in one go");
+
+				// grow the subtree of every ancestor
+				for (node_id ancestor = parent; ancestor != no_parent; ancestor = parents_[ancestor]) {
+					subtree_sizes_[ancestor]++;
+				}
+			}
+
+			parents_.push_back(parent);
+			roots_.push_back(parent == no_parent ? id : roots_[parent]);
+			subtree_sizes_.push_back(1llu);
+			locals_.push_back(local);
+			worlds_.push_back(parent == no_parent ? local : worlds_[parent] * local);
+			dirty_.push_back(0u);
+			dirty_below_.push_back(0u);
+
+			return id;
+		}
+
+		std::size_t size() const {
+			return parents_.size();
+		}
+
+		node_id parent(node_id id) const {
+			return parents_[id];
+		}
+
+		node_id root(node_id id) const {
+			return roots_[id];
+		}
+
+		std::size_t subtree_size(node_id id) const {
+			return subtree_sizes_[id];
+		}
+
+		const glm::mat4& local(node_id id) const {
+			return locals_[id];
+		}
+
+		// returns the cached world matrix of a node.
+		// be sure to call 'update' after changing local matrices.
+		const glm::mat4& world(node_id id) const {
+			return worlds_[id];
+		}
+
+		// changes the local matrix of a node and marks it, and thereby its subtree, for an update
+		void set_local(node_id id, const glm::mat4& local) {
+			locals_[id] = local;
+
+			if (dirty_[id] == 0u) {
+
+				// a root that already has dirty nodes is already queued for the next update
+				node_id root_id = roots_[id];
+				bool root_queued = dirty_[root_id] != 0u || dirty_below_[root_id] != 0u;
+
+				dirty_[id] = 1u;
+
+				// let the ancestors know there's work to do below them
+				for (node_id ancestor = parents_[id]; ancestor != no_parent && dirty_below_[ancestor] == 0u; ancestor = parents_[ancestor]) {
+					dirty_below_[ancestor] = 1u;
+				}
+
+				if (!root_queued) {
+					dirty_roots_.push_back(root_id);
+				}
+			}
+		}
+
+		// recalculates the world matrices of every dirty node and their children.
+		// clean subtrees are skipped, the subtrees of different roots are updated in parallel.
+		void update() {
+
+			if (dirty_roots_.empty()) {
+				return;
+			}
+
+			auto update_root = [this](node_id root_id) {
+				update_range(root_id, root_id + subtree_sizes_[root_id]);
+			};
+
+			if (dirty_roots_.size() >= parallel_threshold) {
+				std::for_each(std::execution::par, dirty_roots_.begin(), dirty_roots_.end(), update_root);
+			}
+			else {
+				std::for_each(dirty_roots_.begin(), dirty_roots_.end(), update_root);
+			}
+
+			dirty_roots_.clear();
+		}
+
+	private:
+
+		void update_range(node_id first, node_id last) {
+
+			// 'updated' holds the nodes of which the world matrix changed in this pass.
+			// it is indexed relative to 'first', every thread works on its own copy.
+			thread_local std::vector<std::uint8_t> updated;
+			updated.assign(last - first, 0u);
+
+			node_id i = first;
+			while (i < last) {
+
+				node_id parent = parents_[i];
+				bool parent_updated = parent != no_parent && parent >= first && updated[parent - first] != 0u;
+
+				if (dirty_[i] == 0u && dirty_below_[i] == 0u && !parent_updated) {
+					// nothing changed in this subtree
+					i += subtree_sizes_[i];
+					continue;
+				}
+
+				if (dirty_[i] != 0u || parent_updated) {
+					worlds_[i] = parent == no_parent ? locals_[i] : worlds_[parent] * locals_[i];
+					updated[i - first] = 1u;
+				}
+
+				dirty_[i] = 0u;
+				dirty_below_[i] = 0u;
+				i++;
+			}
+		}
+
+		std::vector<node_id> parents_;
+		std::vector<node_id> roots_;
+		std::vector<std::size_t> subtree_sizes_;
+
+		std::vector<glm::mat4> locals_;
+		std::vector<glm::mat4> worlds_;
+
+		std::vector<std::uint8_t> dirty_;
+		std::vector<std::uint8_t> dirty_below_;
+
+		std::vector<node_id> dirty_roots_;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// the transform hierarchy of all models
+		scene_graph scene;
+	}
+	// ============================================================================================================================
+}
\ No newline at end of file
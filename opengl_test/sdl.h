@@ -1,4 +1,5 @@
 #pragma once
+#include "headless.h"
 #include <SDL.h>
 #include "print.h"
 
@@ -48,8 +49,12 @@ namespace sdl {
 		SDL_SetWindowTitle(window_ptr, title.c_str());
 	}
 
-	bool set_capture_mouse(bool enable = true) {
+	bool set_capture_mouse([[maybe_unused]] bool enable = true) {
 
+#ifdef HEADLESS
+		// there is no mouse to capture
+		return true;
+#else
 		SDL_bool set = SDL_TRUE;
 
 		if (!enable) {
@@ -63,6 +68,7 @@ namespace sdl {
 		}
 
 		return true;
+#endif
 	}
 
 	// ============================================================================================================================
@@ -100,6 +106,10 @@ namespace sdl {
 
 	void destroy_window() {
 
+#ifdef HEADLESS
+		headless::destroy();
+#endif
+
 		// clean up SDL before closing the application
 		// we check gl_context and window_ptr for nullptr to prevent errors
 
@@ -115,6 +125,43 @@ namespace sdl {
 		SDL_Quit();
 	}
 
+#ifdef HEADLESS
+
+	// creates the context without a window, SDL only runs the events and the keyboard state
+	bool create_window(const char *, int, int, int width, int height, bool) {
+
+		if (SDL_Init(SDL_INIT_EVENTS) < 0) {
+			print_sdl_error("SDL init failed");
+			return false;
+		}
+
+		data::window_width = width;
+		data::window_height = height;
+
+		return headless::create_context(width, height);
+	}
+
+	// the GL functions are loaded from the headless context
+	void* get_proc_address(const char* name) {
+		return headless::get_proc_address(name);
+	}
+
+	// ends the frame, the frames go into the framebuffer object of the headless context
+	void swap_window() {
+		headless::present();
+	}
+
+	float get_aspect_ratio() {
+		return static_cast<float>(data::window_width) / static_cast<float>(data::window_height);
+	}
+
+	// there is no display to wait for, the frames are only throttled by 'headless::present'
+	bool set_vsync(bool) {
+		return true;
+	}
+
+#else
+
 	bool create_window(const char * title, int x, int y, int width, int height, bool full_screen) {
 		// initialize SDL
 		if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -178,4 +225,23 @@ namespace sdl {
 		return 1.0;
 	}
 
+	void* get_proc_address(const char* name) {
+		return SDL_GL_GetProcAddress(name);
+	}
+
+	void swap_window() {
+		SDL_GL_SwapWindow(window_ptr);
+	}
+
+	// 'enable' waits for the screen refresh on every swap, otherwise the frames are swapped immediately
+	bool set_vsync(bool enable) {
+		if (SDL_GL_SetSwapInterval(enable ? 1 : 0) < 0) {
+			print_sdl_error("Failed to set vsync");
+			return false;
+		}
+
+		return true;
+	}
+
+#endif
 }
\ No newline at end of file
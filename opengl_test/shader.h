@@ -3,6 +3,8 @@
 #include <type_traits>
 #include <optional>
 #include "print.h"
+#include "slot_map.h"
+#include "render_stats.h"
 namespace shader {
 
 
@@ -74,7 +76,7 @@ namespace shader {
 			layout (location = 1) in vec3 aNormal;
 			layout (location = 2) in vec3 aColor;
 
-			//uniform mat4 origin;
+			uniform mat4 origin;
 			uniform mat4 projection;
 			uniform mat4 view;
 
@@ -88,9 +90,11 @@ namespace shader {
 
 			void main()
 			{
-				pos = vec3(model[gl_InstanceID] * vec4(aPos, 1.0));
+				mat4 instance_model = model[gl_InstanceID] * origin;
+
+				pos = vec3(instance_model * vec4(aPos, 1.0));
 				ourColor = aColor;
-				normal = mat3(transpose(inverse(model[gl_InstanceID]))) * aNormal;
+				normal = mat3(transpose(inverse(instance_model))) * aNormal;
 
 				gl_Position = projection * view * vec4(pos, 1.0);
 			})";
@@ -108,6 +112,34 @@ namespace shader {
 				diffuseColor = vec4(ourColor, 1);
 			})";
 
+	// draws the edges of a unit box stretched over a bounding box, used in place of models that are still loading
+	constexpr const char * bounds_vert =
+		R"(#version 450 core
+			layout(location = 0) in vec3 aPos;
+
+			uniform mat4 projection;
+			uniform mat4 view;
+			uniform mat4 model;
+			uniform vec3 box_min;
+			uniform vec3 box_max;
+
+			void main()
+			{
+				vec3 pos = mix(box_min, box_max, aPos);
+				gl_Position = projection * view * model * vec4(pos, 1.0);
+			})";
+
+	constexpr const char * bounds_frag =
+		R"(#version 450 core
+			layout(location = 0) out vec4 diffuseColor;
+
+			uniform vec4 color;
+
+			void main()
+			{
+				diffuseColor = color;
+			})";
+
 
 	bool is_program(unsigned int program_id) {
 		return glIsProgram(program_id) == GL_TRUE;
@@ -191,6 +223,50 @@ namespace shader {
 		return true;
 	}
 
+	struct program_info {
+		unsigned int id = 0u;
+	};
+
+	using program_handle = containers::handle<program_info>;
+
+	namespace data {
+		// every program that has been loaded through a 'program_handle'
+		containers::slot_map<program_info> programs;
+	}
+
+	// loads a program and returns a handle to it
+	bool load_shader(program_handle& handle, const char * vertex_shader, const char * fragment_shader) {
+
+		unsigned int program_id = 0u;
+		if (!load_shader(program_id, vertex_shader, fragment_shader)) {
+			return false;
+		}
+
+		handle = data::programs.emplace(program_info{ program_id });
+		return true;
+	}
+
+	// returns the program 'handle' refers to, or nullptr when it has been unloaded
+	const program_info* program_get(program_handle handle) {
+		return data::programs.get(handle);
+	}
+
+	// deletes the program 'handle' refers to, every handle to it becomes invalid
+	bool unload_shader(program_handle handle) {
+
+		const program_info* info_ptr = data::programs.get(handle);
+
+		if (info_ptr == nullptr) {
+			print_error("UNKNOWN PROGRAM handle:", handle.index);
+			return false;
+		}
+
+		glDeleteProgram(info_ptr->id);
+		data::programs.erase(handle);
+
+		return true;
+	}
+
 	std::optional<unsigned int> load_shader(const char * vertex_shader, const char * fragment_shader) {
 
 		unsigned int output = 0;
@@ -226,6 +302,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniform1f(*location, value);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -234,6 +311,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniform1i(*location, value);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -242,6 +320,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniform1i(location, value);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -250,6 +329,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniform1ui(*location, value);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -258,6 +338,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniform2fv(*location, 1, &value[0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -265,7 +346,8 @@ namespace shader {
 	template<typename TValue, ENABLE_IF_SAME(TValue, glm::vec3)>
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
-			glUniform3fv(*location, 1, &value);
+			glUniform3fv(*location, 1, &value[0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -273,7 +355,8 @@ namespace shader {
 	template<typename TValue, ENABLE_IF_SAME(TValue, glm::vec4)>
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
-			glUniform4fv(*location, 1, &value);
+			glUniform4fv(*location, 1, &value[0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -282,6 +365,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix2fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -290,6 +374,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix2x3fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -298,6 +383,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix2x4fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -306,6 +392,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix3fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -314,6 +401,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix3x2fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -322,6 +410,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix3x4fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -330,6 +419,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix4fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -338,6 +428,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix4x2fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 
@@ -346,6 +437,7 @@ namespace shader {
 	void set(const char* name, unsigned int id, const TValue& value) {
 		if (auto location = get_location(name, id)) {
 			glUniformMatrix4x3fv(*location, 1, GL_FALSE, &value[0][0]);
+			render_stats::count_uniform_set();
 		}
 	}
 }
\ No newline at end of file
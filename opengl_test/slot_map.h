@@ -0,0 +1,207 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace containers {
+
+	// ============================================================================================================================
+
+	// refers to an object in a 'slot_map<T>'.
+	// the generation is bumped every time a slot is freed, so a handle to a removed object never finds its successor.
+	template<typename T>
+	struct handle {
+		std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+		std::uint32_t generation = 0u;
+
+		bool is_null() const {
+			return index == std::numeric_limits<std::uint32_t>::max();
+		}
+
+		bool operator==(const handle& rhs) const {
+			return index == rhs.index && generation == rhs.generation;
+		}
+
+		bool operator!=(const handle& rhs) const {
+			return index != rhs.index || generation != rhs.generation;
+		}
+
+		bool operator<(const handle& rhs) const {
+			return index < rhs.index || (index == rhs.index && generation < rhs.generation);
+		}
+	};
+
+	// ============================================================================================================================
+
+	// stores objects in fixed size pages and hands out generational handles to them.
+	// - objects never move: adding more objects adds pages instead of reallocating, so references stay valid
+	// - lookups are O(1): the handle index selects the page and the slot, the generation validates it
+	// - freed slots are reused through a free list, objects of a page sit next to each other in memory
+	// the objects are not one packed array. packing them would move an object whenever the array grows or a hole is
+	// closed, and models and textures are held by reference while more are loaded. iteration goes page by page instead,
+	// skipping the freed slots.
+	template<typename T, std::size_t PageSize = 256llu>
+	struct slot_map {
+
+		using handle_type = handle<T>;
+
+		static_assert(PageSize > 0llu, "a page has to hold at least one object");
+
+		slot_map() = default;
+		slot_map(const slot_map&) = delete;
+		slot_map& operator=(const slot_map&) = delete;
+
+		~slot_map() {
+			clear();
+		}
+
+		// constructs a new object in a free slot and returns its handle
+		template<typename ... Args>
+		handle_type emplace(Args&& ... args) {
+
+			std::uint32_t index;
+
+			if (free_head_ != no_slot) {
+				index = free_head_;
+				free_head_ = slots_[index].next_free;
+			}
+			else {
+				index = static_cast<std::uint32_t>(slots_.size());
+				assert(index != no_slot);
+
+				slots_.emplace_back();
+
+				if (index % PageSize == 0llu) {
+					pages_.emplace_back(new storage[PageSize]);
+				}
+			}
+
+			new (address(index)) T(std::forward<Args>(args)...);
+
+			slot& s = slots_[index];
+			s.alive = true;
+			s.next_free = no_slot;
+			size_++;
+
+			return handle_type{ index, s.generation };
+		}
+
+		// destroys the object 'h' refers to. returns false if 'h' was not valid.
+		bool erase(handle_type h) {
+
+			if (!valid(h)) {
+				return false;
+			}
+
+			address(h.index)->~T();
+
+			slot& s = slots_[h.index];
+			s.alive = false;
+			s.generation++;
+			s.next_free = free_head_;
+			free_head_ = h.index;
+			size_--;
+
+			return true;
+		}
+
+		void clear() {
+			for (std::uint32_t i = 0; i < slots_.size(); i++) {
+				if (slots_[i].alive) {
+					erase(handle_type{ i, slots_[i].generation });
+				}
+			}
+		}
+
+		// returns true when 'h' still refers to a live object
+		bool valid(handle_type h) const {
+			return h.index < slots_.size()
+				&& slots_[h.index].alive
+				&& slots_[h.index].generation == h.generation;
+		}
+
+		// returns the object 'h' refers to, or nullptr when it has been removed
+		T* get(handle_type h) {
+			return valid(h) ? address(h.index) : nullptr;
+		}
+
+		const T* get(handle_type h) const {
+			return valid(h) ? address(h.index) : nullptr;
+		}
+
+		// returns the object 'h' refers to, throws std::out_of_range when 'h' is stale or invalid, like 'std::vector::at'
+		T& at(handle_type h) {
+			if (!valid(h)) {
+				throw std::out_of_range("slot_map::at stale or invalid handle");
+			}
+
+			return *address(h.index);
+		}
+
+		const T& at(handle_type h) const {
+			if (!valid(h)) {
+				throw std::out_of_range("slot_map::at stale or invalid handle");
+			}
+
+			return *address(h.index);
+		}
+
+		std::size_t size() const {
+			return size_;
+		}
+
+		bool empty() const {
+			return size_ == 0llu;
+		}
+
+		// calls 'func(handle, object)' for every live object, in slot order
+		template<typename Callable>
+		void for_each(Callable func) {
+			for (std::uint32_t i = 0; i < slots_.size(); i++) {
+				if (slots_[i].alive) {
+					func(handle_type{ i, slots_[i].generation }, *address(i));
+				}
+			}
+		}
+
+		template<typename Callable>
+		void for_each(Callable func) const {
+			for (std::uint32_t i = 0; i < slots_.size(); i++) {
+				if (slots_[i].alive) {
+					func(handle_type{ i, slots_[i].generation }, *address(i));
+				}
+			}
+		}
+
+	private:
+		static constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+
+		using storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+		struct slot {
+			std::uint32_t generation = 0u;
+			std::uint32_t next_free = no_slot;
+			bool alive = false;
+		};
+
+		T* address(std::uint32_t index) {
+			return std::launder(reinterpret_cast<T*>(&pages_[index / PageSize][index % PageSize]));
+		}
+
+		const T* address(std::uint32_t index) const {
+			return std::launder(reinterpret_cast<const T*>(&pages_[index / PageSize][index % PageSize]));
+		}
+
+		std::vector<std::unique_ptr<storage[]>> pages_;
+		std::vector<slot> slots_;
+
+		std::uint32_t free_head_ = no_slot;
+		std::size_t size_ = 0llu;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,852 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+
+#include "print.h"
+#include "mapped_file.h"
+#include "vfs.h"
+#include "image.h"
+#include "shader.h"
+#include "world.h"
+#include "profiler.h"
+#include "instances.h"
+
+// a binary snapshot of the loaded world, so a restart can restore it instead of loading it again.
+// layout: a header, the sections one after the other and a table naming them. every section starts at a multiple of
+// 'section_alignment' bytes and the file is mapped to read it, so restoring is one read and a copy of every array.
+namespace snapshot {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	constexpr char snapshot_magic[4] = { 'W', 'S', 'N', 'P' };
+	constexpr std::uint32_t snapshot_version = 2u;
+	constexpr std::size_t section_alignment = 64llu;
+
+	struct snapshot_header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t section_count;
+
+		// a snapshot of another vertex layout can not be restored
+		std::uint32_t vertex_size;
+
+		std::uint64_t table_offset;
+	};
+
+	struct section_entry {
+		char name[32];
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	static_assert(sizeof(snapshot_header) == 24llu && sizeof(section_entry) == 48llu, "the snapshot layout must not depend on the compiler");
+
+	namespace detail {
+
+		void write_bytes(std::vector<char>& output, const void* bytes, std::size_t size) {
+			output.insert(output.end(), static_cast<const char*>(bytes), static_cast<const char*>(bytes) + size);
+		}
+
+		template<typename T>
+		void write_value(std::vector<char>& output, const T& value) {
+			write_bytes(output, &value, sizeof(T));
+		}
+
+		// strings and arrays are stored as their size in bytes followed by their bytes
+		void write_block(std::vector<char>& output, const void* bytes, std::size_t size) {
+			write_value(output, static_cast<std::uint64_t>(size));
+			write_bytes(output, bytes, size);
+		}
+
+		void write_block(std::vector<char>& output, std::string_view block) {
+			write_block(output, block.data(), block.size());
+		}
+
+		// the readers take the front off 'input', they return false when it is too short
+		template<typename T>
+		bool read_value(std::string_view& input, T& output) {
+			if (input.size() < sizeof(T)) {
+				return false;
+			}
+
+			std::memcpy(&output, input.data(), sizeof(T));
+			input.remove_prefix(sizeof(T));
+			return true;
+		}
+
+		bool read_block(std::string_view& input, std::string_view& output) {
+			std::uint64_t size;
+			if (!read_value(input, size) || input.size() < size) {
+				return false;
+			}
+
+			output = input.substr(0, static_cast<std::size_t>(size));
+			input.remove_prefix(static_cast<std::size_t>(size));
+			return true;
+		}
+
+		// returns the index of the program with the id 'shader_id' in 'shader::data::programs', so it can be found again after
+		// a restart that loaded the same programs in the same order. returns -1 when it was not loaded through a handle.
+		std::int64_t program_index(unsigned int shader_id) {
+			std::int64_t output = -1;
+
+			shader::data::programs.for_each([&](shader::program_handle handle, const shader::program_info& info) {
+				if (info.id == shader_id && shader_id != 0u) {
+					output = handle.index;
+				}
+			});
+
+			return output;
+		}
+
+		// the inverse of 'program_index', returns 0 when there is no such program
+		unsigned int program_id(std::int64_t index) {
+			unsigned int output = 0u;
+
+			shader::data::programs.for_each([&](shader::program_handle handle, const shader::program_info& info) {
+				if (static_cast<std::int64_t>(handle.index) == index) {
+					output = info.id;
+				}
+			});
+
+			return output;
+		}
+
+		// returns the time 'path' was last written as a number, or 0 when it is not a file on disk, like a file in a pack
+		std::int64_t write_time(std::string_view path) {
+			std::error_code error;
+			auto time = std::filesystem::last_write_time(std::filesystem::path(path), error);
+			return error ? 0 : static_cast<std::int64_t>(time.time_since_epoch().count());
+		}
+	}
+
+	// ============================================================================================================================
+
+	// collects the sections of a snapshot and writes them in one go
+	struct writer {
+
+		void add(std::string_view name, const void* bytes, std::size_t size) {
+			assert(name.size() < sizeof(section_entry::name));
+
+			names_.emplace_back(name);
+			blobs_.emplace_back(static_cast<const char*>(bytes), static_cast<const char*>(bytes) + size);
+		}
+
+		void add(std::string_view name, std::vector<char>&& bytes) {
+			assert(name.size() < sizeof(section_entry::name));
+
+			names_.emplace_back(name);
+			blobs_.push_back(std::move(bytes));
+		}
+
+		template<typename T>
+		void add_vector(std::string_view name, const std::vector<T>& values) {
+			add(name, values.data(), values.size() * sizeof(T));
+		}
+
+		template<typename T>
+		void add_value(std::string_view name, const T& value) {
+			add(name, &value, sizeof(T));
+		}
+
+		// writes the snapshot next to 'path' and then moves it over 'path', so a crash while writing does not leave a broken
+		// snapshot behind
+		bool save(const char* path) const {
+			PROFILE_ZONE("snapshot save");
+
+			std::string temporary_path = std::string(path) + ".tmp";
+
+			std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+			if (!output) {
+				print_error("snapshot could not create: ", temporary_path);
+				return false;
+			}
+
+			std::uint64_t offset = 0llu;
+
+			auto pad_to = [&](std::uint64_t alignment) {
+				static constexpr char zeros[section_alignment]{};
+
+				std::uint64_t aligned = (offset + alignment - 1llu) / alignment * alignment;
+				output.write(zeros, static_cast<std::streamsize>(aligned - offset));
+				offset = aligned;
+			};
+
+			// the header is written last, once the table is placed
+			snapshot_header header{};
+			output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			offset += sizeof(header);
+
+			std::vector<section_entry> table(blobs_.size());
+
+			for (std::size_t i = 0; i < blobs_.size(); i++) {
+				pad_to(section_alignment);
+
+				std::memcpy(table[i].name, names_[i].data(), names_[i].size());
+				table[i].offset = offset;
+				table[i].size = blobs_[i].size();
+
+				output.write(blobs_[i].data(), static_cast<std::streamsize>(blobs_[i].size()));
+				offset += blobs_[i].size();
+			}
+
+			pad_to(alignof(section_entry));
+
+			header.table_offset = offset;
+			output.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(section_entry)));
+
+			std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+			header.version = snapshot_version;
+			header.section_count = static_cast<std::uint32_t>(table.size());
+			header.vertex_size = static_cast<std::uint32_t>(sizeof(world::vertex));
+
+			output.seekp(0);
+			output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			output.close();
+
+			if (!output) {
+				print_error("snapshot could not write: ", temporary_path);
+				return false;
+			}
+
+			std::error_code error;
+			std::filesystem::rename(temporary_path, path, error);
+
+			if (error) {
+				print_error("snapshot could not replace: ", path);
+				return false;
+			}
+
+			return true;
+		}
+
+	private:
+		std::vector<std::string> names_;
+		std::vector<std::vector<char>> blobs_;
+	};
+
+	// a snapshot opened for reading, the sections are views into the mapped file
+	struct reader {
+
+		// maps the snapshot at 'path' and checks its table, returns false without an error when there is none
+		bool open(const char* path) {
+
+			std::error_code error;
+			if (!std::filesystem::is_regular_file(path, error)) {
+				return false;
+			}
+
+			auto file = std::make_shared<io::mapped_file>();
+			if (!file->open(path)) {
+				return false;
+			}
+
+			snapshot_header header;
+			if (file->size() < sizeof(header)) {
+				print_error("snapshot too small to be a snapshot: ", path);
+				return false;
+			}
+
+			std::memcpy(&header, file->data(), sizeof(header));
+
+			if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0 || header.version != snapshot_version) {
+				print_error("snapshot not a snapshot or of an unsupported version: ", path);
+				return false;
+			}
+
+			if (header.vertex_size != sizeof(world::vertex)) {
+				print_info("snapshot was made with another vertex layout: ", path);
+				return false;
+			}
+
+			std::uint64_t table_size = std::uint64_t(header.section_count) * sizeof(section_entry);
+
+			if (header.table_offset > file->size() || table_size > file->size() - header.table_offset) {
+				print_error("snapshot truncated table: ", path);
+				return false;
+			}
+
+			sections_.resize(header.section_count);
+			std::memcpy(sections_.data(), file->data() + header.table_offset, table_size);
+
+			for (const auto& section : sections_) {
+				if (section.offset > file->size() || section.size > file->size() - section.offset) {
+					print_error("snapshot corrupt table: ", path);
+					sections_.clear();
+					return false;
+				}
+			}
+
+			file_ = std::move(file);
+			return true;
+		}
+
+		// finds the section 'name', returns false when the snapshot has none
+		bool find(std::string_view name, std::string_view& output) const {
+
+			for (const auto& section : sections_) {
+				if (std::string_view(section.name, strnlen(section.name, sizeof(section.name))) == name) {
+					output = std::string_view(file_->data() + section.offset, static_cast<std::size_t>(section.size));
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		template<typename T>
+		bool read_vector(std::string_view name, std::vector<T>& output) const {
+
+			std::string_view bytes;
+			if (!find(name, bytes) || bytes.size() % sizeof(T) != 0llu) {
+				return false;
+			}
+
+			output.resize(bytes.size() / sizeof(T));
+			std::memcpy(output.data(), bytes.data(), bytes.size());
+			return true;
+		}
+
+		template<typename T>
+		bool read_value(std::string_view name, T& output) const {
+
+			std::string_view bytes;
+			if (!find(name, bytes) || bytes.size() != sizeof(T)) {
+				return false;
+			}
+
+			std::memcpy(&output, bytes.data(), sizeof(T));
+			return true;
+		}
+
+	private:
+		std::shared_ptr<io::mapped_file> file_;
+		std::vector<section_entry> sections_;
+	};
+}
+
+namespace world {
+
+	// writes a model, its nodes and its meshes into 'output'.
+	// returns false when the model can not be restored from a snapshot, like a model that is still loading or that has
+	// textures which were not loaded from a file.
+	bool write_model(std::vector<char>& output, const model& model_ref) {
+
+		using namespace snapshot::detail;
+
+		if (model_ref.is_placeholder()) {
+			return false;
+		}
+
+		// the textures are stored as the files they were loaded from
+		std::unordered_map<unsigned int, const opengl::image::texture_info*> textures;
+		opengl::image::data::textures.for_each([&](opengl::image::texture_handle, const opengl::image::texture_info& info) {
+			textures[info.id] = &info;
+		});
+
+		for (const auto& mesh : model_ref) {
+			bool from_files = true;
+
+			mesh.for_each_texture([&](const std::size_t&, const texture& tex) {
+				auto found = textures.find(tex.id);
+				from_files = from_files && found != textures.end() && !found->second->path.empty();
+			});
+
+			if (!from_files) {
+				return false;
+			}
+		}
+
+		std::uint64_t source_size = 0llu;
+		io::file_size(model_ref.path_to_file(), source_size);
+
+		write_block(output, model_ref.path_to_file());
+		write_value(output, source_size);
+		write_value(output, write_time(model_ref.path_to_file()));
+		write_value(output, static_cast<std::uint32_t>(model_ref.load_flags()));
+
+		write_value(output, model_ref.position());
+		write_value(output, model_ref.rotation());
+		write_value(output, model_ref.scale());
+		write_value(output, model_ref.local_bounds());
+		write_value(output, program_index(model_ref.shader_id));
+
+		// the nodes of a model are its root and the subtree below it, stored relative to the root
+		scene_graph::node_id root = model_ref.root_node();
+		std::uint64_t node_count = data::scene.subtree_size(root);
+
+		write_value(output, node_count);
+
+		for (scene_graph::node_id node = root; node < root + node_count; node++) {
+			std::uint64_t parent = node == root ? std::numeric_limits<std::uint64_t>::max() : data::scene.parent(node) - root;
+
+			write_value(output, parent);
+			write_value(output, data::scene.local(node));
+		}
+
+		const mesh_pool& pool = model_ref.meshes();
+
+		write_value(output, static_cast<std::uint64_t>(pool.size()));
+		write_value(output, static_cast<std::uint64_t>(pool.textures().size()));
+		write_value(output, static_cast<std::uint64_t>(pool.names().size()));
+
+		for (const auto& mesh : model_ref) {
+			write_block(output, mesh.name());
+			write_value(output, static_cast<std::uint64_t>(mesh.node() - root));
+
+			write_value(output, static_cast<std::uint32_t>(mesh.vertex_offset()));
+			write_value(output, static_cast<std::uint32_t>(mesh.vertex_size()));
+			write_value(output, static_cast<std::uint32_t>(mesh.index_offset()));
+			write_value(output, static_cast<std::uint32_t>(mesh.index_size()));
+
+			std::uint32_t texture_count = 0u;
+			mesh.for_each_texture([&](const std::size_t&, const texture&) {
+				texture_count++;
+			});
+
+			write_value(output, texture_count);
+
+			mesh.for_each_texture([&](const std::size_t&, const texture& tex) {
+				const auto* info = textures.at(tex.id);
+
+				write_value(output, static_cast<std::uint32_t>(tex.type));
+				write_block(output, info->path);
+				write_block(output, info->name);
+			});
+		}
+
+		// the arenas are stored whole, the meshes are ranges of them
+		write_block(output, pool.verticies().data(), pool.verticies().size() * sizeof(vertex));
+		write_block(output, pool.indices().data(), pool.indices().size() * sizeof(unsigned int));
+
+		return true;
+	}
+
+	// a model read back by 'read_model', its strings and arrays are views into the snapshot
+	struct snapshot_model {
+
+		struct mesh_record {
+			std::string_view name;
+			std::uint64_t node = 0llu;
+			std::uint32_t vertex_offset = 0u, vertex_count = 0u;
+			std::uint32_t index_offset = 0u, index_count = 0u;
+			std::size_t first_texture = 0llu;
+			std::uint32_t texture_count = 0u;
+		};
+
+		struct texture_record {
+			std::uint32_t type = 0u;
+			std::string_view path;
+			std::string_view name;
+		};
+
+		std::string_view path;
+		std::uint64_t source_size = 0llu;
+		std::int64_t source_time = 0;
+		std::uint32_t load_flags = 0u;
+
+		glm::vec3 position{};
+		rotation_values rotation{};
+		glm::vec3 scale{};
+		bounds box{};
+		std::int64_t program = -1;
+
+		// the parent of every node relative to the root, the root comes first and has none
+		std::vector<std::uint64_t> parents;
+		std::vector<glm::mat4> locals;
+
+		std::uint64_t name_length = 0llu;
+		std::vector<mesh_record> meshes;
+		std::vector<texture_record> textures;
+
+		std::string_view verticies;
+		std::string_view indices;
+	};
+
+	// reads a model written by 'write_model' without creating anything.
+	// returns false when 'input' is corrupt, when the file the model was loaded from has changed since or when the model
+	// was loaded with other flags than 'load_flags'.
+	bool read_model(std::string_view& input, unsigned int load_flags, snapshot_model& output) {
+
+		using namespace snapshot::detail;
+
+		bool valid = read_block(input, output.path)
+			&& read_value(input, output.source_size)
+			&& read_value(input, output.source_time)
+			&& read_value(input, output.load_flags)
+			&& read_value(input, output.position)
+			&& read_value(input, output.rotation)
+			&& read_value(input, output.scale)
+			&& read_value(input, output.box)
+			&& read_value(input, output.program);
+
+		std::uint64_t node_count = 0llu;
+		valid = valid && read_value(input, node_count) && node_count > 0llu && node_count <= input.size();
+
+		if (!valid) {
+			print_error("read_model truncated model");
+			return false;
+		}
+
+		// the time is only compared when the file was on disk both times, a file in a pack has none
+		std::uint64_t current_size;
+		std::int64_t current_time = write_time(output.path);
+
+		if ((io::file_size(output.path, current_size) && current_size != output.source_size)
+			|| (current_time != 0 && output.source_time != 0 && current_time != output.source_time)) {
+			print_info("read_model ", output.path, " has changed since the snapshot");
+			return false;
+		}
+
+		if (output.load_flags != load_flags) {
+			print_info("read_model ", output.path, " was loaded with other flags");
+			return false;
+		}
+
+		output.parents.resize(node_count);
+		output.locals.resize(node_count);
+
+		for (std::uint64_t i = 0; i < node_count && valid; i++) {
+			valid = read_value(input, output.parents[i]) && read_value(input, output.locals[i])
+				&& (i == 0llu ? output.parents[i] == std::numeric_limits<std::uint64_t>::max() : output.parents[i] < i);
+		}
+
+		std::uint64_t mesh_count = 0llu, texture_count = 0llu;
+		valid = valid && read_value(input, mesh_count) && read_value(input, texture_count) && read_value(input, output.name_length)
+			&& mesh_count <= input.size() && texture_count <= input.size();
+
+		if (valid) {
+			output.meshes.resize(mesh_count);
+			output.textures.reserve(texture_count);
+		}
+
+		for (auto& mesh : output.meshes) {
+			valid = valid
+				&& read_block(input, mesh.name)
+				&& read_value(input, mesh.node)
+				&& read_value(input, mesh.vertex_offset)
+				&& read_value(input, mesh.vertex_count)
+				&& read_value(input, mesh.index_offset)
+				&& read_value(input, mesh.index_count)
+				&& read_value(input, mesh.texture_count)
+				&& mesh.node < node_count;
+
+			mesh.first_texture = output.textures.size();
+
+			for (std::uint32_t i = 0; i < mesh.texture_count && valid; i++) {
+				auto& tex = output.textures.emplace_back();
+				valid = read_value(input, tex.type) && read_block(input, tex.path) && read_block(input, tex.name);
+			}
+
+			if (!valid) {
+				break;
+			}
+		}
+
+		valid = valid && read_block(input, output.verticies) && read_block(input, output.indices)
+			&& output.verticies.size() % sizeof(vertex) == 0llu && output.indices.size() % sizeof(unsigned int) == 0llu;
+
+		for (const auto& mesh : output.meshes) {
+			valid = valid
+				&& std::uint64_t(mesh.vertex_offset) + mesh.vertex_count <= output.verticies.size() / sizeof(vertex)
+				&& std::uint64_t(mesh.index_offset) + mesh.index_count <= output.indices.size() / sizeof(unsigned int);
+		}
+
+		if (!valid) {
+			print_error("read_model corrupt model: ", output.path);
+			return false;
+		}
+
+		return true;
+	}
+
+	// creates a model read by 'read_model', uploads its textures and its buffers
+	void restore_model(const snapshot_model& record, model_handle& handle) {
+
+		using namespace snapshot::detail;
+
+		// every texture file is decoded once, in parallel, before anything is created
+		std::vector<std::string> texture_paths;
+		std::vector<std::string> texture_names;
+		std::unordered_map<std::string_view, std::size_t> texture_slots;
+
+		for (const auto& tex : record.textures) {
+			if (texture_slots.try_emplace(tex.path, texture_paths.size()).second) {
+				texture_paths.emplace_back(tex.path);
+				texture_names.emplace_back(tex.name);
+			}
+		}
+
+		std::vector<opengl::image::decoded_image> images;
+		opengl::image::decode_batch(images, texture_paths);
+
+		std::vector<opengl::image::texture_handle> texture_handles;
+		opengl::image::upload_batch(texture_handles, images, texture_paths, texture_names);
+
+		auto new_handle = data::loaded_models.emplace();
+
+		model& model_ref = data::loaded_models.at(new_handle);
+		model_ref.id_ = new_handle.index;
+		model_ref.path_to_file_ = record.path;
+		model_ref.load_flags_ = record.load_flags;
+		model_ref.shader_id = program_id(record.program);
+
+		create_transform(model_ref, new_handle);
+
+		data::transforms.position(model_ref.transform_) = record.position;
+		data::transforms.rotation(model_ref.transform_) = record.rotation;
+		data::transforms.scale(model_ref.transform_) = record.scale;
+		data::transforms.local_bounds(model_ref.transform_) = record.box;
+
+		// the root was added by 'create_transform', the rest of the subtree follows it in one go
+		scene_graph::node_id root = model_ref.root_node_;
+		for (std::size_t i = 1; i < record.parents.size(); i++) {
+			data::scene.add_node(root + record.parents[i], record.locals[i]);
+		}
+
+		model_ref.meshes_.reserve(
+			record.meshes.size(),
+			record.verticies.size() / sizeof(vertex),
+			record.indices.size() / sizeof(unsigned int),
+			record.textures.size(),
+			static_cast<std::size_t>(record.name_length)
+		);
+
+		// a mesh that starts inside the geometry of an earlier mesh shares it, like a mesh placed by several nodes
+		std::unordered_map<std::uint32_t, std::size_t> first_mesh_at;
+		std::size_t stored_verticies = 0llu;
+
+		for (std::size_t i = 0; i < record.meshes.size(); i++) {
+			const auto& mesh = record.meshes[i];
+			scene_graph::node_id node = root + mesh.node;
+
+			if (mesh.vertex_offset < stored_verticies) {
+				auto source = first_mesh_at.find(mesh.vertex_offset);
+
+				if (source != first_mesh_at.end()) {
+					model_ref.meshes_.add_shared_mesh(source->second, mesh.name, node);
+					continue;
+				}
+			}
+
+			first_mesh_at.try_emplace(mesh.vertex_offset, i);
+
+			model_ref.meshes_.add_mesh(mesh.name, node);
+
+			std::memcpy(
+				model_ref.meshes_.add_verticies(mesh.vertex_count),
+				record.verticies.data() + std::size_t(mesh.vertex_offset) * sizeof(vertex),
+				std::size_t(mesh.vertex_count) * sizeof(vertex)
+			);
+
+			std::memcpy(
+				model_ref.meshes_.add_indices(mesh.index_count),
+				record.indices.data() + std::size_t(mesh.index_offset) * sizeof(unsigned int),
+				std::size_t(mesh.index_count) * sizeof(unsigned int)
+			);
+
+			stored_verticies = std::max<std::size_t>(stored_verticies, std::size_t(mesh.vertex_offset) + mesh.vertex_count);
+
+			for (std::uint32_t t = 0; t < mesh.texture_count; t++) {
+				const auto& tex = record.textures[mesh.first_texture + t];
+
+				if (const auto* info = opengl::image::get(texture_handles[texture_slots.at(tex.path)])) {
+					model_ref.meshes_.add_texture(texture(info->id, static_cast<texture_type>(tex.type)));
+				}
+			}
+		}
+
+		setup_model(new_handle);
+
+		handle = new_handle;
+	}
+}
+
+namespace snapshot {
+
+	// writes every model that has finished loading into the section "models".
+	// 'written' gets the handles of the written models, in the order 'read_models' restores them.
+	void write_models(writer& output, std::vector<world::model_handle>& written) {
+
+		std::vector<char> bytes;
+		std::vector<char> model_bytes;
+
+		written.clear();
+
+		world::data::loaded_models.for_each([&](world::model_handle handle, const world::model& model_ref) {
+			model_bytes.clear();
+
+			if (world::write_model(model_bytes, model_ref)) {
+				bytes.insert(bytes.end(), model_bytes.begin(), model_bytes.end());
+				written.push_back(handle);
+			}
+			else {
+				print_info("snapshot skipped model: ", model_ref.path_to_file());
+			}
+		});
+
+		std::vector<char> section;
+		detail::write_value(section, static_cast<std::uint64_t>(written.size()));
+		section.insert(section.end(), bytes.begin(), bytes.end());
+
+		output.add("models", std::move(section));
+	}
+
+	// reads every model of the section "models" without creating anything, see 'read_model'.
+	// 'load_flags' are the flags the models would be loaded with now.
+	bool read_models(const reader& input, unsigned int load_flags, std::vector<world::snapshot_model>& records) {
+		PROFILE_ZONE("read_models");
+
+		std::string_view bytes;
+		std::uint64_t count;
+
+		if (!input.find("models", bytes) || !detail::read_value(bytes, count) || count > bytes.size()) {
+			return false;
+		}
+
+		records.assign(count, world::snapshot_model{});
+
+		for (auto& record : records) {
+			if (!world::read_model(bytes, load_flags, record)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// creates the models read by 'read_models', 'handles' gets one per model in the order they were written
+	void restore_models(const std::vector<world::snapshot_model>& records, std::vector<world::model_handle>& handles) {
+		PROFILE_ZONE("restore_models");
+
+		handles.assign(records.size(), world::model_handle{});
+
+		for (std::size_t i = 0; i < records.size(); i++) {
+			world::restore_model(records[i], handles[i]);
+		}
+	}
+
+	// writes the models 'restore_models' created again and reads them back like the next start would.
+	// returns false when one of them would not be restored again, like a model that lost a field on the way.
+	bool check_models(const std::vector<world::model_handle>& models, unsigned int load_flags) {
+
+		std::vector<char> bytes;
+
+		for (const auto& handle : models) {
+			bytes.clear();
+
+			world::snapshot_model record;
+			std::string_view input;
+
+			if (!world::model_valid(handle) || !world::write_model(bytes, world::model_get(handle))) {
+				return false;
+			}
+
+			input = std::string_view(bytes.data(), bytes.size());
+			if (!world::read_model(input, load_flags, record) || !input.empty()) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// returns the index in 'records' of the model loaded from 'path'
+	bool find_model(const std::vector<world::snapshot_model>& records, std::string_view path, std::size_t& output) {
+
+		for (std::size_t i = 0; i < records.size(); i++) {
+			if (records[i].path == path) {
+				output = i;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// writes every instance of a model in 'models' into the section "instances", see 'write_models'
+	void write_instances(writer& output, const std::vector<world::model_handle>& models) {
+
+		std::vector<char> section;
+
+		world::data::instances.for_each([&](world::instance_handle, const world::instance& inst) {
+			auto model = std::find(models.begin(), models.end(), inst.asset);
+			if (model == models.end()) {
+				return;
+			}
+
+			detail::write_value(section, static_cast<std::uint64_t>(model - models.begin()));
+			detail::write_value(section, detail::program_index(inst.shader_id));
+			detail::write_value(section, inst.position());
+			detail::write_value(section, inst.rotation());
+			detail::write_value(section, inst.scale());
+		});
+
+		output.add("instances", std::move(section));
+	}
+
+	// an instance read back by 'read_instances', 'model' is its index in the models of the snapshot
+	struct instance_record {
+		std::uint64_t model = 0llu;
+		std::int64_t program = -1;
+		glm::vec3 position{};
+		world::rotation_values rotation{};
+		glm::vec3 scale{};
+	};
+
+	// reads the instances of the section "instances" without creating anything.
+	// 'model_count' is the number of models 'read_models' read, an instance of any other model is corrupt.
+	bool read_instances(const reader& input, std::size_t model_count, std::vector<instance_record>& records) {
+
+		std::string_view bytes;
+		if (!input.find("instances", bytes)) {
+			return false;
+		}
+
+		records.clear();
+
+		while (!bytes.empty()) {
+			auto& record = records.emplace_back();
+
+			bool valid = detail::read_value(bytes, record.model)
+				&& detail::read_value(bytes, record.program)
+				&& detail::read_value(bytes, record.position)
+				&& detail::read_value(bytes, record.rotation)
+				&& detail::read_value(bytes, record.scale)
+				&& record.model < model_count;
+
+			if (!valid) {
+				print_error("read_instances corrupt instances");
+				records.clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// places the instances read by 'read_instances' again, 'models' are the handles 'restore_models' returned.
+	// 'handles' gets the handles of the new instances.
+	void restore_instances(const std::vector<instance_record>& records, const std::vector<world::model_handle>& models, std::vector<world::instance_handle>& handles) {
+
+		handles.clear();
+
+		for (const auto& record : records) {
+			world::instance_handle handle;
+			if (world::create_instance(handle, models[record.model], detail::program_id(record.program), record.position, record.scale, record.rotation)) {
+				handles.push_back(handle);
+			}
+		}
+	}
+}
\ No newline at end of file
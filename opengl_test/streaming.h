@@ -0,0 +1,134 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <initializer_list>
+
+#include "print.h"
+#include "gui.h"
+#include "task_graph.h"
+#include "world.h"
+#include "obj_loader.h"
+
+// loading that is spread over frames, so the first frame does not wait for every asset.
+// the startup is a task graph, the slow part of a job runs on a background thread, the part that needs the GL context runs
+// on the main thread once that is done, as many of them per frame as fit into the frame budget.
+namespace streaming {
+
+	// ============================================================================================================================
+	namespace data {
+		// every job is a background task and a main thread task that waits for it, other tasks can be added to the graph directly
+		tasks::graph graph;
+
+		// how long 'update' may spend on main thread tasks every frame
+		double frame_budget_ms = 4.0;
+	}
+	// ============================================================================================================================
+
+	// runs 'work' on a background thread once the tasks in 'dependencies' are done, 'finish' is run by 'update' on the main
+	// thread once it is done. returns the task of 'finish', for the tasks that depend on the job.
+	tasks::task_id add_job(std::string name, std::function<void()> work, std::function<void()> finish, std::initializer_list<tasks::task_id> dependencies = {}) {
+		auto background = data::graph.add(name, tasks::affinity::worker, std::move(work), dependencies);
+		return data::graph.add(std::move(name), tasks::affinity::main_thread, std::move(finish), { background });
+	}
+
+	// adds a task that runs on a background thread once the tasks in 'dependencies' are done, for work that has nothing to
+	// hand to the main thread itself
+	tasks::task_id add_worker_task(std::string name, std::function<void()> work, std::initializer_list<tasks::task_id> dependencies = {}) {
+		return data::graph.add(std::move(name), tasks::affinity::worker, std::move(work), dependencies);
+	}
+
+	// adds a task that needs the GL context, it runs on the main thread once the tasks in 'dependencies' are done
+	tasks::task_id add_main_task(std::string name, std::function<void()> work, std::initializer_list<tasks::task_id> dependencies = {}) {
+		return data::graph.add(std::move(name), tasks::affinity::main_thread, std::move(work), dependencies);
+	}
+
+	// returns true while any task has not been done
+	bool is_loading() {
+		return !data::graph.done();
+	}
+
+	// runs the main thread tasks that are ready until 'budget_ms' ran out, call it once per frame.
+	// returns true once every task is done.
+	bool update(double budget_ms = data::frame_budget_ms) {
+		return data::graph.update(budget_ms);
+	}
+
+	// waits for every task and runs it, including the tasks that are added while running
+	void finish_all() {
+		data::graph.run_all();
+	}
+
+	// prints how long every task took, call it once everything is loaded
+	void print_report() {
+		data::graph.print_report("startup report");
+	}
+
+	// shows how much is left to load, nothing once everything is loaded
+	void show_progress() {
+
+		if (data::graph.done()) {
+			return;
+		}
+
+		float progress = static_cast<float>(data::graph.finished()) / static_cast<float>(std::max<std::size_t>(data::graph.size(), 1llu));
+
+		ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
+		ImGui::Text("loading %zu of %zu", data::graph.finished() + 1, data::graph.size());
+		ImGui::ProgressBar(progress, ImVec2(300.f, 0.f));
+
+		data::graph.for_each_pending([](const std::string& name, tasks::affinity where, tasks::task_state state) {
+			const char* doing = state == tasks::task_state::waiting ? "waiting  "
+				: where == tasks::affinity::worker ? "reading  " : "uploading";
+
+			ImGui::Text("%s %s", doing, name.c_str());
+		});
+
+		ImGui::End();
+	}
+}
+
+namespace world {
+
+	// creates a placeholder for the OBJ file at 'path' and reads the file in the background, see 'read_obj'.
+	// the meshes are filled into the placeholder once they are read, after that 'on_loaded' is called on the main thread.
+	// the placeholder has the bounds of the model when the file has an up to date cache, it is a unit box otherwise.
+	// returns the task that fills the model.
+	tasks::task_id stream_obj(model_handle& handle, const char* path, unsigned int load_flags = default_load_flags, std::function<void(model_handle)> on_loaded = {}) {
+
+		bounds box{ glm::vec3(-0.5f), glm::vec3(0.5f) };
+		load_obj_bounds(path, load_flags, box);
+
+		create_placeholder(handle, path, box, load_flags);
+
+		struct streamed_obj {
+			std::string path;
+			obj_scene scene;
+			bool read = false;
+		};
+
+		auto streamed = std::make_shared<streamed_obj>();
+		streamed->path = path;
+
+		return streaming::add_job(streamed->path,
+			[streamed, load_flags]() {
+				streamed->read = read_obj(streamed->path.c_str(), load_flags, streamed->scene);
+			},
+			[streamed, target = handle, on_loaded = std::move(on_loaded)]() {
+				if (!streamed->read || !model_valid(target)) {
+					print_error("stream_obj could not load: ", streamed->path);
+					return;
+				}
+
+				fill_obj_model(model_get(target), streamed->scene);
+				setup_model(target);
+
+				if (on_loaded) {
+					on_loaded(target);
+				}
+			}
+		);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <future>
+#include <functional>
+#include <algorithm>
+#include <initializer_list>
+#include <chrono>
+#include <limits>
+#include <iomanip>
+#include <cassert>
+
+#include "print.h"
+
+// work split into tasks that wait for the tasks they depend on.
+// a task runs either on a background thread or on the main thread, which is the only thread with the GL context.
+// the graph itself is only touched from the main thread, the background tasks only run their own work.
+namespace tasks {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	using task_id = std::size_t;
+	using clock = std::chrono::steady_clock;
+
+	enum class affinity {
+		worker,
+		main_thread
+	};
+
+	enum class task_state {
+		waiting,
+		ready,
+		running,
+		done
+	};
+
+	// ============================================================================================================================
+
+	struct graph {
+
+		// adds a task that runs once every task in 'dependencies' is done, a worker task with nothing to wait for starts right away.
+		// the tasks are kept once they are done, so a task can still depend on them and the report covers every task.
+		task_id add(std::string name, affinity where, std::function<void()> work, std::initializer_list<task_id> dependencies = {}) {
+
+			if (tasks_.empty()) {
+				started_ = clock::now();
+			}
+
+			task_id id = tasks_.size();
+
+			auto& added = tasks_.emplace_back();
+			added.name = std::move(name);
+			added.where = where;
+			added.work = std::move(work);
+
+			for (task_id dependency : dependencies) {
+				assert(dependency < id);
+
+				if (tasks_[dependency].state != task_state::done) {
+					tasks_[dependency].dependents.push_back(id);
+					added.waiting_on++;
+				}
+			}
+
+			if (added.waiting_on == 0llu) {
+				make_ready(id);
+			}
+
+			return id;
+		}
+
+		// finishes the background tasks that are done and runs main thread tasks until 'budget_ms' ran out.
+		// at least one main thread task runs per call, so a task that takes longer than the budget is not put off forever.
+		// returns true once every task is done.
+		bool update(double budget_ms) {
+
+			auto start = clock::now();
+
+			collect_workers();
+
+			while (!main_ready_.empty()) {
+
+				task_id id = main_ready_.front();
+				main_ready_.erase(main_ready_.begin());
+
+				run_on_main(id);
+
+				// the work of a main thread task can be what a background task waited for
+				collect_workers();
+
+				if (std::chrono::duration<double, std::milli>(clock::now() - start).count() >= budget_ms) {
+					break;
+				}
+			}
+
+			return done();
+		}
+
+		// runs every task, including the tasks that are added while running
+		void run_all() {
+			while (!done()) {
+				if (main_ready_.empty()) {
+					wait_for_worker();
+				}
+
+				update(std::numeric_limits<double>::infinity());
+			}
+		}
+
+		// returns true once every task is done
+		bool done() const {
+			return finished_ == tasks_.size();
+		}
+
+		std::size_t size() const {
+			return tasks_.size();
+		}
+
+		std::size_t finished() const {
+			return finished_;
+		}
+
+		// calls 'callback(name, where, state)' for every task that is not done
+		template<typename F>
+		void for_each_pending(F callback) const {
+			for (const auto& pending : tasks_) {
+				if (pending.state != task_state::done) {
+					callback(pending.name, pending.where, pending.state);
+				}
+			}
+		}
+
+		// prints when every task started and how long it took, sorted by when it started.
+		// 'waited' is the time between all its dependencies being done and it starting, the work of all tasks can add up to
+		// more than the wall time when they overlapped.
+		void print_report(const char* title) const {
+
+			if (tasks_.empty()) {
+				return;
+			}
+
+			std::vector<const task*> sorted;
+			sorted.reserve(tasks_.size());
+
+			clock::time_point last_end = started_;
+			double total_work = 0.0;
+
+			for (const auto& entry : tasks_) {
+				sorted.push_back(&entry);
+
+				if (entry.state == task_state::done) {
+					last_end = std::max(last_end, entry.end);
+					total_work += milliseconds(entry.start, entry.end);
+				}
+			}
+
+			std::stable_sort(sorted.begin(), sorted.end(), [](const task* left, const task* right) {
+				return left->start < right->start;
+			});
+
+			print_info(title, ": ", tasks_.size(), " tasks, ", milliseconds(started_, last_end), " ms wall time, ", total_work, " ms of work");
+
+			for (const task* entry : sorted) {
+
+				if (entry->state != task_state::done) {
+					print_info("  ", std::left, std::setw(24), entry->name, " not done");
+					continue;
+				}
+
+				print_info(
+					"  ", std::left, std::setw(24), entry->name,
+					std::setw(8), entry->where == affinity::main_thread ? "main" : "worker",
+					std::right, std::fixed, std::setprecision(2),
+					" at ", std::setw(9), milliseconds(started_, entry->start), " ms",
+					" took ", std::setw(9), milliseconds(entry->start, entry->end), " ms",
+					" waited ", std::setw(9), milliseconds(entry->ready, entry->start), " ms"
+				);
+			}
+		}
+
+	private:
+
+		struct timing {
+			clock::time_point start;
+			clock::time_point end;
+		};
+
+		struct task {
+			std::string name;
+			affinity where = affinity::worker;
+			std::function<void()> work;
+
+			task_state state = task_state::waiting;
+			std::size_t waiting_on = 0llu;
+			std::vector<task_id> dependents;
+
+			// only set for background tasks while they run
+			std::future<timing> running;
+
+			clock::time_point ready;
+			clock::time_point start;
+			clock::time_point end;
+		};
+
+		static double milliseconds(clock::time_point from, clock::time_point to) {
+			return std::chrono::duration<double, std::milli>(to - from).count();
+		}
+
+		void make_ready(task_id id) {
+
+			auto& target = tasks_[id];
+			target.state = task_state::ready;
+			target.ready = clock::now();
+
+			if (target.where == affinity::main_thread) {
+				main_ready_.push_back(id);
+				return;
+			}
+
+			// the work is moved into the thread, the task itself can move while it runs
+			target.state = task_state::running;
+			target.running = std::async(std::launch::async, [work = std::move(target.work)]() {
+				timing measured;
+				measured.start = clock::now();
+				if (work) {
+					work();
+				}
+				measured.end = clock::now();
+				return measured;
+			});
+		}
+
+		void run_on_main(task_id id) {
+
+			auto& target = tasks_[id];
+			target.state = task_state::running;
+			target.start = clock::now();
+
+			// moved out first, the work can add tasks
+			auto work = std::move(target.work);
+			if (work) {
+				work();
+			}
+
+			tasks_[id].end = clock::now();
+			complete(id);
+		}
+
+		void complete(task_id id) {
+
+			tasks_[id].state = task_state::done;
+			finished_++;
+
+			for (task_id dependent : tasks_[id].dependents) {
+				if (--tasks_[dependent].waiting_on == 0llu) {
+					make_ready(dependent);
+				}
+			}
+		}
+
+		// completes the background tasks that are done, which can make main thread tasks ready
+		void collect_workers() {
+			for (task_id id = 0; id < tasks_.size(); id++) {
+				auto& target = tasks_[id];
+
+				if (target.state == task_state::running && target.running.valid()
+					&& target.running.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+
+					timing measured = target.running.get();
+					target.start = measured.start;
+					target.end = measured.end;
+
+					complete(id);
+				}
+			}
+		}
+
+		void wait_for_worker() {
+			while (true) {
+				for (auto& target : tasks_) {
+					if (target.state == task_state::running && target.running.valid()
+						&& target.running.wait_for(std::chrono::milliseconds(1)) == std::future_status::ready) {
+						return;
+					}
+				}
+			}
+		}
+
+		std::vector<task> tasks_;
+		std::vector<task_id> main_ready_;
+		std::size_t finished_ = 0llu;
+		clock::time_point started_;
+	};
+}
\ No newline at end of file
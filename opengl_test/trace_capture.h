@@ -0,0 +1,215 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+
+#include "print.h"
+#include "json.h"
+#include "profiler.h"
+#include "gpu_profiler.h"
+
+// writes frames of the profiler into a Chrome trace event file, which chrome://tracing and ui.perfetto.dev open.
+// a capture holds the zones of every thread, the GPU passes as a thread of their own, the counters and the thread names.
+// the frames are taken from the history of the profiler, so a capture can also cover frames that already happened, like
+// the frames before a slow one.
+namespace trace_capture {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	// the frames 'first' to 'last', without 'last', written to 'path' once the GPU results of the last frame are in
+	struct pending_capture {
+		std::string path;
+		std::uint64_t first = 0llu;
+		std::uint64_t last = 0llu;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		std::vector<pending_capture> pending;
+
+		// a frame that takes longer captures it and the frames before it, 0 turns it off
+		double slow_frame_ms = 0.0;
+		std::size_t slow_frame_capture_frames = 10llu;
+
+		// after a slow frame is captured, the next slow frames are not captured for this many frames
+		std::uint64_t slow_frame_cooldown = 600llu;
+		std::uint64_t next_slow_capture = 0llu;
+	}
+	// ============================================================================================================================
+
+	namespace detail {
+
+		// the zones keep at most the last 'frame_history' frames
+		constexpr std::size_t max_frames = profiler::frame_history - gpu_profiler::frames_in_flight - 2llu;
+
+		std::string next_path() {
+			return "trace_" + std::to_string(profiler::data::frame_count) + ".json";
+		}
+
+		void write_microseconds(std::ostream& output, std::uint64_t nanoseconds) {
+			output << static_cast<double>(nanoseconds) / 1000.0;
+		}
+
+		void write_metadata(std::ostream& output, const char* kind, std::size_t thread, std::string_view name) {
+			output << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":";
+			json::write_string(output, name);
+			output << "}}";
+		}
+
+		void write_complete(std::ostream& output, std::size_t thread, const char* name, std::uint64_t start, std::uint64_t end, std::uint64_t origin) {
+			output << "{\"name\":";
+			json::write_string(output, name);
+			output << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread << ",\"ts\":";
+			write_microseconds(output, start - origin);
+			output << ",\"dur\":";
+			write_microseconds(output, end - start);
+			output << "}";
+		}
+	}
+
+	// writes every zone, GPU pass and counter between 'start' and 'end' to 'path'
+	bool write_trace(const char* path, std::uint64_t start, std::uint64_t end, const std::vector<std::uint64_t>& frame_starts) {
+
+		PROFILE_ZONE("write_trace");
+
+		std::ofstream output(path, std::ios::trunc);
+		if (!output) {
+			print_error("write_trace could not create: ", path);
+			return false;
+		}
+
+		std::vector<profiler::lane> lanes;
+		profiler::collect(start, end, lanes);
+
+		// the events are nanoseconds written as microseconds
+		output << std::fixed << std::setprecision(3);
+		output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		detail::write_metadata(output, "process_name", 0llu, "opengl_test");
+
+		std::size_t events = 0llu;
+
+		for (std::size_t thread = 0; thread < lanes.size(); thread++) {
+			output << ",\n";
+			detail::write_metadata(output, "thread_name", thread, lanes[thread].name);
+
+			for (const auto& recorded : lanes[thread].zones) {
+				output << ",\n";
+				detail::write_complete(output, thread, recorded.name, std::max(recorded.start, start), std::min(recorded.end, end), start);
+				events++;
+			}
+		}
+
+		// the GPU is a thread after the last CPU thread
+		std::size_t gpu_thread = lanes.size();
+
+		output << ",\n";
+		detail::write_metadata(output, "thread_name", gpu_thread, "GPU");
+
+		for (const auto& sample : gpu_profiler::data::samples) {
+			if (sample.end >= start && sample.start < end) {
+				output << ",\n";
+				detail::write_complete(output, gpu_thread, sample.name, std::max(sample.start, start), std::min(sample.end, end), start);
+				events++;
+			}
+		}
+
+		for (const auto& counter : profiler::data::counters) {
+			if (counter.time >= start && counter.time < end) {
+				output << ",\n{\"name\":";
+				json::write_string(output, counter.name);
+				output << ",\"ph\":\"C\",\"pid\":1,\"ts\":";
+				detail::write_microseconds(output, counter.time - start);
+				output << ",\"args\":{\"value\":" << counter.value << "}}";
+				events++;
+			}
+		}
+
+		// the frames are marks across every thread
+		for (std::size_t i = 0; i < frame_starts.size(); i++) {
+			output << ",\n{\"name\":\"frame " << i << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":";
+			detail::write_microseconds(output, frame_starts[i] - start);
+			output << "}";
+		}
+
+		output << "\n]}\n";
+		output.close();
+
+		if (!output) {
+			print_error("write_trace could not write: ", path);
+			return false;
+		}
+
+		print_info("Saved ", frame_starts.size(), " frames with ", events, " events to ", path);
+		return true;
+	}
+
+	// captures the next 'frames' frames, starting with the next frame. without a path it is named after the frame.
+	void capture_next_frames(std::size_t frames, std::string path = {}) {
+
+		frames = std::clamp<std::size_t>(frames, 1llu, detail::max_frames);
+
+		std::uint64_t first = profiler::data::frame_count;
+		data::pending.push_back({ path.empty() ? detail::next_path() : std::move(path), first, first + frames });
+
+		print_info("Capturing ", frames, " frames");
+	}
+
+	// captures the last 'frames' frames that are complete
+	void capture_last_frames(std::size_t frames, std::string path = {}) {
+
+		std::uint64_t last = profiler::data::frame_count > 0llu ? profiler::data::frame_count - 1llu : 0llu;
+		frames = std::min<std::size_t>(std::clamp<std::size_t>(frames, 1llu, detail::max_frames), last);
+
+		if (frames == 0llu) {
+			return;
+		}
+
+		data::pending.push_back({ path.empty() ? detail::next_path() : std::move(path), last - frames, last });
+	}
+
+	// writes the captures that are complete and captures slow frames, call it after 'profiler::begin_frame'
+	void update() {
+
+		std::uint64_t frame_count = profiler::data::frame_count;
+
+		// the frame before the one that just started is complete
+		if (data::slow_frame_ms > 0.0 && frame_count >= 2llu && frame_count - 1llu >= data::next_slow_capture) {
+			std::uint64_t slow = frame_count - 2llu;
+			double took = static_cast<double>(profiler::frame_start(slow + 1llu) - profiler::frame_start(slow)) / 1000000.0;
+
+			if (took > data::slow_frame_ms) {
+				print_info("Frame ", slow, " took ", took, " ms, capturing it");
+
+				capture_last_frames(data::slow_frame_capture_frames);
+				data::next_slow_capture = frame_count - 1llu + data::slow_frame_cooldown;
+			}
+		}
+
+		// the GPU results of a frame are read back 'frames_in_flight' frames later
+		for (auto it = data::pending.begin(); it != data::pending.end();) {
+			if (frame_count < it->last + gpu_profiler::frames_in_flight + 1llu) {
+				++it;
+				continue;
+			}
+
+			if (frame_count - it->first < profiler::frame_history) {
+				std::vector<std::uint64_t> frame_starts;
+				for (std::uint64_t frame = it->first; frame < it->last; frame++) {
+					frame_starts.push_back(profiler::frame_start(frame));
+				}
+
+				write_trace(it->path.c_str(), profiler::frame_start(it->first), profiler::frame_start(it->last), frame_starts);
+			}
+			else {
+				print_error("trace_capture the frames of ", it->path, " are not in the history anymore");
+			}
+
+			it = data::pending.erase(it);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,354 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define WORLD_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace world::kernels {
+
+	// ============================================================================================================================
+	// Batch kernels that turn position, euler rotation (in degrees) and scale arrays into
+	// model matrices (translate * rotate y * rotate z * rotate x * scale) and
+	// forward, up and right vectors (the euler quaternion applied to z, y and x).
+	//
+	// every input and output is a plain array of 'count' elements, which is what 'world::transform_range' hands out.
+	// 'changed' receives 1 for every element of which an input differed from the 'last_*' arrays,
+	// the 'last_*' arrays are brought up to date. elements that did not change are left alone.
+	// ============================================================================================================================
+
+	struct transform_arrays {
+		std::size_t count = 0;
+
+		const float* positions = nullptr;	// 3 floats per element
+		const float* scales = nullptr;		// 3 floats per element
+		const float* rotations = nullptr;	// 3 floats per element, degrees
+
+		float* last_positions = nullptr;
+		float* last_scales = nullptr;
+		float* last_rotations = nullptr;
+
+		float* forwards = nullptr;			// 3 floats per element
+		float* ups = nullptr;				// 3 floats per element
+		float* rights = nullptr;			// 3 floats per element
+		float* matrices = nullptr;			// 16 floats per element, column major
+
+		std::uint8_t* changed = nullptr;
+	};
+
+	constexpr float degrees_to_radians = 0.01745329251994329577f;
+
+	// ============================================================================================================================
+
+	// calculates a single element, used for the elements that do not fill a whole SIMD register
+	inline void compose_scalar(transform_arrays& a, std::size_t i) {
+
+		const float* p = a.positions + i * 3llu;
+		const float* s = a.scales + i * 3llu;
+		const float* r = a.rotations + i * 3llu;
+
+		float* lp = a.last_positions + i * 3llu;
+		float* ls = a.last_scales + i * 3llu;
+		float* lr = a.last_rotations + i * 3llu;
+
+		bool rotation_changed = r[0] != lr[0] || r[1] != lr[1] || r[2] != lr[2];
+		bool changed = rotation_changed
+			|| p[0] != lp[0] || p[1] != lp[1] || p[2] != lp[2]
+			|| s[0] != ls[0] || s[1] != ls[1] || s[2] != ls[2];
+
+		if (!changed) {
+			return;
+		}
+
+		const float ax = r[0] * degrees_to_radians;
+		const float ay = r[1] * degrees_to_radians;
+		const float az = r[2] * degrees_to_radians;
+
+		if (rotation_changed) {
+			// the quaternion of the euler angles
+			const float hcx = std::cos(ax * 0.5f), hsx = std::sin(ax * 0.5f);
+			const float hcy = std::cos(ay * 0.5f), hsy = std::sin(ay * 0.5f);
+			const float hcz = std::cos(az * 0.5f), hsz = std::sin(az * 0.5f);
+
+			const float qw = hcx * hcy * hcz + hsx * hsy * hsz;
+			const float qx = hsx * hcy * hcz - hcx * hsy * hsz;
+			const float qy = hcx * hsy * hcz + hsx * hcy * hsz;
+			const float qz = hcx * hcy * hsz - hsx * hsy * hcz;
+
+			float* f = a.forwards + i * 3llu;
+			float* u = a.ups + i * 3llu;
+			float* rt = a.rights + i * 3llu;
+
+			f[0] = 2.f * (qx * qz + qw * qy);
+			f[1] = 2.f * (qy * qz - qw * qx);
+			f[2] = 1.f - 2.f * (qx * qx + qy * qy);
+
+			u[0] = 2.f * (qx * qy - qw * qz);
+			u[1] = 1.f - 2.f * (qx * qx + qz * qz);
+			u[2] = 2.f * (qy * qz + qw * qx);
+
+			rt[0] = 1.f - 2.f * (qy * qy + qz * qz);
+			rt[1] = 2.f * (qx * qy + qw * qz);
+			rt[2] = 2.f * (qx * qz - qw * qy);
+		}
+
+		const float ca = std::cos(ax), sa = std::sin(ax);
+		const float cb = std::cos(ay), sb = std::sin(ay);
+		const float cc = std::cos(az), sc = std::sin(az);
+
+		float* m = a.matrices + i * 16llu;
+
+		m[0] = cb * cc * s[0];
+		m[1] = sc * s[0];
+		m[2] = -sb * cc * s[0];
+		m[3] = 0.f;
+
+		m[4] = (sb * sa - cb * sc * ca) * s[1];
+		m[5] = cc * ca * s[1];
+		m[6] = (sb * sc * ca + cb * sa) * s[1];
+		m[7] = 0.f;
+
+		m[8] = (cb * sc * sa + sb * ca) * s[2];
+		m[9] = -cc * sa * s[2];
+		m[10] = (cb * ca - sb * sc * sa) * s[2];
+		m[11] = 0.f;
+
+		m[12] = p[0];
+		m[13] = p[1];
+		m[14] = p[2];
+		m[15] = 1.f;
+
+		for (int k = 0; k < 3; k++) {
+			lp[k] = p[k];
+			ls[k] = s[k];
+			lr[k] = r[k];
+		}
+
+		a.changed[i] = 1u;
+	}
+
+#ifdef WORLD_SIMD_SSE2
+
+	namespace sse {
+
+		// loads 4 packed vec3's and returns them as xxxx, yyyy, zzzz
+		inline void load_vec3x4(const float* p, __m128& x, __m128& y, __m128& z) {
+			const __m128 a = _mm_loadu_ps(p);		// x0 y0 z0 x1
+			const __m128 b = _mm_loadu_ps(p + 4);	// y1 z1 x2 y2
+			const __m128 c = _mm_loadu_ps(p + 8);	// z2 x3 y3 z3
+
+			const __m128 bc_x = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 2, 0));		// y1 x2 x3 z2
+			x = _mm_shuffle_ps(a, bc_x, _MM_SHUFFLE(2, 1, 3, 0));					// x0 x1 x2 x3
+
+			const __m128 ab_y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 0, 1, 0));		// x0 y0 y1 y2
+			const __m128 bc_y = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));		// y2 y2 y3 y3
+			y = _mm_shuffle_ps(ab_y, bc_y, _MM_SHUFFLE(2, 0, 2, 1));				// y0 y1 y2 y3
+
+			const __m128 ab_z = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));		// z0 z0 z1 z1
+			z = _mm_shuffle_ps(ab_z, c, _MM_SHUFFLE(3, 0, 2, 0));					// z0 z1 z2 z3
+		}
+
+		// stores xxxx, yyyy, zzzz as 4 packed vec3's, without touching the memory after the last one
+		inline void store_vec3x4(float* p, __m128 x, __m128 y, __m128 z) {
+			__m128 w = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			// every store overwrites the padding lane of the previous one
+			_mm_storeu_ps(p, x);
+			_mm_storeu_ps(p + 3, y);
+			_mm_storeu_ps(p + 6, z);
+			_mm_storel_pi(reinterpret_cast<__m64*>(p + 9), w);
+			_mm_store_ss(p + 11, _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 2, 2)));
+		}
+
+		// stores one column of 4 matrices
+		inline void store_column4(float* matrices, int column, __m128 x, __m128 y, __m128 z, __m128 w) {
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			_mm_storeu_ps(matrices + 0 * 16 + column * 4, x);
+			_mm_storeu_ps(matrices + 1 * 16 + column * 4, y);
+			_mm_storeu_ps(matrices + 2 * 16 + column * 4, z);
+			_mm_storeu_ps(matrices + 3 * 16 + column * 4, w);
+		}
+
+		// sine and cosine of 4 floats at once.
+		// uses the same range reduction and minimax polynomials as the cephes library, accurate to a few ulp.
+		inline void sincos(__m128 x, __m128& out_sin, __m128& out_cos) {
+
+			const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+
+			__m128 sign_sin = _mm_and_ps(x, sign_mask);
+			x = _mm_andnot_ps(sign_mask, x);
+
+			// scale by 4/pi and round to the closest even octant
+			__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+			octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+			octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+			const __m128 y = _mm_cvtepi32_ps(octant);
+
+			const __m128 swap_sign_sin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+			const __m128 poly_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+			const __m128 sign_cos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+
+			sign_sin = _mm_xor_ps(sign_sin, swap_sign_sin);
+
+			// extended precision modular arithmetic: x - y * pi/4
+			x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+			x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+			x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+			const __m128 z = _mm_mul_ps(x, x);
+
+			// cosine polynomial on [-pi/4, pi/4]
+			__m128 poly_cos = _mm_set1_ps(2.443315711809948e-5f);
+			poly_cos = _mm_add_ps(_mm_mul_ps(poly_cos, z), _mm_set1_ps(-1.388731625493765e-3f));
+			poly_cos = _mm_add_ps(_mm_mul_ps(poly_cos, z), _mm_set1_ps(4.166664568298827e-2f));
+			poly_cos = _mm_mul_ps(_mm_mul_ps(poly_cos, z), z);
+			poly_cos = _mm_sub_ps(poly_cos, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+			poly_cos = _mm_add_ps(poly_cos, _mm_set1_ps(1.f));
+
+			// sine polynomial on [-pi/4, pi/4]
+			__m128 poly_sin = _mm_set1_ps(-1.9515295891e-4f);
+			poly_sin = _mm_add_ps(_mm_mul_ps(poly_sin, z), _mm_set1_ps(8.3321608736e-3f));
+			poly_sin = _mm_add_ps(_mm_mul_ps(poly_sin, z), _mm_set1_ps(-1.6666654611e-1f));
+			poly_sin = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(poly_sin, z), x), x);
+
+			const __m128 s = _mm_or_ps(_mm_and_ps(poly_mask, poly_sin), _mm_andnot_ps(poly_mask, poly_cos));
+			const __m128 c = _mm_or_ps(_mm_and_ps(poly_mask, poly_cos), _mm_andnot_ps(poly_mask, poly_sin));
+
+			out_sin = _mm_xor_ps(s, sign_sin);
+			out_cos = _mm_xor_ps(c, sign_cos);
+		}
+
+		// calculates the elements [i, i + 4)
+		inline void compose4(transform_arrays& a, std::size_t i) {
+
+			__m128 px, py, pz, sx, sy, sz, rx, ry, rz;
+			load_vec3x4(a.positions + i * 3llu, px, py, pz);
+			load_vec3x4(a.scales + i * 3llu, sx, sy, sz);
+			load_vec3x4(a.rotations + i * 3llu, rx, ry, rz);
+
+			__m128 lx, ly, lz;
+			load_vec3x4(a.last_rotations + i * 3llu, lx, ly, lz);
+			const int rotation_changed = _mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmpneq_ps(rx, lx), _mm_cmpneq_ps(ry, ly)), _mm_cmpneq_ps(rz, lz)));
+
+			int changed = rotation_changed;
+
+			load_vec3x4(a.last_positions + i * 3llu, lx, ly, lz);
+			changed |= _mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmpneq_ps(px, lx), _mm_cmpneq_ps(py, ly)), _mm_cmpneq_ps(pz, lz)));
+
+			load_vec3x4(a.last_scales + i * 3llu, lx, ly, lz);
+			changed |= _mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmpneq_ps(sx, lx), _mm_cmpneq_ps(sy, ly)), _mm_cmpneq_ps(sz, lz)));
+
+			if (changed == 0) {
+				return;
+			}
+
+			const __m128 to_radians = _mm_set1_ps(degrees_to_radians);
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 one = _mm_set1_ps(1.f);
+			const __m128 two = _mm_set1_ps(2.f);
+
+			const __m128 ax = _mm_mul_ps(rx, to_radians);
+			const __m128 ay = _mm_mul_ps(ry, to_radians);
+			const __m128 az = _mm_mul_ps(rz, to_radians);
+
+			if (rotation_changed != 0) {
+				// the quaternion of the euler angles
+				__m128 hsx, hcx, hsy, hcy, hsz, hcz;
+				sincos(_mm_mul_ps(ax, half), hsx, hcx);
+				sincos(_mm_mul_ps(ay, half), hsy, hcy);
+				sincos(_mm_mul_ps(az, half), hsz, hcz);
+
+				const __m128 qw = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(hcx, hcy), hcz), _mm_mul_ps(_mm_mul_ps(hsx, hsy), hsz));
+				const __m128 qx = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(hsx, hcy), hcz), _mm_mul_ps(_mm_mul_ps(hcx, hsy), hsz));
+				const __m128 qy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(hcx, hsy), hcz), _mm_mul_ps(_mm_mul_ps(hsx, hcy), hsz));
+				const __m128 qz = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(hcx, hcy), hsz), _mm_mul_ps(_mm_mul_ps(hsx, hsy), hcz));
+
+				const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+				const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+				const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+				store_vec3x4(a.forwards + i * 3llu,
+					_mm_mul_ps(two, _mm_add_ps(xz, wy)),
+					_mm_mul_ps(two, _mm_sub_ps(yz, wx)),
+					_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+
+				store_vec3x4(a.ups + i * 3llu,
+					_mm_mul_ps(two, _mm_sub_ps(xy, wz)),
+					_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))),
+					_mm_mul_ps(two, _mm_add_ps(yz, wx)));
+
+				store_vec3x4(a.rights + i * 3llu,
+					_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))),
+					_mm_mul_ps(two, _mm_add_ps(xy, wz)),
+					_mm_mul_ps(two, _mm_sub_ps(xz, wy)));
+			}
+
+			__m128 sa, ca, sb, cb, sc, cc;
+			sincos(ax, sa, ca);
+			sincos(ay, sb, cb);
+			sincos(az, sc, cc);
+
+			const __m128 zero = _mm_setzero_ps();
+			float* m = a.matrices + i * 16llu;
+
+			// column 0: rotate y * rotate z * x axis
+			store_column4(m, 0,
+				_mm_mul_ps(_mm_mul_ps(cb, cc), sx),
+				_mm_mul_ps(sc, sx),
+				_mm_sub_ps(zero, _mm_mul_ps(_mm_mul_ps(sb, cc), sx)),
+				zero);
+
+			// column 1: rotate y * rotate z * rotate x * y axis
+			store_column4(m, 1,
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sb, sa), _mm_mul_ps(_mm_mul_ps(cb, sc), ca)), sy),
+				_mm_mul_ps(_mm_mul_ps(cc, ca), sy),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(sb, sc), ca), _mm_mul_ps(cb, sa)), sy),
+				zero);
+
+			// column 2: rotate y * rotate z * rotate x * z axis
+			store_column4(m, 2,
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(cb, sc), sa), _mm_mul_ps(sb, ca)), sz),
+				_mm_sub_ps(zero, _mm_mul_ps(_mm_mul_ps(cc, sa), sz)),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cb, ca), _mm_mul_ps(_mm_mul_ps(sb, sc), sa)), sz),
+				zero);
+
+			// column 3: translation
+			store_column4(m, 3, px, py, pz, one);
+
+			store_vec3x4(a.last_positions + i * 3llu, px, py, pz);
+			store_vec3x4(a.last_scales + i * 3llu, sx, sy, sz);
+			store_vec3x4(a.last_rotations + i * 3llu, rx, ry, rz);
+
+			for (int k = 0; k < 4; k++) {
+				if (changed & (1 << k)) {
+					a.changed[i + k] = 1u;
+				}
+			}
+		}
+	}
+
+#endif // WORLD_SIMD_SSE2
+
+	// ============================================================================================================================
+
+	// updates the cached matrices and orientation vectors of every element of which an input has changed
+	inline void compose_transforms(transform_arrays& a) {
+
+		std::size_t i = 0;
+
+#ifdef WORLD_SIMD_SSE2
+		for (; i + 4llu <= a.count; i += 4llu) {
+			sse::compose4(a, i);
+		}
+#endif // WORLD_SIMD_SSE2
+
+		for (; i < a.count; i++) {
+			compose_scalar(a, i);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,326 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "scene_graph.h"
+#include "transform_kernels.h"
+#include "profiler.h"
+#include "slot_map.h"
+
+namespace world {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	struct rotation_values {
+		float angle_x = 0.f;
+		float angle_y = 0.f;
+		float angle_z = 0.f;
+
+		bool operator==(const rotation_values& rhs) const {
+			return angle_x == rhs.angle_x
+				&& angle_y == rhs.angle_y
+				&& angle_z == rhs.angle_z;
+		}
+
+		bool operator!=(const rotation_values& rhs) const {
+			return angle_x != rhs.angle_x
+				|| angle_y != rhs.angle_y
+				|| angle_z != rhs.angle_z;
+		}
+	};
+
+	// an axis aligned bounding box in the local space of a model
+	struct bounds {
+		glm::vec3 min{ 0.f, 0.f, 0.f };
+		glm::vec3 max{ 0.f, 0.f, 0.f };
+
+		glm::vec3 center() const {
+			return (min + max) * 0.5f;
+		}
+
+		glm::vec3 extents() const {
+			return (max - min) * 0.5f;
+		}
+	};
+
+	struct model;
+	using model_handle = containers::handle<model>;
+
+	// what a transform should be drawn with
+	struct render_ref {
+		model_handle model{};
+
+		// the node in 'data::scene' that follows this transform
+		scene_graph::node_id node = scene_graph::no_parent;
+	};
+
+	// a contiguous slice of the transform store.
+	// every pointer points at the first element of the slice; all arrays are 'count' long.
+	// this is what per-frame systems, worker threads and SIMD kernels should consume.
+	struct transform_range {
+		std::size_t first = 0;
+		std::size_t count = 0;
+
+		glm::vec3* positions = nullptr;
+		glm::vec3* scales = nullptr;
+		rotation_values* rotations = nullptr;
+
+		glm::vec3* last_positions = nullptr;
+		glm::vec3* last_scales = nullptr;
+		rotation_values* last_rotations = nullptr;
+		glm::vec3* forwards = nullptr;
+		glm::vec3* ups = nullptr;
+		glm::vec3* rights = nullptr;
+		glm::mat4* matrices = nullptr;
+		std::uint8_t* changed = nullptr;
+
+		bounds* local_bounds = nullptr;
+		render_ref* render_refs = nullptr;
+	};
+
+	// stores all transforms as a Structure of Arrays.
+	// hot data (position, rotation, scale) is kept apart from the orientation cache, the bounds and the render references,
+	// so a system only pulls the cache lines of the arrays it actually touches.
+	struct transform_store {
+
+		using transform_id = std::size_t;
+
+		static constexpr transform_id invalid_id = std::numeric_limits<transform_id>::max();
+
+		// adds a new transform and returns its id
+		transform_id create(const glm::vec3& position = {}, const glm::vec3& scale = { 1.f, 1.f, 1.f }, const rotation_values& rotation = {}) {
+
+			positions_.push_back(position);
+			scales_.push_back(scale);
+			rotations_.push_back(rotation);
+
+			last_positions_.push_back(position);
+			last_scales_.push_back(scale);
+			last_rotations_.push_back(rotation);
+
+			forwards_.emplace_back();
+			ups_.emplace_back();
+			rights_.emplace_back();
+			orientation_of(rotation, forwards_.back(), ups_.back(), rights_.back());
+
+			matrices_.push_back(matrix_of(position, scale, rotation));
+			changed_.push_back(1u);
+
+			bounds_.emplace_back();
+			render_refs_.emplace_back();
+
+			return positions_.size() - 1llu;
+		}
+
+		// reserve room for 'amount' transforms in every array
+		void reserve(std::size_t amount) {
+			positions_.reserve(amount);
+			scales_.reserve(amount);
+			rotations_.reserve(amount);
+			last_positions_.reserve(amount);
+			last_scales_.reserve(amount);
+			last_rotations_.reserve(amount);
+			forwards_.reserve(amount);
+			ups_.reserve(amount);
+			rights_.reserve(amount);
+			matrices_.reserve(amount);
+			changed_.reserve(amount);
+			bounds_.reserve(amount);
+			render_refs_.reserve(amount);
+		}
+
+		std::size_t size() const {
+			return positions_.size();
+		}
+
+		glm::vec3& position(transform_id id) { return positions_[id]; }
+		const glm::vec3& position(transform_id id) const { return positions_[id]; }
+
+		glm::vec3& scale(transform_id id) { return scales_[id]; }
+		const glm::vec3& scale(transform_id id) const { return scales_[id]; }
+
+		rotation_values& rotation(transform_id id) { return rotations_[id]; }
+		const rotation_values& rotation(transform_id id) const { return rotations_[id]; }
+
+		const glm::vec3& forward(transform_id id) const { return forwards_[id]; }
+		const glm::vec3& up(transform_id id) const { return ups_[id]; }
+		const glm::vec3& right(transform_id id) const { return rights_[id]; }
+
+		// returns the cached model matrix: translate * rotate y * rotate z * rotate x * scale
+		const glm::mat4& matrix(transform_id id) const { return matrices_[id]; }
+
+		// returns true when the inputs of the transform have changed since 'clear_changed' was last called for it
+		bool changed(transform_id id) const { return changed_[id] != 0u; }
+		void clear_changed(transform_id id) { changed_[id] = 0u; }
+
+		bounds& local_bounds(transform_id id) { return bounds_[id]; }
+		const bounds& local_bounds(transform_id id) const { return bounds_[id]; }
+
+		render_ref& render(transform_id id) { return render_refs_[id]; }
+		const render_ref& render(transform_id id) const { return render_refs_[id]; }
+
+		// returns a view on the transforms [first, first + count)
+		transform_range range(std::size_t first, std::size_t count) {
+			assert(first + count <= size());
+
+			transform_range r;
+			r.first = first;
+			r.count = count;
+			r.positions = positions_.data() + first;
+			r.scales = scales_.data() + first;
+			r.rotations = rotations_.data() + first;
+			r.last_positions = last_positions_.data() + first;
+			r.last_scales = last_scales_.data() + first;
+			r.last_rotations = last_rotations_.data() + first;
+			r.forwards = forwards_.data() + first;
+			r.ups = ups_.data() + first;
+			r.rights = rights_.data() + first;
+			r.matrices = matrices_.data() + first;
+			r.changed = changed_.data() + first;
+			r.local_bounds = bounds_.data() + first;
+			r.render_refs = render_refs_.data() + first;
+
+			return r;
+		}
+
+		// returns a view on all transforms
+		transform_range all() {
+			return range(0, size());
+		}
+
+		// splits the store into ranges of at most 'chunk_size' transforms and calls 'func' for each of them.
+		// the ranges never overlap, so they can be handed to different threads.
+		template<typename Callable>
+		void for_each_chunk(std::size_t chunk_size, Callable func) {
+			assert(chunk_size > 0);
+
+			for (std::size_t first = 0; first < size(); first += chunk_size) {
+				func(range(first, std::min(chunk_size, size() - first)));
+			}
+		}
+
+		// updates the cached orientation vectors and model matrix of a single transform.
+		// the update will only occur if the inputs have changed since last time.
+		void update(transform_id id) {
+			auto r = range(id, 1);
+			update(r);
+		}
+
+		// updates the 'forward', 'right' and 'up' vectors and the model matrix of every transform in 'r' of which the
+		// position, rotation or scale has changed, and flags those transforms as changed.
+		// the work is done by the batch kernels in 'transform_kernels.h', 4 transforms at a time.
+		static void update(transform_range& r) {
+
+			static_assert(sizeof(glm::vec3) == 3llu * sizeof(float), "the kernels expect tightly packed vectors");
+			static_assert(sizeof(rotation_values) == 3llu * sizeof(float), "the kernels expect tightly packed rotations");
+			static_assert(sizeof(glm::mat4) == 16llu * sizeof(float), "the kernels expect tightly packed matrices");
+
+			if (r.count == 0) {
+				return;
+			}
+
+			kernels::transform_arrays arrays;
+			arrays.count = r.count;
+			arrays.positions = &r.positions->x;
+			arrays.scales = &r.scales->x;
+			arrays.rotations = &r.rotations->angle_x;
+			arrays.last_positions = &r.last_positions->x;
+			arrays.last_scales = &r.last_scales->x;
+			arrays.last_rotations = &r.last_rotations->angle_x;
+			arrays.forwards = &r.forwards->x;
+			arrays.ups = &r.ups->x;
+			arrays.rights = &r.rights->x;
+			arrays.matrices = &(*r.matrices)[0][0];
+			arrays.changed = r.changed;
+
+			kernels::compose_transforms(arrays);
+		}
+
+		// calculates the 'forward', 'up' and 'right' vectors for the given rotation
+		static void orientation_of(const rotation_values& rotation, glm::vec3& forward, glm::vec3& up, glm::vec3& right) {
+
+			const glm::quat quat(
+				glm::vec3(
+					glm::radians(rotation.angle_x),
+					glm::radians(rotation.angle_y),
+					glm::radians(rotation.angle_z)
+				)
+			);
+
+			forward = quat * glm::vec3(0.f, 0.f, 1.f);
+			up = quat * glm::vec3(0.f, 1.f, 0.f);
+			right = quat * glm::vec3(1.f, 0.f, 0.f);
+		}
+
+		// calculates the model matrix for the given position, scale and rotation
+		static glm::mat4 matrix_of(const glm::vec3& position, const glm::vec3& scale, const rotation_values& rotation) {
+
+			auto translate	= glm::translate(glm::mat4(1.f), position);
+
+			auto rotate_y	= glm::rotate(translate, glm::radians(rotation.angle_y), glm::vec3(0.f, 1.f, 0.f));
+			auto rotate_z	= glm::rotate(rotate_y, glm::radians(rotation.angle_z), glm::vec3(0.f, 0.f, 1.f));
+			auto rotate_x	= glm::rotate(rotate_z, glm::radians(rotation.angle_x), glm::vec3(1.f, 0.f, 0.f));
+
+			return glm::scale(rotate_x, scale);
+		}
+
+	private:
+		// hot: written by gameplay code every frame
+		std::vector<glm::vec3> positions_;
+		std::vector<glm::vec3> scales_;
+		std::vector<rotation_values> rotations_;
+
+		// caches: only touched when an input changes
+		std::vector<glm::vec3> last_positions_;
+		std::vector<glm::vec3> last_scales_;
+		std::vector<rotation_values> last_rotations_;
+		std::vector<glm::vec3> forwards_;
+		std::vector<glm::vec3> ups_;
+		std::vector<glm::vec3> rights_;
+		std::vector<glm::mat4> matrices_;
+		std::vector<std::uint8_t> changed_;
+
+		// cold: set once at load time
+		std::vector<bounds> bounds_;
+		std::vector<render_ref> render_refs_;
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// stores the transforms of all models
+		transform_store transforms;
+	}
+	// ============================================================================================================================
+
+	// updates the cached orientation and model matrix of every transform that has changed since the last update,
+	// then pushes the new model matrices into the scene graph and recalculates the world matrices below them.
+	void update_transforms() {
+		PROFILE_ZONE("update_transforms");
+
+		auto all = data::transforms.all();
+		transform_store::update(all);
+
+		for (std::size_t i = 0; i < all.count; i++) {
+
+			if (all.changed[i] == 0u) {
+				continue;
+			}
+
+			// instances have no node, their matrix is read straight from the store
+			if (all.render_refs[i].node != scene_graph::no_parent) {
+				data::scene.set_local(all.render_refs[i].node, all.matrices[i]);
+			}
+
+			all.changed[i] = 0u;
+		}
+
+		data::scene.update();
+	}
+}
\ No newline at end of file
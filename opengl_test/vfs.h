@@ -0,0 +1,309 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+
+#include "print.h"
+#include "mapped_file.h"
+#include "asset_pack.h"
+#include "lz.h"
+#include "access_trace.h"
+
+// the files every loader reads through.
+// a path is looked up in the files mounted in memory, then in the mounted packs and only then on disk.
+namespace io {
+
+	// ============================================================================================================================
+	// DATA STRUCTS ===============================================================================================================
+
+	// the bytes of an opened file.
+	// views into a mapping or a decompressed buffer, which stay alive as long as any view of them does.
+	struct file_view {
+
+		const char* data() const {
+			return bytes_.data();
+		}
+
+		std::size_t size() const {
+			return bytes_.size();
+		}
+
+		std::string_view view() const {
+			return bytes_;
+		}
+
+		bool is_open() const {
+			return owner_ != nullptr || bytes_.data() != nullptr;
+		}
+
+		void close() {
+			bytes_ = {};
+			owner_.reset();
+		}
+
+		// views a whole buffer that has been read by hand, the view keeps the buffer alive
+		static file_view from_buffer(std::shared_ptr<const std::vector<char>> buffer) {
+			file_view output;
+			output.bytes_ = std::string_view(buffer->data(), buffer->size());
+			output.owner_ = std::move(buffer);
+			return output;
+		}
+
+	private:
+		std::string_view bytes_;
+		std::shared_ptr<const void> owner_;
+
+		friend bool open_mounted_file(std::string_view path, file_view& output);
+		friend bool open_file(std::string_view path, file_view& output);
+	};
+
+	// ============================================================================================================================
+	namespace data {
+		// files that live in memory instead of on disk
+		std::unordered_map<std::string, std::string_view> memory_files;
+
+		// mounted packs, the last mounted pack is searched first
+		std::vector<std::shared_ptr<const asset_pack>> packs;
+
+		std::shared_mutex mounts_mutex;
+
+		// files that were mapped from disk, shared by every reader so a file that is opened again is not mapped again
+		std::unordered_map<std::string, std::shared_ptr<const mapped_file>> mapped_files;
+		std::size_t mapped_bytes = 0llu;
+		std::mutex mapped_files_mutex;
+
+		// once more than this is mapped, files that are not read from anymore are unmapped
+		std::size_t max_mapped_bytes = 1llu << 30;
+	}
+	// ============================================================================================================================
+
+	// makes 'bytes' readable under 'path'.
+	// the memory is not copied, it has to stay alive until the file is unmounted.
+	void mount_memory_file(std::string_view path, std::string_view bytes) {
+		std::unique_lock lock(data::mounts_mutex);
+		data::memory_files[file_key(path)] = bytes;
+	}
+
+	void unmount_memory_file(std::string_view path) {
+		std::unique_lock lock(data::mounts_mutex);
+		data::memory_files.erase(file_key(path));
+	}
+
+	// maps the pack at 'path', its files hide files of the same name on disk and in packs mounted before it
+	bool mount_pack(const char* path) {
+
+		auto pack = std::make_shared<asset_pack>();
+		if (!pack->open(path)) {
+			return false;
+		}
+
+		print_info("Mounted pack ", path, " with ", pack->entries().size(), " files");
+
+		std::unique_lock lock(data::mounts_mutex);
+		data::packs.push_back(std::move(pack));
+		return true;
+	}
+
+	// unmounts every pack, files that are still open stay readable
+	void unmount_packs() {
+		std::unique_lock lock(data::mounts_mutex);
+		data::packs.clear();
+	}
+
+	// unmaps every file from disk nothing is reading from anymore
+	void release_mapped_files() {
+		std::lock_guard lock(data::mapped_files_mutex);
+
+		for (auto it = data::mapped_files.begin(); it != data::mapped_files.end();) {
+			if (it->second.use_count() == 1) {
+				data::mapped_bytes -= it->second->size();
+				it = data::mapped_files.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	// drops the cached mapping of the file at 'path', so the next read sees the file as it is on disk.
+	// has to be called before writing a file that may have been read, a mapped file can not be overwritten on every OS.
+	void release_mapped_file(std::string_view path) {
+		std::string key = file_key(path);
+
+		std::lock_guard lock(data::mapped_files_mutex);
+
+		auto found = data::mapped_files.find(key);
+		if (found != data::mapped_files.end()) {
+			data::mapped_bytes -= found->second->size();
+			data::mapped_files.erase(found);
+		}
+	}
+
+	// returns the mapping of the file at 'key' on disk, mapping it when it is not mapped yet
+	std::shared_ptr<const mapped_file> map_file(const std::string& key) {
+		{
+			std::lock_guard lock(data::mapped_files_mutex);
+
+			auto found = data::mapped_files.find(key);
+			if (found != data::mapped_files.end()) {
+				return found->second;
+			}
+		}
+
+		// map outside of the lock, two readers may map the same file at once but only one mapping is kept
+		auto file = std::make_shared<mapped_file>();
+		if (!file->open(key.c_str())) {
+			return nullptr;
+		}
+
+		bool over_budget;
+		std::shared_ptr<const mapped_file> result;
+		{
+			std::lock_guard lock(data::mapped_files_mutex);
+
+			auto [it, inserted] = data::mapped_files.emplace(key, std::move(file));
+			if (inserted) {
+				data::mapped_bytes += it->second->size();
+			}
+
+			result = it->second;
+			over_budget = data::mapped_bytes > data::max_mapped_bytes;
+		}
+
+		if (over_budget) {
+			release_mapped_files();
+		}
+
+		return result;
+	}
+
+	// returns true when a file can be opened at 'path'
+	bool file_exists(std::string_view path) {
+		std::string key = file_key(path);
+		{
+			std::shared_lock lock(data::mounts_mutex);
+
+			if (data::memory_files.count(key) != 0llu) {
+				return true;
+			}
+
+			for (const auto& pack : data::packs) {
+				if (pack->find(key) != nullptr) {
+					return true;
+				}
+			}
+		}
+
+		std::error_code error;
+		return std::filesystem::is_regular_file(key, error);
+	}
+
+	// returns the size of the file at 'path' without reading it, files in packs report their decompressed size.
+	// returns false when there is no such file.
+	bool file_size(std::string_view path, std::uint64_t& output) {
+		std::string key = file_key(path);
+		{
+			std::shared_lock lock(data::mounts_mutex);
+
+			auto found = data::memory_files.find(key);
+			if (found != data::memory_files.end()) {
+				output = found->second.size();
+				return true;
+			}
+
+			for (auto it = data::packs.rbegin(); it != data::packs.rend(); ++it) {
+				if (const pack_entry* entry = (*it)->find(key)) {
+					output = entry->size;
+					return true;
+				}
+			}
+		}
+
+		std::error_code error;
+		output = std::filesystem::file_size(key, error);
+		return !error;
+	}
+
+	// opens the file at 'path' when it is mounted in memory or in a pack, without going to the disk.
+	// returns false without an error when no mount holds the file.
+	bool open_mounted_file(std::string_view path, file_view& output) {
+
+		output.close();
+
+		std::string key = file_key(path);
+
+		std::shared_ptr<const asset_pack> pack;
+		const pack_entry* entry = nullptr;
+		{
+			std::shared_lock lock(data::mounts_mutex);
+
+			auto found = data::memory_files.find(key);
+			if (found != data::memory_files.end()) {
+				output.bytes_ = found->second;
+				return true;
+			}
+
+			for (auto it = data::packs.rbegin(); it != data::packs.rend() && entry == nullptr; ++it) {
+				entry = (*it)->find(key);
+				pack = *it;
+			}
+		}
+
+		if (entry == nullptr) {
+			return false;
+		}
+
+		record_access(pack->path(), entry->offset, entry->stored_size);
+
+		if (entry->compression == compression_none) {
+			output.bytes_ = pack->stored(*entry);
+			output.owner_ = pack->mapping();
+			return true;
+		}
+
+		auto buffer = std::make_shared<std::vector<char>>(entry->size);
+		std::string_view stored = pack->stored(*entry);
+
+		if (!lz::decompress(stored.data(), stored.size(), buffer->data(), buffer->size())) {
+			print_error("open_file corrupt entry ", std::string_view(key), " in pack: ", pack->path());
+			return false;
+		}
+
+		output.bytes_ = std::string_view(buffer->data(), buffer->size());
+		output.owner_ = std::move(buffer);
+		return true;
+	}
+
+	// opens the file at 'path' for reading.
+	// returns false without an error when there is no such file, so callers can probe for optional files.
+	bool open_file(std::string_view path, file_view& output) {
+
+		if (open_mounted_file(path, output)) {
+			return true;
+		}
+
+		std::string key = file_key(path);
+
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(key, error)) {
+			return false;
+		}
+
+		auto file = map_file(key);
+		if (file == nullptr) {
+			return false;
+		}
+
+		record_access(key, 0llu, file->size());
+
+		output.bytes_ = file->view();
+		output.owner_ = std::move(file);
+		return true;
+	}
+}
\ No newline at end of file
@@ -4,17 +4,29 @@
 #include <glm/ext/quaternion_common.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cassert>
+#include <limits>
 #include <array>
 #include <filesystem>
+#include <algorithm>
+#include <execution>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "print.h"
+#include "assimp_io.h"
 #include "image.h"
+#include "transforms.h"
+#include "scene_graph.h"
+#include "slot_map.h"
+#include "profiler.h"
+#include "render_stats.h"
 
 namespace world {
 
@@ -91,111 +103,348 @@ namespace world {
 		}
 	};
 
+	// describes a mesh in code, see 'create_model'.
+	// it is only used to fill a 'mesh_pool', the model does not keep it around.
+	struct mesh_data {
+		std::string name;
+		std::vector<vertex> verticies{};
+		std::vector<unsigned int> indices{};
+		std::vector<texture> textures{};
+	};
+
 	struct model;
+	struct mesh_pool;
+	struct obj_scene;
+	struct snapshot_model;
+
+	// a mesh is a range in the arenas of the 'mesh_pool' of its model.
+	// indices are relative to the first vertex of the mesh, draw with 'vertex_offset' as base vertex.
 	struct mesh {
 
-		mesh() = default;
-		mesh(
-			const std::string& name,
-			std::initializer_list<vertex> verticies,
-			std::initializer_list<unsigned int> indices,
-			std::initializer_list<texture> textures
-		) : name_(name), verticies_(verticies), indices_(indices), textures_(textures) { }
+		// return the id of the VAO: Vertex Array Objects, shared by all meshes of the model
+		const unsigned int& vao() const;
 
-		// return the id of this mesh's VAO: Vertex Array Objects
-		const unsigned int& vao() const {
-			return vao_;
-		}
+		// return the id of the VBO: Vertex Buffer Objects, shared by all meshes of the model
+		const unsigned int& vbo() const;
 
-		// return the id of this mesh's VBO: Vertex Buffer Objects
-		const unsigned int& vbo() const {
-			return vbo_;
-		}
-
-		// return the id of this mesh's EBO: Element Buffer Objects
-		const unsigned int& ebo() const {
-			return ebo_;
-		}
+		// return the id of the EBO: Element Buffer Objects, shared by all meshes of the model
+		const unsigned int& ebo() const;
 
 		// returns the name of this mesh
-		const std::string& name() const {
-			return name_;
+		std::string_view name() const;
+
+		// returns the node in 'data::scene' that places this mesh
+		const scene_graph::node_id& node() const {
+			return node_;
 		}
 
 		// returns the amount of verticies in this mesh
 		std::size_t vertex_size() const {
-			return verticies_.size();
+			return vertex_count_;
 		}
 
 		// returns the amount of indicies in this mesh
 		std::size_t index_size() const {
-			return indices_.size();
+			return index_count_;
 		}
 
-		// returns a const pointer to the first vertex of this mesh
-		const vertex* first_vertex() const {
-			return &verticies_[0];
+		// returns the position of the first vertex of this mesh in the vertex buffer of the model
+		std::size_t vertex_offset() const {
+			return vertex_offset_;
 		}
 
-		// returns a const pointer to the first index of this mesh
-		const unsigned int* first_index() const {
-			return &indices_[0];
+		// returns the position of the first index of this mesh in the index buffer of the model
+		std::size_t index_offset() const {
+			return index_offset_;
 		}
 
+		// returns a const pointer to the first vertex of this mesh
+		const vertex* first_vertex() const;
+
+		// returns a const pointer to the first index of this mesh
+		const unsigned int* first_index() const;
+
 		bool has_textures() const {
-			return !textures_.empty();
+			return texture_count_ != 0u;
 		}
 
 		template<typename Callable, std::enable_if_t<std::is_invocable<Callable, const std::size_t&, const texture&>::value, int> = 0>
-		void for_each_texture(Callable fn) const {
+		void for_each_texture(Callable fn) const;
+
+	private:
+		const mesh_pool* pool_ = nullptr;
 
-			for (std::size_t i = 0; i < textures_.size(); i++) {
-				const auto& ref = textures_.at(i);
+		std::uint32_t name_offset_ = 0u, name_length_ = 0u;
+		std::uint32_t vertex_offset_ = 0u, vertex_count_ = 0u;
+		std::uint32_t index_offset_ = 0u, index_count_ = 0u;
+		std::uint32_t texture_offset_ = 0u, texture_count_ = 0u;
 
-				fn(i, ref);
+		scene_graph::node_id node_ = scene_graph::no_parent;
+
+		friend mesh_pool;
+		friend void create_transform(model& for_model, model_handle handle);
+	};
+
+	// stores the verticies, indices, textures and names of all meshes of a model in one arena each.
+	// a model with many meshes therefore makes a handful of allocations instead of four per mesh,
+	// and is uploaded and drawn from a single set of buffers.
+	struct mesh_pool {
+
+		mesh_pool() = default;
+
+		// the GL objects belong to one pool, a pool can be moved but not copied
+		mesh_pool(const mesh_pool&) = delete;
+		mesh_pool& operator=(const mesh_pool&) = delete;
+
+		mesh_pool(mesh_pool&& other) noexcept
+			: verticies_(std::move(other.verticies_)), indices_(std::move(other.indices_)), textures_(std::move(other.textures_)),
+			names_(std::move(other.names_)), meshes_(std::move(other.meshes_)),
+			vao_(other.vao_), vbo_(other.vbo_), ebo_(other.ebo_)
+		{
+			other.vao_ = other.vbo_ = other.ebo_ = 0u;
+			relink();
+		}
+
+		mesh_pool& operator=(mesh_pool&& other) noexcept {
+			if (this != &other) {
+				verticies_ = std::move(other.verticies_);
+				indices_ = std::move(other.indices_);
+				textures_ = std::move(other.textures_);
+				names_ = std::move(other.names_);
+				meshes_ = std::move(other.meshes_);
+
+				// the buffers of this pool would be lost otherwise
+				release();
+
+				vao_ = other.vao_;
+				vbo_ = other.vbo_;
+				ebo_ = other.ebo_;
+				other.vao_ = other.vbo_ = other.ebo_ = 0u;
+
+				relink();
 			}
+
+			return *this;
 		}
 
-	private:
-		std::string name_;
-		std::vector<vertex> verticies_{};
-		std::vector<unsigned int> indices_{};
-		std::vector<texture> textures_{};
+		// deletes the buffers of the pool, the meshes are kept and 'setup_pool' uploads them again.
+		// the buffers are not deleted with the pool, the context may be gone by then.
+		void release() {
+			if (vao_ != 0u) {
+				glDeleteVertexArrays(1, &vao_);
+				glDeleteBuffers(1, &vbo_);
+				glDeleteBuffers(1, &ebo_);
+				vao_ = vbo_ = ebo_ = 0u;
+			}
+		}
 
-		unsigned int vao_, vbo_, ebo_;
+		// reserves every arena up front, so filling the pool does not reallocate
+		void reserve(std::size_t mesh_amount, std::size_t vertex_amount, std::size_t index_amount, std::size_t texture_amount, std::size_t name_length) {
+			meshes_.reserve(mesh_amount);
+			verticies_.reserve(vertex_amount);
+			indices_.reserve(index_amount);
+			textures_.reserve(texture_amount);
+			names_.reserve(name_length);
+		}
 
-		friend void load_textures(const aiMesh* mesh_ptr, const aiScene* scene_ptr, mesh& into_mesh, const model& into_model);
-		friend void load_mesh(const aiMesh* mesh_ptr, const aiScene* scene_ptr, mesh& into_mesh, const model& into_model);
-		friend void load_node(const aiNode* node_ptr, const aiScene* scene_ptr, model& into_model);
-		friend void setup_mesh(world::mesh& mesh);
-	};
+		// starts a new mesh at the end of the arenas.
+		// everything added with 'add_vertex', 'add_index' and 'add_texture' until the next call belongs to it.
+		mesh& add_mesh(std::string_view name, scene_graph::node_id node = scene_graph::no_parent) {
+
+			mesh& new_mesh = meshes_.emplace_back();
+			new_mesh.pool_ = this;
+			new_mesh.name_offset_ = static_cast<std::uint32_t>(names_.size());
+			new_mesh.name_length_ = static_cast<std::uint32_t>(name.size());
+			new_mesh.vertex_offset_ = static_cast<std::uint32_t>(verticies_.size());
+			new_mesh.index_offset_ = static_cast<std::uint32_t>(indices_.size());
+			new_mesh.texture_offset_ = static_cast<std::uint32_t>(textures_.size());
+			new_mesh.node_ = node;
+
+			names_.append(name);
+
+			return new_mesh;
+		}
+
+		// adds a complete mesh
+		mesh& add_mesh(const mesh_data& data, scene_graph::node_id node = scene_graph::no_parent) {
+
+			mesh& new_mesh = add_mesh(data.name, node);
+
+			verticies_.insert(verticies_.end(), data.verticies.begin(), data.verticies.end());
+			indices_.insert(indices_.end(), data.indices.begin(), data.indices.end());
+			textures_.insert(textures_.end(), data.textures.begin(), data.textures.end());
+
+			new_mesh.vertex_count_ = static_cast<std::uint32_t>(data.verticies.size());
+			new_mesh.index_count_ = static_cast<std::uint32_t>(data.indices.size());
+			new_mesh.texture_count_ = static_cast<std::uint32_t>(data.textures.size());
+
+			return new_mesh;
+		}
 
-	struct rotation_values {
-		float angle_x = 0.f;
-		float angle_y = 0.f;
-		float angle_z = 0.f;
+		// adds a mesh that draws the verticies, indices and textures of the mesh at 'source_index'.
+		// the geometry is stored once, no matter how many nodes place it.
+		mesh& add_shared_mesh(std::size_t source_index, std::string_view name, scene_graph::node_id node = scene_graph::no_parent) {
+			assert(source_index < meshes_.size());
 
-		bool operator==(const rotation_values& rhs) const {
-			return angle_x == rhs.angle_x
-				&& angle_y == rhs.angle_y
-				&& angle_z == rhs.angle_z;
+			mesh source = meshes_[source_index];
+			mesh& new_mesh = add_mesh(name, node);
+
+			new_mesh.vertex_offset_ = source.vertex_offset_;
+			new_mesh.vertex_count_ = source.vertex_count_;
+			new_mesh.index_offset_ = source.index_offset_;
+			new_mesh.index_count_ = source.index_count_;
+			new_mesh.texture_offset_ = source.texture_offset_;
+			new_mesh.texture_count_ = source.texture_count_;
+
+			return new_mesh;
 		}
 
-		bool operator!=(const rotation_values& rhs) const {
-			return angle_x != rhs.angle_x
-				|| angle_y != rhs.angle_y
-				|| angle_z != rhs.angle_z;
+		// adds a vertex to the last mesh
+		vertex& add_vertex() {
+			assert(!meshes_.empty());
+
+			meshes_.back().vertex_count_++;
+			return verticies_.emplace_back();
+		}
+
+		// adds 'amount' verticies to the last mesh and returns the first of them, so they can be filled in place
+		vertex* add_verticies(std::size_t amount) {
+			assert(!meshes_.empty());
+
+			meshes_.back().vertex_count_ += static_cast<std::uint32_t>(amount);
+			verticies_.resize(verticies_.size() + amount);
+
+			return verticies_.data() + verticies_.size() - amount;
 		}
+
+		// adds 'amount' indices to the last mesh and returns the first of them, so they can be filled in place
+		unsigned int* add_indices(std::size_t amount) {
+			assert(!meshes_.empty());
+
+			meshes_.back().index_count_ += static_cast<std::uint32_t>(amount);
+			indices_.resize(indices_.size() + amount);
+
+			return indices_.data() + indices_.size() - amount;
+		}
+
+		// adds an index to the last mesh, relative to its first vertex
+		void add_index(unsigned int index) {
+			assert(!meshes_.empty());
+
+			meshes_.back().index_count_++;
+			indices_.push_back(index);
+		}
+
+		// adds a texture to the last mesh
+		void add_texture(const texture& tex) {
+			assert(!meshes_.empty());
+
+			meshes_.back().texture_count_++;
+			textures_.push_back(tex);
+		}
+
+		std::size_t size() const {
+			return meshes_.size();
+		}
+
+		const std::vector<vertex>& verticies() const {
+			return verticies_;
+		}
+
+		const std::vector<unsigned int>& indices() const {
+			return indices_;
+		}
+
+		const std::vector<texture>& textures() const {
+			return textures_;
+		}
+
+		const std::string& names() const {
+			return names_;
+		}
+
+		std::vector<mesh>::const_iterator begin() const {
+			return meshes_.begin();
+		}
+
+		std::vector<mesh>::const_iterator end() const {
+			return meshes_.end();
+		}
+
+		std::vector<mesh>::iterator begin() {
+			return meshes_.begin();
+		}
+
+		std::vector<mesh>::iterator end() {
+			return meshes_.end();
+		}
+
+		const unsigned int& vao() const {
+			return vao_;
+		}
+
+		const unsigned int& vbo() const {
+			return vbo_;
+		}
+
+		const unsigned int& ebo() const {
+			return ebo_;
+		}
+
+	private:
+		// the meshes point back at the pool they are stored in
+		void relink() {
+			for (auto& mesh : meshes_) {
+				mesh.pool_ = this;
+			}
+		}
+
+		std::vector<vertex> verticies_;
+		std::vector<unsigned int> indices_;
+		std::vector<texture> textures_;
+		std::string names_;
+
+		std::vector<mesh> meshes_;
+
+		unsigned int vao_ = 0u, vbo_ = 0u, ebo_ = 0u;
+
+		friend void setup_pool(mesh_pool& pool);
 	};
 
-	struct model {
+	inline const unsigned int& mesh::vao() const { return pool_->vao(); }
+	inline const unsigned int& mesh::vbo() const { return pool_->vbo(); }
+	inline const unsigned int& mesh::ebo() const { return pool_->ebo(); }
+
+	inline std::string_view mesh::name() const {
+		return std::string_view(pool_->names()).substr(name_offset_, name_length_);
+	}
+
+	inline const vertex* mesh::first_vertex() const {
+		return pool_->verticies().data() + vertex_offset_;
+	}
+
+	inline const unsigned int* mesh::first_index() const {
+		return pool_->indices().data() + index_offset_;
+	}
+
+	template<typename Callable, std::enable_if_t<std::is_invocable<Callable, const std::size_t&, const texture&>::value, int>>
+	void mesh::for_each_texture(Callable fn) const {
 
-		glm::vec3 position{ 0.f, 0.f,0.f };
-		glm::vec3 scale{ 1.f, 1.f, 1.f };
-		rotation_values rotation{};
+		const texture* first = pool_->textures().data() + texture_offset_;
+
+		for (std::size_t i = 0; i < texture_count_; i++) {
+			fn(i, first[i]);
+		}
+	}
+
+	struct model {
 
 		model() = default;
-		model(std::initializer_list<mesh> meshes) : meshes(meshes) {}
+		model(std::initializer_list<mesh_data> meshes) {
+			for (const auto& data : meshes) {
+				meshes_.add_mesh(data);
+			}
+		}
 
 		// the id of the shader this model uses;
 		unsigned int shader_id = 0;
@@ -210,96 +459,138 @@ namespace world {
 			return path_to_file_;
 		}
 
-		// updates the 'forward', 'right' and 'up' vectors.
-		// the update will only occus if the value of 'rotation' has changed since last time;
-		void update_orientation() {
+		// returns the id of the transform of this model in 'data::transforms'
+		const transform_store::transform_id& transform() const {
+			return transform_;
+		}
 
-			if (rotation != last_rotation) {
+		// returns the root node of this model in 'data::scene', every mesh node is placed below it
+		const scene_graph::node_id& root_node() const {
+			return root_node_;
+		}
 
-				const glm::quat quat(
-					glm::vec3(
-						glm::radians(rotation.angle_x),
-						glm::radians(rotation.angle_y),
-						glm::radians(rotation.angle_z)
-					)
-				);
+		glm::vec3& position() { return data::transforms.position(transform_); }
+		const glm::vec3& position() const { return data::transforms.position(transform_); }
 
-				forward_ = quat * glm::vec3(0.f, 0.f, 1.f);
-				up_ = quat * glm::vec3(0.f, 1.f, 0.f);
-				right_ = quat * glm::vec3(1.f, 0.f, 0.f);
+		glm::vec3& scale() { return data::transforms.scale(transform_); }
+		const glm::vec3& scale() const { return data::transforms.scale(transform_); }
 
-				last_rotation = rotation;
-			}
+		rotation_values& rotation() { return data::transforms.rotation(transform_); }
+		const rotation_values& rotation() const { return data::transforms.rotation(transform_); }
+
+		// returns the bounding box of all meshes of this model, in model space
+		const bounds& local_bounds() const {
+			return data::transforms.local_bounds(transform_);
+		}
+
+		// returns the ASSIMP post processing flags the model was loaded with, 0 for a model that was not loaded from a file
+		unsigned int load_flags() const {
+			return load_flags_;
+		}
+
+		// returns true while the meshes of this model are still loading, it is drawn as its bounding box until then
+		bool is_placeholder() const {
+			return placeholder_;
+		}
+
+		// updates the 'forward', 'right' and 'up' vectors and the model matrix.
+		// the update will only occus if the value of 'position', 'rotation' or 'scale' has changed since last time;
+		// use 'world::update_transforms' to update all models and their nodes at once.
+		void update_orientation() {
+			data::transforms.update(transform_);
 		}
 
 		// Returns the current forward facing vector.
 		// Be sure to call 'update_orientation' to update this vector according to the current rotation.
 		const glm::vec3& forward() const {
-			return forward_;
+			return data::transforms.forward(transform_);
 		}
 
 		// Returns the current right facing vector.
 		// Be sure to call 'update_orientation' to update this vector according to the current rotation.
 		const glm::vec3& right() const {
-			return right_;
+			return data::transforms.right(transform_);
 		}
 
 		// Returns the current up facing vector.
 		// Be sure to call 'update_orientation' to update this vector according to the current rotation.
 		const glm::vec3& up() const {
-			return up_;
+			return data::transforms.up(transform_);
 		}
 
 		template<typename Callable>
 		void for_each_mesh(Callable func) const {
-			for (std::size_t i = 0; i < meshes.size(); i++) {
-				const auto& ref = meshes.at(i);
-				func(i, ref);
+			std::size_t i = 0;
+			for (const auto& ref : meshes_) {
+				func(i++, ref);
 			}
 		}
 
+		// returns the pool that holds the data of every mesh of this model
+		const mesh_pool& meshes() const {
+			return meshes_;
+		}
+
 		std::vector<mesh>::const_iterator begin() const {
-			return meshes.begin();
+			return meshes_.begin();
 		}
 
 		std::vector<mesh>::const_iterator end() const {
-			return meshes.end();
+			return meshes_.end();
 		}
 
 		std::vector<mesh>::iterator begin() {
-			return meshes.begin();
+			return meshes_.begin();
 		}
 
 		std::vector<mesh>::iterator end() {
-			return meshes.end();
+			return meshes_.end();
 		}
 
 		std::size_t meshes_size() const {
-			return meshes.size();
+			return meshes_.size();
 		}
 
 	private:
 		unsigned int id_ = 0;
 		std::string path_to_file_ = "";
+		unsigned int load_flags_ = 0u;
 
-		glm::vec3 up_{ 0.f, 1.f, 0.f };
-		glm::vec3 forward_{ 0.f, 0.f, 1.f };
-		glm::vec3 right_{ 1.f, 0.f, 0.f };
+		transform_store::transform_id transform_ = transform_store::invalid_id;
+		scene_graph::node_id root_node_ = scene_graph::no_parent;
 
-		rotation_values last_rotation{};
+		mesh_pool meshes_;
 
-		std::vector<mesh> meshes;
+		bool placeholder_ = false;
 
-		friend bool load_model(std::size_t& model_index, const char * path, unsigned int load_flags);
-		friend void load_node(const aiNode* node_ptr, const aiScene* scene_ptr, model& into_model);
+		friend void load_textures(const aiMesh* mesh_ptr, const aiScene* scene_ptr, model& into_model);
+		friend void load_mesh(const aiMesh* mesh_ptr, const aiScene* scene_ptr, model& into_model);
+		friend bool load_model(model_handle& handle, const aiScene* scene, const char* path, unsigned int load_flags);
+		friend bool load_obj(model_handle& handle, obj_scene& scene, const char* path, unsigned int load_flags);
+		friend bool load_gltf(model_handle& handle, const char* path);
+		friend void load_node(const aiNode* node_ptr, const aiScene* scene_ptr, model& into_model, scene_graph::node_id parent, std::vector<std::size_t>& converted);
 
-		template<typename ... Args> friend void create_model(std::size_t& model_index, Args&& ... args);
+		template<typename ... Args> friend void create_model(model_handle& handle, Args&& ... args);
+		friend void create_transform(model& for_model, model_handle handle);
+		friend void calculate_bounds(const model& for_model);
+		friend void setup_model(model_handle handle);
+		friend void create_placeholder(model_handle& handle, const char* path, const bounds& box, unsigned int load_flags);
+		friend void fill_obj_model(model& into_model, obj_scene& scene);
+		friend void restore_model(const snapshot_model& record, model_handle& handle);
+	};
+
+	// refers to a mesh of a model.
+	// meshes are owned by their model, so the model handle validates the mesh handle.
+	struct mesh_handle {
+		model_handle model{};
+		std::uint32_t index = 0u;
 	};
 
 	// ============================================================================================================================
 	namespace data {
-		// stores all models that have been loaded
-		std::vector<model> loaded_models;
+		// stores all models that have been loaded.
+		// models never move once loaded, a 'model_handle' can be kept around and checked for validity.
+		containers::slot_map<model> loaded_models;
 	}
 	// ============================================================================================================================
 
@@ -307,7 +598,8 @@ namespace world {
 
 	// ============================================================================================================================
 
-	void load_textures(const aiMesh* mesh_ptr, const aiScene* scene_ptr, mesh& into_mesh, const model& into_model) {
+	// adds the textures of 'mesh_ptr' to the last mesh of 'into_model'
+	void load_textures(const aiMesh* mesh_ptr, const aiScene* scene_ptr, model& into_model) {
 		aiMaterial* material = scene_ptr->mMaterials[mesh_ptr->mMaterialIndex];
 
 		auto tex_num = scene_ptr->mNumTextures;
@@ -330,23 +622,22 @@ namespace world {
 			bool was_loaded = opengl::image::load(texture_id, text_path.generic_string().c_str(), name.c_str());
 
 			if (was_loaded) {
-				into_mesh.textures_.emplace_back(texture_id, texture_type::diffuse_texture);
+				into_model.meshes_.add_texture(texture(texture_id, texture_type::diffuse_texture));
 			}
 		}
 	}
 
-	void load_mesh(const aiMesh* mesh_ptr, const aiScene* scene_ptr, mesh& into_mesh, const model& into_model) {
+	// adds the verticies, indices and textures of 'mesh_ptr' to the last mesh of 'into_model'
+	void load_mesh(const aiMesh* mesh_ptr, const aiScene* scene_ptr, model& into_model) {
 		if (mesh_ptr == nullptr) {
 			return;
 		}
 
-		load_textures(mesh_ptr, scene_ptr, into_mesh, into_model);
+		load_textures(mesh_ptr, scene_ptr, into_model);
 
 		for (unsigned int i = 0; i < mesh_ptr->mNumVertices; i++)
 		{
-			into_mesh.verticies_.emplace_back(vertex());
-
-			vertex& vert = into_mesh.verticies_[into_mesh.verticies_.size() - 1llu];
+			vertex& vert = into_model.meshes_.add_vertex();
 
 			if (mesh_ptr->HasPositions()) {
 				vert.position.x = mesh_ptr->mVertices[i].x;
@@ -387,92 +678,275 @@ namespace world {
 			aiFace& face = mesh_ptr->mFaces[i];
 
 			for (unsigned int y = 0; y < face.mNumIndices; y++) {
-				into_mesh.indices_.push_back(face.mIndices[y]);
+				into_model.meshes_.add_index(face.mIndices[y]);
 			}
 		}
 	}
 
-	void load_node(const aiNode* node_ptr, const aiScene* scene_ptr, model& into_model) {
+	// converts a row major ASSIMP matrix to a column major glm matrix
+	glm::mat4 to_mat4(const aiMatrix4x4& matrix) {
+		return glm::transpose(glm::make_mat4(&matrix.a1));
+	}
+
+	// what the meshes of a model need in every arena of its 'mesh_pool'
+	struct mesh_pool_size {
+		std::size_t meshes = 0;
+		std::size_t verticies = 0;
+		std::size_t indices = 0;
+		std::size_t textures = 0;
+		std::size_t name_length = 0;
+	};
+
+	// sums up the meshes placed by 'node_ptr' and its children, so the pool can be reserved before loading.
+	// 'counted' flags the ASSIMP meshes of which the geometry has been counted, a mesh placed by multiple nodes is stored once.
+	void count_node(const aiNode* node_ptr, const aiScene* scene_ptr, mesh_pool_size& size, std::vector<bool>& counted) {
 		if (node_ptr == nullptr) {
 			return;
 		}
 
 		for (unsigned int i = 0; i < node_ptr->mNumMeshes; i++)
 		{
-			into_model.meshes.emplace_back(mesh());
-			mesh& mesh = into_model.meshes[into_model.meshes.size() - 1llu];
-			mesh.name_ = node_ptr->mName.C_Str();
+			unsigned int mesh_index = node_ptr->mMeshes[i];
+			const aiMesh* mesh_ptr = scene_ptr->mMeshes[mesh_index];
+
+			size.meshes++;
+			size.name_length += node_ptr->mName.length;
+
+			if (counted[mesh_index]) {
+				continue;
+			}
+
+			counted[mesh_index] = true;
+			size.verticies += mesh_ptr->mNumVertices;
+			size.textures += scene_ptr->mMaterials[mesh_ptr->mMaterialIndex]->GetTextureCount(aiTextureType::aiTextureType_DIFFUSE);
+
+			for (unsigned int y = 0; y < mesh_ptr->mNumFaces; y++) {
+				size.indices += mesh_ptr->mFaces[y].mNumIndices;
+			}
+		}
+
+		for (unsigned int i = 0; i < node_ptr->mNumChildren; i++)
+		{
+			count_node(node_ptr->mChildren[i], scene_ptr, size, counted);
+		}
+	}
+
+	// the mesh in the pool of a model that first converted an ASSIMP mesh, indexed by the ASSIMP mesh index
+	using converted_meshes = std::vector<std::size_t>;
+
+	constexpr std::size_t not_converted = std::numeric_limits<std::size_t>::max();
+
+	void load_node(const aiNode* node_ptr, const aiScene* scene_ptr, model& into_model, scene_graph::node_id parent, converted_meshes& converted) {
+		if (node_ptr == nullptr) {
+			return;
+		}
+
+		auto node = data::scene.add_node(parent, to_mat4(node_ptr->mTransformation));
+		auto name = std::string_view(node_ptr->mName.data, node_ptr->mName.length);
 
+		for (unsigned int i = 0; i < node_ptr->mNumMeshes; i++)
+		{
 			unsigned int mesh_index = node_ptr->mMeshes[i];
+
+			// nodes that place a mesh that has already been converted share its geometry
+			if (converted[mesh_index] != not_converted) {
+				into_model.meshes_.add_shared_mesh(converted[mesh_index], name, node);
+				continue;
+			}
+
+			converted[mesh_index] = into_model.meshes_.size();
+			into_model.meshes_.add_mesh(name, node);
+
 			aiMesh* mesh_ptr = scene_ptr->mMeshes[mesh_index];
 
-			load_mesh(mesh_ptr, scene_ptr, mesh, into_model);
+			load_mesh(mesh_ptr, scene_ptr, into_model);
 		}
 
 		for (unsigned int i = 0; i < node_ptr->mNumChildren; i++)
 		{
-			load_node(node_ptr->mChildren[i], scene_ptr, into_model);
+			load_node(node_ptr->mChildren[i], scene_ptr, into_model, node, converted);
+		}
+	}
+
+	// creates the transform and the root node of a model.
+	// meshes that have not been placed by a node are attached to the root node.
+	void create_transform(model& for_model, model_handle handle) {
+
+		for_model.transform_ = data::transforms.create();
+		for_model.root_node_ = data::scene.add_node(scene_graph::no_parent, data::transforms.matrix(for_model.transform_));
+
+		render_ref& ref = data::transforms.render(for_model.transform_);
+		ref.model = handle;
+		ref.node = for_model.root_node_;
+
+		for (auto& mesh : for_model) {
+			if (mesh.node_ == scene_graph::no_parent) {
+				mesh.node_ = for_model.root_node_;
+			}
+		}
+	}
+
+	// calculates the bounding box of all meshes of a model, in model space.
+	// the world matrices of its nodes have to be up to date with the matrix of its root node.
+	void calculate_bounds(const model& for_model) {
+
+		bounds& box = data::transforms.local_bounds(for_model.transform_);
+		bool first = true;
+
+		// the model may already have been moved, like a placeholder that is filled in
+		glm::mat4 to_model = glm::inverse(data::scene.world(for_model.root_node_));
+
+		for (const auto& mesh : for_model) {
+
+			const glm::mat4 node_matrix = to_model * data::scene.world(mesh.node());
+
+			for (std::size_t i = 0; i < mesh.vertex_size(); i++) {
+				glm::vec3 position = node_matrix * glm::vec4(mesh.first_vertex()[i].position, 1.f);
+
+				box.min = first ? position : glm::min(box.min, position);
+				box.max = first ? position : glm::max(box.max, position);
+				first = false;
+			}
 		}
 	}
 
-	// loads a Model using ASSIMP, returns the Index of the loaded model
-	bool load_model(std::size_t& model_index, const char * path, unsigned int load_flags = default_load_flags) {
-		Assimp::Importer importer;
+	// imports the file at 'path' with an importer of the pool, without touching any GL state or global data.
+	// can be called from any thread, the scene stays alive until 'importer' is released.
+	bool import_model(io::importer_lease& importer, const char* path, unsigned int load_flags = default_load_flags) {
+		PROFILE_ZONE("import_model");
 
-		const aiScene* scene = importer.ReadFile(path, load_flags);
+		importer = io::data::importers.acquire();
+
+		const aiScene* scene = importer->ReadFile(path, load_flags);
 
 		if (scene == nullptr || scene->mRootNode == nullptr || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) {
-			print_error("loading model failed: ", importer.GetErrorString());
+			print_error("loading model failed: ", importer->GetErrorString());
 
-			importer.FreeScene();
+			importer.release();
 			return false;
 		}
 
-		data::loaded_models.push_back({});
+		return true;
+	}
+
+	// builds a model from a scene imported from 'path' with 'load_flags', returns the handle of the loaded model.
+	// loads the textures of the model, so it has to be called on the thread that owns the GL context.
+	bool load_model(model_handle& handle, const aiScene* scene, const char* path, unsigned int load_flags = default_load_flags) {
+		PROFILE_ZONE("load_model");
 
-		auto index = data::loaded_models.size() - 1llu;
+		auto new_handle = data::loaded_models.emplace();
 
-		model& model_ref = data::loaded_models[index];
-		model_ref.id_ = static_cast<unsigned int>(index);
+		model& model_ref = data::loaded_models.at(new_handle);
+		model_ref.id_ = new_handle.index;
 		model_ref.path_to_file_ = path;
+		model_ref.load_flags_ = load_flags;
 
-		load_node(scene->mRootNode, scene, model_ref);
+		mesh_pool_size pool_size;
+		std::vector<bool> counted(scene->mNumMeshes, false);
+		count_node(scene->mRootNode, scene, pool_size, counted);
+		model_ref.meshes_.reserve(pool_size.meshes, pool_size.verticies, pool_size.indices, pool_size.textures, pool_size.name_length);
 
-		model_index = index;
+		create_transform(model_ref, new_handle);
+		converted_meshes converted(scene->mNumMeshes, not_converted);
+		load_node(scene->mRootNode, scene, model_ref, model_ref.root_node_, converted);
+		calculate_bounds(model_ref);
 
-		importer.FreeScene();
+		handle = new_handle;
 		return true;
 	}
 
+	// loads a Model using ASSIMP, returns the handle of the loaded model
+	bool load_model(model_handle& handle, const char * path, unsigned int load_flags = default_load_flags) {
+		io::importer_lease importer;
+
+		if (!import_model(importer, path, load_flags)) {
+			return false;
+		}
+
+		return load_model(handle, importer->GetScene(), path, load_flags);
+	}
+
+	// loads several models at once, the files are imported in parallel and then built one after the other.
+	// 'handles' gets one handle per path, returns false when any of the models could not be loaded.
+	bool load_models(std::vector<model_handle>& handles, const std::vector<const char*>& paths, unsigned int load_flags = default_load_flags) {
+
+		std::vector<io::importer_lease> importers(paths.size());
+		std::vector<char> imported(paths.size(), 0);
+
+		std::vector<std::size_t> order(paths.size());
+		for (std::size_t i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+
+		std::for_each(std::execution::par, order.begin(), order.end(), [&](std::size_t i) {
+			imported[i] = import_model(importers[i], paths[i], load_flags);
+		});
+
+		bool all_loaded = true;
+		handles.assign(paths.size(), model_handle{});
+
+		for (std::size_t i = 0; i < paths.size(); i++) {
+			all_loaded = imported[i] && load_model(handles[i], importers[i]->GetScene(), paths[i], load_flags) && all_loaded;
+
+			// hand the importer back as soon as its scene is converted
+			importers[i].release();
+		}
+
+		return all_loaded;
+	}
+
 	template<typename ... Args>
-	void create_model(std::size_t& model_index, Args&& ... args) {
+	void create_model(model_handle& handle, Args&& ... args) {
+
+		auto new_handle = data::loaded_models.emplace(std::forward<Args>(args)...);
+
+		model& model_ref = data::loaded_models.at(new_handle);
+		model_ref.id_ = new_handle.index;
+		create_transform(model_ref, new_handle);
+		calculate_bounds(model_ref);
+
+		handle = new_handle;
+	}
+
+	// creates a model without meshes that stands in for a model that is still loading.
+	// it can be placed, instanced and followed like any other model and is drawn as 'box' until its meshes are filled in.
+	void create_placeholder(model_handle& handle, const char* path, const bounds& box, unsigned int load_flags = default_load_flags) {
 
-		data::loaded_models.emplace_back<model>(std::forward<Args>(args)...);
-		auto index = data::loaded_models.size() - 1llu;
+		auto new_handle = data::loaded_models.emplace();
+
+		model& model_ref = data::loaded_models.at(new_handle);
+		model_ref.id_ = new_handle.index;
+		model_ref.path_to_file_ = path;
+		model_ref.load_flags_ = load_flags;
+		model_ref.placeholder_ = true;
 
-		model& model_ref = data::loaded_models[index];
-		model_ref.id_ = static_cast<unsigned int>(index);
+		create_transform(model_ref, new_handle);
+		data::transforms.local_bounds(model_ref.transform_) = box;
 
-		model_index = index;
+		handle = new_handle;
 	}
 
-	void setup_mesh(world::mesh& mesh) {
+	// uploads the arenas of a pool into one VBO and one EBO, described by one VAO
+	void setup_pool(mesh_pool& pool) {
+		PROFILE_ZONE("setup_pool");
 
 		// create all the buffers needed to store our mesh data
 		// VAO: Vertex Array Objects
 		// VBO: Vertex Buffer Objects
 		// EBO: Element Buffer Objects
-		glGenVertexArrays(1, &mesh.vao_);
-		glGenBuffers(1, &mesh.vbo_);
-		glGenBuffers(1, &mesh.ebo_);
+		glGenVertexArrays(1, &pool.vao_);
+		glGenBuffers(1, &pool.vbo_);
+		glGenBuffers(1, &pool.ebo_);
 
-		glBindVertexArray(mesh.vao_);
+		glBindVertexArray(pool.vao_);
 
-		glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo_);
-		glNamedBufferData(mesh.vbo_, mesh.vertex_size() * sizeof(world::vertex), mesh.first_vertex(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, pool.vbo_);
+		glNamedBufferData(pool.vbo_, pool.verticies_.size() * sizeof(world::vertex), pool.verticies_.data(), GL_STATIC_DRAW);
+		render_stats::count_buffer_upload(pool.verticies_.size() * sizeof(world::vertex));
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo_);
-		glNamedBufferData(mesh.ebo_, mesh.index_size() * sizeof(unsigned int), mesh.first_index(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.ebo_);
+		glNamedBufferData(pool.ebo_, pool.indices_.size() * sizeof(unsigned int), pool.indices_.data(), GL_STATIC_DRAW);
+		render_stats::count_buffer_upload(pool.indices_.size() * sizeof(unsigned int));
 
 		constexpr auto vertex_info = world::vertex_info;
 		constexpr auto size = world::size_of<world::vertex, GLsizei>;
@@ -488,23 +962,47 @@ namespace world {
 		glBindVertexArray(0);
 	}
 
-	model& model_get(std::size_t model_index) {
-		return data::loaded_models.at(model_index);
+	// returns the model 'handle' refers to, throws std::out_of_range when it is not loaded anymore
+	model& model_get(model_handle handle) {
+		return data::loaded_models.at(handle);
 	}
 
-	void setup_model(std::size_t model_index) {
-		world::model& model = world::model_get(model_index);
+	// returns true when 'handle' refers to a model that is still loaded
+	bool model_valid(model_handle handle) {
+		return data::loaded_models.valid(handle);
+	}
+
+	// returns the mesh 'handle' refers to, or nullptr when its model is gone or it has no such mesh
+	const mesh* mesh_get(const mesh_handle& handle) {
+		const model* model_ptr = data::loaded_models.get(handle.model);
 
-		for (auto & mesh : model) {
-			setup_mesh(mesh);
+		if (model_ptr == nullptr || handle.index >= model_ptr->meshes_size()) {
+			return nullptr;
 		}
+
+		return &*(model_ptr->begin() + handle.index);
 	}
 
-	void model_set_shader(std::size_t model_index, unsigned int shader_id) {
+	void setup_model(model_handle handle) {
+		world::model& model = world::model_get(handle);
+		setup_pool(model.meshes_);
+	}
+
+	void model_set_shader(model_handle handle, unsigned int shader_id) {
 
-		model& model_ref = data::loaded_models.at(model_index);
+		model& model_ref = data::loaded_models.at(handle);
 		model_ref.shader_id = shader_id;
 	}
 
+	void model_set_shader(model_handle handle, shader::program_handle program) {
+
+		if (const auto* program_ptr = shader::program_get(program)) {
+			model_set_shader(handle, program_ptr->id);
+		}
+		else {
+			print_error("model_set_shader Unknown program handle: ", program.index);
+		}
+	}
+
 	
 }
\ No newline at end of file